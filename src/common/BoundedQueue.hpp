@@ -0,0 +1,144 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: BoundedQueue.hpp                                                 ///
+/// @brief: Lock-free fixed capacity queue for any number of producers and  ///
+///         consumers. Each slot carries a sequence number telling whether  ///
+///         it is free for the producer or filled for the consumer of the   ///
+///         current lap, so a push or pop is one CAS on the shared index.   ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_COMMON_BOUNDEDQUEUE_HPP_INCLUDED
+#define NOO_COMMON_BOUNDEDQUEUE_HPP_INCLUDED
+
+
+/// Includes
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+
+namespace noo {
+namespace common {
+
+template< class T >
+class BoundedQueue
+{
+public:
+
+    /// @param capacity A power of two.
+    explicit BoundedQueue( size_t capacity )
+        : m_Slots( new Slot[ capacity ] )
+        , m_Mask( capacity - 1 )
+    {
+        assert( capacity >= 2 && ( capacity & ( capacity - 1 ) ) == 0 );
+
+        for ( size_t i = 0; i < capacity; ++i )
+            m_Slots[ i ].Sequence.store( i, std::memory_order_relaxed );
+    }
+
+    BoundedQueue( BoundedQueue const & ) = delete;
+    BoundedQueue & operator=( BoundedQueue const & ) = delete;
+
+    /// @return false if the queue is full, value is untouched then.
+    bool
+    tryPush( T && value )
+    {
+        size_t pos = m_Tail.load( std::memory_order_relaxed );
+
+        for ( ;; )
+        {
+            Slot & slot = m_Slots[ pos & m_Mask ];
+            size_t const seq = slot.Sequence.load( std::memory_order_acquire );
+            intptr_t const diff = static_cast< intptr_t >( seq ) - static_cast< intptr_t >( pos );
+
+            if ( diff == 0 )
+            {
+                if ( m_Tail.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+                {
+                    slot.Value = std::move( value );
+                    slot.Sequence.store( pos + 1, std::memory_order_release );
+                    return true;
+                }
+            }
+            else if ( diff < 0 )
+            {
+                // the consumer has not freed this slot of the last lap yet
+                return false;
+            }
+            else
+            {
+                pos = m_Tail.load( std::memory_order_relaxed );
+            }
+        }
+    }
+
+    /// @return false if the queue is empty.
+    bool
+    tryPop( T & value )
+    {
+        size_t pos = m_Head.load( std::memory_order_relaxed );
+
+        for ( ;; )
+        {
+            Slot & slot = m_Slots[ pos & m_Mask ];
+            size_t const seq = slot.Sequence.load( std::memory_order_acquire );
+            intptr_t const diff = static_cast< intptr_t >( seq ) - static_cast< intptr_t >( pos + 1 );
+
+            if ( diff == 0 )
+            {
+                if ( m_Head.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+                {
+                    value = std::move( slot.Value );
+                    slot.Sequence.store( pos + m_Mask + 1, std::memory_order_release );
+                    return true;
+                }
+            }
+            else if ( diff < 0 )
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_Head.load( std::memory_order_relaxed );
+            }
+        }
+    }
+
+    /// @brief True if tryPop() would find nothing right now. Exact for a single
+    ///        consumer calling it, a hint for anybody else.
+    bool
+    isEmpty() const
+    {
+        size_t const pos = m_Head.load( std::memory_order_relaxed );
+        return m_Slots[ pos & m_Mask ].Sequence.load( std::memory_order_acquire ) != pos + 1;
+    }
+
+    size_t
+    getCapacity() const
+    { return m_Mask + 1; }
+
+private:
+
+    struct Slot
+    {
+        std::atomic< size_t > Sequence;
+        T Value;
+    };
+
+    std::unique_ptr< Slot[] > m_Slots;
+    size_t const m_Mask;
+
+    // producers and consumers do not share a cache line
+    alignas( 64 ) std::atomic< size_t > m_Tail{ 0 };
+    alignas( 64 ) std::atomic< size_t > m_Head{ 0 };
+};
+
+} // - namespace common
+} // - namespace noo
+
+
+#endif /* NOO_COMMON_BOUNDEDQUEUE_HPP_INCLUDED */
@@ -0,0 +1,127 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: DoubleBuffer.hpp                                                 ///
+/// @brief: Two slots passed between a producer and a consumer thread in    ///
+///         turn. The producer fills one while the consumer reads the       ///
+///         other, so both run at once with one frame between them. Either  ///
+///         side waits only if the other falls a whole slot behind.         ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_COMMON_DOUBLEBUFFER_HPP_INCLUDED
+#define NOO_COMMON_DOUBLEBUFFER_HPP_INCLUDED
+
+
+/// Includes
+#include <array>
+#include <condition_variable>
+#include <mutex>
+
+
+namespace noo {
+namespace common {
+
+template< class T >
+class DoubleBuffer
+{
+public:
+
+    DoubleBuffer() = default;
+
+    DoubleBuffer( DoubleBuffer const & ) = delete;
+    DoubleBuffer & operator=( DoubleBuffer const & ) = delete;
+
+    /// @brief The slot to fill next, waits while the consumer still reads it.
+    ///        It holds what was written to it two frames ago, so vectors keep
+    ///        their capacity. Producer thread only, followed by endWrite().
+    /// @return nullptr once closed.
+    T *
+    beginWrite()
+    {
+        std::unique_lock< std::mutex > lock( m_Mutex );
+        m_Changed.wait( lock, [ this ] { return m_Closed || m_State[ m_Write ] == State::FREE; } );
+
+        return m_Closed ? nullptr : &m_Slots[ m_Write ];
+    }
+
+    /// @brief Hands the slot of beginWrite() to the consumer.
+    void
+    endWrite()
+    {
+        {
+            std::lock_guard< std::mutex > lock( m_Mutex );
+            m_State[ m_Write ] = State::READY;
+            m_Write ^= 1;
+        }
+
+        m_Changed.notify_all();
+    }
+
+    /// @brief The oldest written slot, waits until there is one. Consumer thread
+    ///        only, followed by endRead().
+    /// @return nullptr once closed and every written slot was read.
+    T const *
+    beginRead()
+    {
+        std::unique_lock< std::mutex > lock( m_Mutex );
+        m_Changed.wait( lock, [ this ] { return m_Closed || m_State[ m_Read ] == State::READY; } );
+
+        if ( m_State[ m_Read ] != State::READY )
+            return nullptr;
+
+        m_State[ m_Read ] = State::READING;
+
+        return &m_Slots[ m_Read ];
+    }
+
+    /// @brief Gives the slot of beginRead() back to the producer.
+    void
+    endRead()
+    {
+        {
+            std::lock_guard< std::mutex > lock( m_Mutex );
+            m_State[ m_Read ] = State::FREE;
+            m_Read ^= 1;
+        }
+
+        m_Changed.notify_all();
+    }
+
+    /// @brief Wakes both sides. Every further beginWrite() returns nullptr,
+    ///        beginRead() once the written slots are read.
+    void
+    close()
+    {
+        {
+            std::lock_guard< std::mutex > lock( m_Mutex );
+            m_Closed = true;
+        }
+
+        m_Changed.notify_all();
+    }
+
+private:
+
+    enum class State
+    {
+        FREE,
+        READY,
+        READING
+    };
+
+    std::array< T, 2 > m_Slots;
+    std::array< State, 2 > m_State = { { State::FREE, State::FREE } };
+
+    int m_Write = 0;
+    int m_Read = 0;
+    bool m_Closed = false;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Changed;
+};
+
+} // - namespace common
+} // - namespace noo
+
+
+#endif /* NOO_COMMON_DOUBLEBUFFER_HPP_INCLUDED */
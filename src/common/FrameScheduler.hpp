@@ -0,0 +1,141 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: FrameScheduler.hpp                                               ///
+/// @brief: Drives a simulation with a fixed timestep from a variable frame ///
+///         rate. Real time is accumulated and consumed in whole steps, the ///
+///         remainder tells how far to interpolate between the last two     ///
+///         simulated states. Optionally paces frames to a target rate by   ///
+///         sleeping instead of spinning through frames nobody sees.        ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_COMMON_FRAMESCHEDULER_HPP_INCLUDED
+#define NOO_COMMON_FRAMESCHEDULER_HPP_INCLUDED
+
+
+/// Includes
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+
+namespace noo {
+namespace common {
+
+class FrameScheduler
+{
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    /// @brief Steps simulated per frame at most. If a frame took longer the rest
+    ///        of the time is dropped, so a slow frame cannot make the next slower.
+    static constexpr int MaxStepsPerFrame = 8;
+
+    /// @brief sleep_until() may overshoot by a scheduler tick, the last part of
+    ///        a pacing wait yields instead.
+    static constexpr std::chrono::microseconds SpinTime{ 1500 };
+
+    /// @param step The simulation timestep in seconds.
+    explicit FrameScheduler( double step = 1.0 / 60.0 )
+        : m_Step( step )
+        , m_LastFrame( Clock::now() )
+        , m_NextFrame( m_LastFrame )
+    {}
+
+    /// @brief Starts a frame.
+    /// @return The number of fixed steps to simulate to catch up with real time.
+    int
+    beginFrame()
+    {
+        Clock::time_point const now = Clock::now();
+
+        if ( m_FixedStepping )
+        {
+            m_LastFrame = now;
+            m_Accumulator = 0.0;
+            ++m_NumSteps;
+
+            return 1;
+        }
+
+        m_Accumulator += std::chrono::duration< double >( now - m_LastFrame ).count();
+        m_LastFrame = now;
+
+        int const steps = std::min( static_cast< int >( m_Accumulator / m_Step ), MaxStepsPerFrame );
+
+        m_Accumulator = std::min( m_Accumulator - steps * m_Step, m_Step );
+        m_NumSteps += steps;
+
+        return steps;
+    }
+
+    /// @brief Where real time is between the last and the next step, in [0, 1].
+    ///        1 if a full step is left over, e.g. after MaxStepsPerFrame steps.
+    ///        Blend the previous and the current state with it for display.
+    double
+    getAlpha() const
+    { return std::min( m_Accumulator / m_Step, 1.0 ); }
+
+    double
+    getStep() const
+    { return m_Step; }
+
+    /// @brief Steps simulated since construction, times getStep() is the simulated time.
+    uint64_t
+    getNumSteps() const
+    { return m_NumSteps; }
+
+    /// @brief Every frame simulates exactly one step, however long it took, and
+    ///        getAlpha() is 0. The simulation then depends on the frame count
+    ///        alone, e.g. to replay recorded input reproducibly.
+    void
+    setFixedStepping( bool fixed )
+    { m_FixedStepping = fixed; }
+
+    /// @param framesPerSecond 0 disables pacing.
+    void
+    setTargetFrameRate( double framesPerSecond )
+    {
+        m_FrameInterval = framesPerSecond > 0.0
+                        ? std::chrono::duration_cast< Clock::duration >( std::chrono::duration< double >( 1.0 / framesPerSecond ) )
+                        : Clock::duration::zero();
+        m_NextFrame = Clock::now();
+    }
+
+    /// @brief Waits until the next frame is due at the target rate. Call before
+    ///        polling input, so the frame starts with the freshest input.
+    void
+    pace()
+    {
+        if ( m_FrameInterval == Clock::duration::zero() )
+            return;
+
+        if ( Clock::now() + SpinTime < m_NextFrame )
+            std::this_thread::sleep_until( m_NextFrame - SpinTime );
+
+        while ( Clock::now() < m_NextFrame )
+            std::this_thread::yield();
+
+        // a late frame moves the schedule instead of rushing the following ones
+        m_NextFrame = std::max( m_NextFrame + m_FrameInterval, Clock::now() );
+    }
+
+private:
+
+    double m_Step;
+    double m_Accumulator = 0.0;
+    uint64_t m_NumSteps = 0;
+    bool m_FixedStepping = false;
+
+    Clock::time_point m_LastFrame;
+    Clock::time_point m_NextFrame;
+    Clock::duration m_FrameInterval = Clock::duration::zero();
+};
+
+} // - namespace common
+} // - namespace noo
+
+
+#endif /* NOO_COMMON_FRAMESCHEDULER_HPP_INCLUDED */
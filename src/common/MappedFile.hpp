@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: MappedFile.hpp                                                   ///
+/// @brief: Read-only memory mapping of a whole file.                       ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_COMMON_MAPPEDFILE_HPP_INCLUDED
+#define NOO_COMMON_MAPPEDFILE_HPP_INCLUDED
+
+
+/// Includes
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace noo {
+namespace common {
+
+class MappedFile
+{
+public:
+
+    MappedFile() = default;
+
+    MappedFile( MappedFile const & ) = delete;
+    MappedFile & operator=( MappedFile const & ) = delete;
+
+    ~MappedFile()
+    { close(); }
+
+    /// @brief Maps the file, the pages are read in on first access.
+    /// @return false if the file does not exist, is empty or cannot be mapped.
+    bool
+    open( std::string const & filename )
+    {
+        close();
+
+        int const fd = ::open( filename.c_str(), O_RDONLY );
+
+        if ( fd < 0 )
+            return false;
+
+        struct stat st;
+
+        if ( ::fstat( fd, &st ) != 0 || st.st_size <= 0 )
+        {
+            ::close( fd );
+            return false;
+        }
+
+        void * data = ::mmap( nullptr, static_cast< size_t >( st.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+
+        // the mapping keeps its own reference to the file
+        ::close( fd );
+
+        if ( data == MAP_FAILED )
+            return false;
+
+        // the whole file is about to be read front to back
+        ::madvise( data, static_cast< size_t >( st.st_size ), MADV_SEQUENTIAL | MADV_WILLNEED );
+
+        m_Data = static_cast< uint8_t const * >( data );
+        m_Size = static_cast< size_t >( st.st_size );
+
+        return true;
+    }
+
+    void
+    close()
+    {
+        if ( m_Data != nullptr )
+            ::munmap( const_cast< uint8_t * >( m_Data ), m_Size );
+
+        m_Data = nullptr;
+        m_Size = 0;
+    }
+
+    bool
+    isOpen() const
+    { return m_Data != nullptr; }
+
+    uint8_t const *
+    getData() const
+    { return m_Data; }
+
+    size_t
+    getSize() const
+    { return m_Size; }
+
+private:
+
+    uint8_t const * m_Data = nullptr;
+    size_t m_Size = 0;
+};
+
+} // - namespace common
+} // - namespace noo
+
+
+#endif /* NOO_COMMON_MAPPEDFILE_HPP_INCLUDED */
@@ -0,0 +1,186 @@
+
+///////////////////////////////////////////////////////////////////////////////
+/// @file: ThreadPool.hpp                                                   ///
+/// @brief: Fixed set of worker threads executing queued tasks.             ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_COMMON_THREADPOOL_HPP_INCLUDED
+#define NOO_COMMON_THREADPOOL_HPP_INCLUDED
+
+
+/// Includes
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace noo {
+namespace common {
+
+class ThreadPool
+{
+public:
+
+    /// @brief Per default one thread less than there are cores, the calling thread
+    ///        takes part in parallelFor() and usually has other work to do anyway.
+    explicit ThreadPool( unsigned numThreads = defaultThreadCount() )
+        : m_Stop( false )
+    {
+        for ( unsigned i = 0; i < numThreads; ++i )
+        {
+            m_Workers.emplace_back( [ this ] { workerLoop(); } );
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard< std::mutex > lock( m_Mutex );
+            m_Stop = true;
+        }
+
+        m_Condition.notify_all();
+
+        for ( auto & w : m_Workers )
+            w.join();
+    }
+
+    ThreadPool( ThreadPool const & ) = delete;
+    ThreadPool & operator=( ThreadPool const & ) = delete;
+
+    size_t
+    getNumThreads() const
+    { return m_Workers.size(); }
+
+    /// @brief Queues a task, the returned future yields its result.
+    template< class F >
+    auto
+    submit( F && f ) -> std::future< decltype( f() ) >
+    {
+        using Result = decltype( f() );
+
+        auto task = std::make_shared< std::packaged_task< Result() > >( std::forward< F >( f ) );
+        std::future< Result > result = task->get_future();
+
+        {
+            std::lock_guard< std::mutex > lock( m_Mutex );
+            m_Tasks.emplace_back( [ task ] { ( *task )(); } );
+        }
+
+        m_Condition.notify_one();
+
+        return result;
+    }
+
+    /// @brief Calls fn( begin, end ) for consecutive ranges of at most grainSize
+    ///        elements covering [0, count) and returns once all ranges are done.
+    ///        The calling thread processes ranges as well, so nested calls from
+    ///        inside a task can not dead-lock.
+    void
+    parallelFor( size_t count, size_t grainSize, std::function< void( size_t, size_t ) > const & fn )
+    {
+        grainSize = std::max< size_t >( grainSize, 1 );
+        size_t const numChunks = ( count + grainSize - 1 ) / grainSize;
+
+        if ( numChunks <= 1 || m_Workers.empty() )
+        {
+            if ( count > 0 ) fn( 0, count );
+            return;
+        }
+
+        struct Shared
+        {
+            std::atomic< size_t > Next{ 0 };
+            std::atomic< size_t > Done{ 0 };
+            std::mutex Mutex;
+            std::condition_variable Finished;
+        };
+
+        auto shared = std::make_shared< Shared >();
+
+        // fn is only referenced while chunks are left, which the caller waits for
+        auto work = [ shared, numChunks, count, grainSize, &fn ]
+        {
+            for ( size_t c = shared->Next++; c < numChunks; c = shared->Next++ )
+            {
+                size_t const begin = c * grainSize;
+                fn( begin, std::min( begin + grainSize, count ) );
+
+                if ( ++shared->Done == numChunks )
+                {
+                    std::lock_guard< std::mutex > lock( shared->Mutex );
+                    shared->Finished.notify_all();
+                }
+            }
+        };
+
+        size_t const numHelpers = std::min( m_Workers.size(), numChunks - 1 );
+
+        {
+            std::lock_guard< std::mutex > lock( m_Mutex );
+
+            for ( size_t i = 0; i < numHelpers; ++i )
+                m_Tasks.emplace_back( work );
+        }
+
+        m_Condition.notify_all();
+
+        work();
+
+        std::unique_lock< std::mutex > lock( shared->Mutex );
+        shared->Finished.wait( lock, [ &shared, numChunks ] { return shared->Done == numChunks; } );
+    }
+
+    static unsigned
+    defaultThreadCount()
+    {
+        unsigned const hw = std::thread::hardware_concurrency();
+        return hw > 1 ? hw - 1 : 1;
+    }
+
+private:
+
+    void
+    workerLoop()
+    {
+        for ( ;; )
+        {
+            std::function< void() > task;
+
+            {
+                std::unique_lock< std::mutex > lock( m_Mutex );
+                m_Condition.wait( lock, [ this ] { return m_Stop || ! m_Tasks.empty(); } );
+
+                if ( m_Stop && m_Tasks.empty() )
+                    return;
+
+                task = std::move( m_Tasks.front() );
+                m_Tasks.pop_front();
+            }
+
+            task();
+        }
+    }
+
+    std::vector< std::thread > m_Workers;
+    std::deque< std::function< void() > > m_Tasks;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    bool m_Stop;
+};
+
+} // - namespace common
+} // - namespace noo
+
+
+#endif /* NOO_COMMON_THREADPOOL_HPP_INCLUDED */
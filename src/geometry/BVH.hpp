@@ -0,0 +1,502 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: BVH.hpp                                                          ///
+/// @brief: Bounding volume hierarchy over a set of boxes. Built with the   ///
+///         binned surface area heuristic, refittable when boxes move.      ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_GEOMETRY_BVH_HPP__INCLUDED__
+#define NOO_GEOMETRY_BVH_HPP__INCLUDED__
+
+
+/// Includes
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Bounds.hpp"
+#include "Frustum.hpp"
+
+
+namespace noo {
+namespace geometry {
+
+class BVH
+{
+public:
+
+    struct Node
+    {
+        AABB Bounds;
+
+        /// @brief Leaves: first entry in the primitive index list.
+        ///        Inner nodes: index of the left child, the right one follows it.
+        uint32_t Index = 0;
+
+        /// @brief Number of primitives of a leaf, zero for inner nodes.
+        uint32_t Count = 0;
+
+        bool
+        isLeaf() const
+        { return Count > 0; }
+    };
+
+    static constexpr uint32_t MaxLeafSize = 4;
+    static constexpr int NumBins = 16;
+
+    /// @brief Deeper subtrees become leaves, keeps the fixed traversal stacks safe.
+    static constexpr int MaxDepth = 48;
+
+    /// @brief Builds the hierarchy from scratch, primitive i is boxes[ i ].
+    void
+    build( std::vector< AABB > const & boxes )
+    {
+        m_PrimBounds = boxes;
+        m_Nodes.clear();
+        m_PrimIndices.resize( boxes.size() );
+
+        for ( uint32_t i = 0; i < m_PrimIndices.size(); ++i )
+            m_PrimIndices[ i ] = i;
+
+        if ( boxes.empty() )
+            return;
+
+        m_Nodes.reserve( 2 * boxes.size() );
+        m_Nodes.emplace_back();
+        buildNode( 0, 0, static_cast< uint32_t >( boxes.size() ), 0 );
+    }
+
+    /// @brief Changes the box of a primitive, takes effect with the next refit().
+    void
+    update( uint32_t prim, AABB const & box )
+    { m_PrimBounds[ prim ] = box; }
+
+    /// @brief Recomputes all node bounds bottom up, keeping the topology. Cheap,
+    ///        but the tree degrades if primitives move far from where they were built.
+    void
+    refit()
+    {
+        // children are always stored after their parent
+        for ( size_t n = m_Nodes.size(); n-- > 0; )
+        {
+            Node & node = m_Nodes[ n ];
+            node.Bounds = AABB();
+
+            if ( node.isLeaf() )
+            {
+                for ( uint32_t i = 0; i < node.Count; ++i )
+                    node.Bounds.extend( m_PrimBounds[ m_PrimIndices[ node.Index + i ] ] );
+            }
+            else
+            {
+                node.Bounds.extend( m_Nodes[ node.Index ].Bounds );
+                node.Bounds.extend( m_Nodes[ node.Index + 1 ].Bounds );
+            }
+        }
+    }
+
+    bool
+    isEmpty() const
+    { return m_Nodes.empty(); }
+
+    size_t
+    getNumNodes() const
+    { return m_Nodes.size(); }
+
+    AABB
+    getBounds() const
+    { return m_Nodes.empty() ? AABB() : m_Nodes[ 0 ].Bounds; }
+
+    /// @brief Calls fn( prim ) for every primitive whose box intersects the frustum.
+    ///        Subtrees completely inside of the frustum are emitted without further tests.
+    template< class F >
+    void
+    queryFrustum( Frustum const & frustum, F && fn ) const
+    {
+        if ( m_Nodes.empty() )
+            return;
+
+        uint32_t const allInside = ( 1u << Frustum::NUM_PLANES ) - 1;
+
+        // node index and the planes the node is known to be inside of
+        std::array< std::pair< uint32_t, uint32_t >, 64 > stack;
+        int top = 0;
+        stack[ top++ ] = { 0, 0 };
+
+        while ( top > 0 )
+        {
+            auto const entry = stack[ --top ];
+            Node const & node = m_Nodes[ entry.first ];
+            uint32_t inside = entry.second;
+
+            glm::vec3 const c = node.Bounds.getCenter();
+            glm::vec3 const e = node.Bounds.getExtents();
+            bool outside = false;
+
+            for ( int p = 0; p < Frustum::NUM_PLANES && ! outside; ++p )
+            {
+                if ( inside & ( 1u << p ) )
+                    continue;
+
+                glm::vec4 const & pl = frustum.Planes[ p ];
+                float const d = pl.x * c.x + pl.y * c.y + pl.z * c.z + pl.w;
+                float const r = std::abs( pl.x ) * e.x + std::abs( pl.y ) * e.y + std::abs( pl.z ) * e.z;
+
+                if ( d < -r )
+                    outside = true;
+                else if ( d >= r )
+                    inside |= 1u << p;
+            }
+
+            if ( outside )
+                continue;
+
+            if ( inside == allInside )
+            {
+                emitSubtree( entry.first, fn );
+            }
+            else if ( node.isLeaf() )
+            {
+                for ( uint32_t i = 0; i < node.Count; ++i )
+                {
+                    uint32_t const prim = m_PrimIndices[ node.Index + i ];
+
+                    if ( frustum.intersects( m_PrimBounds[ prim ] ) )
+                        fn( prim );
+                }
+            }
+            else
+            {
+                stack[ top++ ] = { node.Index + 1, inside };
+                stack[ top++ ] = { node.Index, inside };
+            }
+        }
+    }
+
+    /// @brief Calls fn( prim ) for every primitive whose box overlaps the box.
+    template< class F >
+    void
+    queryOverlap( AABB const & box, F && fn ) const
+    {
+        traverse( [ &box ]( AABB const & b ) { return box.overlaps( b ); }, fn );
+    }
+
+    /// @brief Calls fn( prim ) for every primitive whose box overlaps the sphere.
+    template< class F >
+    void
+    queryOverlap( BoundingSphere const & sphere, F && fn ) const
+    {
+        traverse( [ &sphere ]( AABB const & b ) { return sphere.overlaps( b ); }, fn );
+    }
+
+    /// @brief Finds the closest primitive hit by the ray within [0, tMax]. Boxes are
+    ///        visited front to back, intersect( prim, tMax ) performs the exact test
+    ///        and returns the hit distance, or a negative value for a miss.
+    /// @return The index of the closest hit primitive or -1, tMax is set to its distance.
+    template< class F >
+    int64_t
+    raycast( glm::vec3 const & origin, glm::vec3 const & dir, float & tMax, F && intersect ) const
+    {
+        if ( m_Nodes.empty() )
+            return -1;
+
+        glm::vec3 const invDir( 1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z );
+        int64_t closest = -1;
+
+        std::array< uint32_t, 64 > stack;
+        int top = 0;
+
+        if ( slabTest( m_Nodes[ 0 ].Bounds, origin, invDir, tMax ) >= 0.0f )
+            stack[ top++ ] = 0;
+
+        while ( top > 0 )
+        {
+            Node const & node = m_Nodes[ stack[ --top ] ];
+
+            // the box may have been entered before a closer hit was found
+            if ( slabTest( node.Bounds, origin, invDir, tMax ) < 0.0f )
+                continue;
+
+            if ( node.isLeaf() )
+            {
+                for ( uint32_t i = 0; i < node.Count; ++i )
+                {
+                    uint32_t const prim = m_PrimIndices[ node.Index + i ];
+
+                    if ( slabTest( m_PrimBounds[ prim ], origin, invDir, tMax ) < 0.0f )
+                        continue;
+
+                    float const t = intersect( prim, tMax );
+
+                    if ( t >= 0.0f && t <= tMax )
+                    {
+                        tMax = t;
+                        closest = prim;
+                    }
+                }
+
+                continue;
+            }
+
+            float const tl = slabTest( m_Nodes[ node.Index ].Bounds, origin, invDir, tMax );
+            float const tr = slabTest( m_Nodes[ node.Index + 1 ].Bounds, origin, invDir, tMax );
+
+            // push the farther child first, so the nearer one is visited next
+            if ( tl >= 0.0f && tr >= 0.0f )
+            {
+                bool const leftFirst = tl <= tr;
+                stack[ top++ ] = leftFirst ? node.Index + 1 : node.Index;
+                stack[ top++ ] = leftFirst ? node.Index : node.Index + 1;
+            }
+            else if ( tl >= 0.0f )
+            {
+                stack[ top++ ] = node.Index;
+            }
+            else if ( tr >= 0.0f )
+            {
+                stack[ top++ ] = node.Index + 1;
+            }
+        }
+
+        return closest;
+    }
+
+    /// @brief Entry distance of the ray into the box, negative if it misses within [0, tMax].
+    static float
+    slabTest( AABB const & box, glm::vec3 const & origin, glm::vec3 const & invDir, float tMax )
+    {
+        float tEnter = 0.0f;
+        float tExit = tMax;
+
+        for ( int a = 0; a < 3; ++a )
+        {
+            float t0 = ( box.Min[ a ] - origin[ a ] ) * invDir[ a ];
+            float t1 = ( box.Max[ a ] - origin[ a ] ) * invDir[ a ];
+
+            if ( t0 > t1 ) std::swap( t0, t1 );
+
+            tEnter = std::max( tEnter, t0 );
+            tExit = std::min( tExit, t1 );
+        }
+
+        return tEnter <= tExit ? tEnter : -1.0f;
+    }
+
+private:
+
+    struct Bin
+    {
+        AABB Bounds;
+        uint32_t Count = 0;
+    };
+
+    void
+    buildNode( uint32_t nodeIndex, uint32_t first, uint32_t count, int depth )
+    {
+        AABB bounds;
+        AABB centroids;
+
+        for ( uint32_t i = first; i < first + count; ++i )
+        {
+            AABB const & b = m_PrimBounds[ m_PrimIndices[ i ] ];
+            bounds.extend( b );
+            centroids.extend( b.getCenter() );
+        }
+
+        m_Nodes[ nodeIndex ].Bounds = bounds;
+
+        uint32_t mid = first;
+
+        if ( count > MaxLeafSize && depth < MaxDepth )
+            mid = findSplit( first, count, bounds, centroids );
+
+        if ( mid == first )
+        {
+            m_Nodes[ nodeIndex ].Index = first;
+            m_Nodes[ nodeIndex ].Count = count;
+            return;
+        }
+
+        uint32_t const left = static_cast< uint32_t >( m_Nodes.size() );
+        m_Nodes.emplace_back();
+        m_Nodes.emplace_back();
+
+        m_Nodes[ nodeIndex ].Index = left;
+        m_Nodes[ nodeIndex ].Count = 0;
+
+        buildNode( left, first, mid - first, depth + 1 );
+        buildNode( left + 1, mid, first + count - mid, depth + 1 );
+    }
+
+    /// @brief Partitions the primitives at the cheapest binned SAH split.
+    /// @return The first index of the right half, or first if a leaf is cheaper.
+    uint32_t
+    findSplit( uint32_t first, uint32_t count, AABB const & bounds, AABB const & centroids )
+    {
+        glm::vec3 const extent = centroids.Max - centroids.Min;
+        int axis = 0;
+        if ( extent.y > extent[ axis ] ) axis = 1;
+        if ( extent.z > extent[ axis ] ) axis = 2;
+
+        auto begin = m_PrimIndices.begin() + first;
+        auto end = begin + count;
+
+        if ( extent[ axis ] <= 0.0f )
+        {
+            // all centroids coincide, binning can not separate them
+            return splitAtMedian( first, count, axis );
+        }
+
+        float const scale = NumBins / extent[ axis ];
+        float const origin = centroids.Min[ axis ];
+
+        auto binOf = [ this, axis, scale, origin ]( uint32_t prim )
+        {
+            int const b = static_cast< int >( ( m_PrimBounds[ prim ].getCenter()[ axis ] - origin ) * scale );
+            return std::min( b, NumBins - 1 );
+        };
+
+        std::array< Bin, NumBins > bins;
+
+        for ( auto it = begin; it != end; ++it )
+        {
+            Bin & bin = bins[ binOf( *it ) ];
+            bin.Bounds.extend( m_PrimBounds[ *it ] );
+            ++bin.Count;
+        }
+
+        // sweep from the right to get the cost of every right half
+        std::array< float, NumBins > rightCost;
+        AABB acc;
+        uint32_t n = 0;
+
+        for ( int b = NumBins - 1; b > 0; --b )
+        {
+            acc.extend( bins[ b ].Bounds );
+            n += bins[ b ].Count;
+            rightCost[ b ] = acc.getSurfaceArea() * n;
+        }
+
+        float bestCost = std::numeric_limits< float >::max();
+        int bestSplit = -1;
+        acc = AABB();
+        n = 0;
+
+        for ( int b = 0; b < NumBins - 1; ++b )
+        {
+            acc.extend( bins[ b ].Bounds );
+            n += bins[ b ].Count;
+
+            if ( n == 0 || n == count )
+                continue;
+
+            float const cost = acc.getSurfaceArea() * n + rightCost[ b + 1 ];
+
+            if ( cost < bestCost )
+            {
+                bestCost = cost;
+                bestSplit = b;
+            }
+        }
+
+        // traversal cost relative to intersecting one primitive
+        float const leafCost = bounds.getSurfaceArea() * count;
+        float const traversalCost = bounds.getSurfaceArea() * 0.125f;
+
+        if ( bestSplit < 0 || bestCost + traversalCost >= leafCost )
+        {
+            return count > 4 * MaxLeafSize ? splitAtMedian( first, count, axis ) : first;
+        }
+
+        auto mid = std::partition( begin, end, [ &binOf, bestSplit ]( uint32_t prim ) { return binOf( prim ) <= bestSplit; } );
+
+        return first + static_cast< uint32_t >( mid - begin );
+    }
+
+    /// @brief Partitions the primitives around the median centroid on axis,
+    ///        for nodes too big to be a leaf without a good SAH split.
+    /// @return The first index of the right half.
+    uint32_t
+    splitAtMedian( uint32_t first, uint32_t count, int axis )
+    {
+        auto begin = m_PrimIndices.begin() + first;
+        auto mid = begin + count / 2;
+
+        std::nth_element( begin, mid, begin + count, [ this, axis ]( uint32_t a, uint32_t b )
+        {
+            return m_PrimBounds[ a ].getCenter()[ axis ] < m_PrimBounds[ b ].getCenter()[ axis ];
+        } );
+
+        return first + count / 2;
+    }
+
+    template< class F >
+    void
+    emitSubtree( uint32_t nodeIndex, F && fn ) const
+    {
+        Node const & node = m_Nodes[ nodeIndex ];
+
+        if ( node.isLeaf() )
+        {
+            for ( uint32_t i = 0; i < node.Count; ++i )
+                fn( m_PrimIndices[ node.Index + i ] );
+        }
+        else
+        {
+            emitSubtree( node.Index, fn );
+            emitSubtree( node.Index + 1, fn );
+        }
+    }
+
+    template< class Test, class F >
+    void
+    traverse( Test && test, F && fn ) const
+    {
+        if ( m_Nodes.empty() )
+            return;
+
+        std::array< uint32_t, 64 > stack;
+        int top = 0;
+        stack[ top++ ] = 0;
+
+        while ( top > 0 )
+        {
+            Node const & node = m_Nodes[ stack[ --top ] ];
+
+            if ( ! test( node.Bounds ) )
+                continue;
+
+            if ( node.isLeaf() )
+            {
+                for ( uint32_t i = 0; i < node.Count; ++i )
+                {
+                    uint32_t const prim = m_PrimIndices[ node.Index + i ];
+
+                    if ( test( m_PrimBounds[ prim ] ) )
+                        fn( prim );
+                }
+            }
+            else
+            {
+                stack[ top++ ] = node.Index + 1;
+                stack[ top++ ] = node.Index;
+            }
+        }
+    }
+
+    std::vector< Node > m_Nodes;
+    std::vector< uint32_t > m_PrimIndices;
+    std::vector< AABB > m_PrimBounds;
+};
+
+} // - namespace geometry
+} // - namespace noo
+
+
+#endif /* NOO_GEOMETRY_BVH_HPP__INCLUDED__ */
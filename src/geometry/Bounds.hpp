@@ -0,0 +1,162 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: Bounds.hpp                                                       ///
+/// @brief: Axis aligned bounding boxes and bounding spheres.               ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_GEOMETRY_BOUNDS_HPP__INCLUDED__
+#define NOO_GEOMETRY_BOUNDS_HPP__INCLUDED__
+
+
+/// Includes
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+
+namespace noo {
+namespace geometry {
+
+struct AABB
+{
+    glm::vec3 Min;
+    glm::vec3 Max;
+
+    /// @brief Per default the box is empty (inverted), extending it by any point makes it valid.
+    AABB()
+        : Min( std::numeric_limits< float >::max() )
+        , Max( -std::numeric_limits< float >::max() )
+    { }
+
+    AABB( glm::vec3 const & min, glm::vec3 const & max )
+        : Min( min )
+        , Max( max )
+    { }
+
+    bool
+    isEmpty() const
+    { return Min.x > Max.x || Min.y > Max.y || Min.z > Max.z; }
+
+    glm::vec3
+    getCenter() const
+    { return ( Min + Max ) * 0.5f; }
+
+    /// @brief Half the size of the box along each axis.
+    glm::vec3
+    getExtents() const
+    { return ( Max - Min ) * 0.5f; }
+
+    float
+    getSurfaceArea() const
+    {
+        glm::vec3 const d = Max - Min;
+        return isEmpty() ? 0.0f : 2.0f * ( d.x * d.y + d.y * d.z + d.z * d.x );
+    }
+
+    void
+    extend( glm::vec3 const & p )
+    {
+        Min = glm::min( Min, p );
+        Max = glm::max( Max, p );
+    }
+
+    void
+    extend( AABB const & other )
+    {
+        Min = glm::min( Min, other.Min );
+        Max = glm::max( Max, other.Max );
+    }
+
+    bool
+    overlaps( AABB const & other ) const
+    {
+        return Min.x <= other.Max.x && Max.x >= other.Min.x
+            && Min.y <= other.Max.y && Max.y >= other.Min.y
+            && Min.z <= other.Max.z && Max.z >= other.Min.z;
+    }
+
+    /// @brief The box enclosing this box after transformation with m.
+    AABB
+    transformed( glm::mat4 const & m ) const
+    {
+        if ( isEmpty() )
+            return AABB();
+
+        glm::vec3 const c = glm::vec3( m * glm::vec4( getCenter(), 1.0f ) );
+        glm::vec3 const e = getExtents();
+
+        glm::vec3 const ext( std::abs( m[ 0 ][ 0 ] ) * e.x + std::abs( m[ 1 ][ 0 ] ) * e.y + std::abs( m[ 2 ][ 0 ] ) * e.z
+                           , std::abs( m[ 0 ][ 1 ] ) * e.x + std::abs( m[ 1 ][ 1 ] ) * e.y + std::abs( m[ 2 ][ 1 ] ) * e.z
+                           , std::abs( m[ 0 ][ 2 ] ) * e.x + std::abs( m[ 1 ][ 2 ] ) * e.y + std::abs( m[ 2 ][ 2 ] ) * e.z );
+
+        return { c - ext, c + ext };
+    }
+
+    static AABB
+    fromPoints( std::vector< glm::vec3 > const & points )
+    {
+        AABB box;
+
+        for ( auto const & p : points )
+            box.extend( p );
+
+        return box;
+    }
+};
+
+
+struct BoundingSphere
+{
+    glm::vec3 Center;
+    float Radius;
+
+    BoundingSphere()
+        : Center( 0.0f )
+        , Radius( -1.0f )
+    { }
+
+    BoundingSphere( glm::vec3 const & center, float radius )
+        : Center( center )
+        , Radius( radius )
+    { }
+
+    bool
+    isEmpty() const
+    { return Radius < 0.0f; }
+
+    bool
+    overlaps( AABB const & box ) const
+    {
+        glm::vec3 const closest = glm::clamp( Center, box.Min, box.Max );
+        glm::vec3 const d = closest - Center;
+        return glm::dot( d, d ) <= Radius * Radius;
+    }
+
+    /// @brief Sphere around the box center with the smallest radius enclosing all points.
+    static BoundingSphere
+    fromPoints( std::vector< glm::vec3 > const & points, AABB const & box )
+    {
+        if ( box.isEmpty() )
+            return {};
+
+        glm::vec3 const c = box.getCenter();
+        float r2 = 0.0f;
+
+        for ( auto const & p : points )
+        {
+            glm::vec3 const d = p - c;
+            r2 = std::max( r2, glm::dot( d, d ) );
+        }
+
+        return { c, std::sqrt( r2 ) };
+    }
+};
+
+} // - namespace geometry
+} // - namespace noo
+
+
+#endif /* NOO_GEOMETRY_BOUNDS_HPP__INCLUDED__ */
@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: Frustum.hpp                                                      ///
+/// @brief: View frustum given by six inward facing planes.                 ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_GEOMETRY_FRUSTUM_HPP__INCLUDED__
+#define NOO_GEOMETRY_FRUSTUM_HPP__INCLUDED__
+
+
+/// Includes
+#include <array>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "Bounds.hpp"
+
+
+namespace noo {
+namespace geometry {
+
+struct Frustum
+{
+    enum Side
+    {
+        LEFT,
+        RIGHT,
+        BOTTOM,
+        TOP,
+        NEAR,
+        FAR,
+
+        NUM_PLANES
+    };
+
+    /// @brief Plane equations ( nx, ny, nz, d ) with normalized, inward pointing normals.
+    ///        A point p is inside of a plane if dot( n, p ) + d >= 0.
+    std::array< glm::vec4, NUM_PLANES > Planes;
+
+    /// @brief Extracts the planes from a (model-)view-projection matrix (Gribb/Hartmann).
+    ///        The planes are in the space the matrix transforms from.
+    static Frustum
+    fromMatrix( glm::mat4 const & m )
+    {
+        // glm is column major, m[ col ][ row ]
+        auto row = [ &m ]( int r ) { return glm::vec4( m[ 0 ][ r ], m[ 1 ][ r ], m[ 2 ][ r ], m[ 3 ][ r ] ); };
+
+        glm::vec4 const r0 = row( 0 );
+        glm::vec4 const r1 = row( 1 );
+        glm::vec4 const r2 = row( 2 );
+        glm::vec4 const r3 = row( 3 );
+
+        Frustum f;
+        f.Planes[ LEFT   ] = r3 + r0;
+        f.Planes[ RIGHT  ] = r3 - r0;
+        f.Planes[ BOTTOM ] = r3 + r1;
+        f.Planes[ TOP    ] = r3 - r1;
+        f.Planes[ NEAR   ] = r3 + r2;
+        f.Planes[ FAR    ] = r3 - r2;
+
+        for ( auto & p : f.Planes )
+        {
+            float const len = std::sqrt( p.x * p.x + p.y * p.y + p.z * p.z );
+            p = p / len;
+        }
+
+        return f;
+    }
+
+    bool
+    contains( BoundingSphere const & s ) const
+    {
+        for ( auto const & p : Planes )
+        {
+            if ( p.x * s.Center.x + p.y * s.Center.y + p.z * s.Center.z + p.w < -s.Radius )
+                return false;
+        }
+
+        return true;
+    }
+
+    /// @brief Conservative test, boxes crossing the corners outside of the frustum may pass.
+    bool
+    intersects( AABB const & box ) const
+    {
+        glm::vec3 const c = box.getCenter();
+        glm::vec3 const e = box.getExtents();
+
+        for ( auto const & p : Planes )
+        {
+            float const d = p.x * c.x + p.y * c.y + p.z * c.z + p.w;
+            float const r = std::abs( p.x ) * e.x + std::abs( p.y ) * e.y + std::abs( p.z ) * e.z;
+
+            if ( d < -r )
+                return false;
+        }
+
+        return true;
+    }
+};
+
+} // - namespace geometry
+} // - namespace noo
+
+
+#endif /* NOO_GEOMETRY_FRUSTUM_HPP__INCLUDED__ */
@@ -20,6 +20,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include "MeshOptimizer.hpp"
+
 
 
 /// Using declarations
@@ -73,15 +75,26 @@ public:
         {
             for ( size_t sl = 0; sl < numSlices; ++sl )
             {
-                indices.push_back( st         * numSlices +   sl );
-                indices.push_back( st         * numSlices +   sl + 1 );
-                indices.push_back( ( st + 1 ) * numSlices +   sl );
+                // wrap around at the seam, otherwise the last quad of a stack
+                // would reach into the next stack and leave the sphere open
+                size_t const sn = ( sl + 1 ) % numSlices;
+
+                indices.push_back( st         * numSlices + sl );
+                indices.push_back( st         * numSlices + sn );
+                indices.push_back( ( st + 1 ) * numSlices + sl );
 
-                indices.push_back( ( st + 1 ) * numSlices +   sl );
-                indices.push_back(   st       * numSlices +   sl + 1 );
-                indices.push_back( ( st + 1 ) * numSlices + ( sl + 1 ) );
+                indices.push_back( ( st + 1 ) * numSlices + sl );
+                indices.push_back(   st       * numSlices + sn );
+                indices.push_back( ( st + 1 ) * numSlices + sn );
             }
         }
+
+        // stack by stack order reuses hardly any vertex of the previous stack
+        MeshOptimizer::optimizeVertexCache( indices, vertexPositions.size() );
+
+        std::vector< uint32_t > const remap = MeshOptimizer::optimizeVertexFetch( indices, vertexPositions.size() );
+        MeshOptimizer::remapIndices( indices, remap );
+        MeshOptimizer::remapVertices( vertexPositions, remap );
     }
 };
 
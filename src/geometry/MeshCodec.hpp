@@ -0,0 +1,360 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: MeshCodec.hpp                                                    ///
+/// @brief: Lossless compression of vertex and index buffers.               ///
+///                                                                         ///
+///         Vertices: every byte of the vertex is coded as its own lane,    ///
+///         as zigzag delta to the same byte of the previous vertex. Per    ///
+///         16 vertices a lane stores its bit width and that many 16 bit    ///
+///         bitplanes, which SSE2 expands and prefix sums 16 at a time.     ///
+///                                                                         ///
+///         Indices: zigzag delta to the previous index as LEB128 varint.   ///
+///                                                                         ///
+///         Both restart in fixed size chunks, which decode in parallel.    ///
+///         Encoded: uint32 numChunks | uint32 chunkEnd[ numChunks ] | data ///
+///                                                                         ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_GEOMETRY_MESHCODEC_HPP_INCLUDED
+#define NOO_GEOMETRY_MESHCODEC_HPP_INCLUDED
+
+
+/// Includes
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined( __SSE2__ )
+#include <immintrin.h>
+#endif
+
+#include "../common/ThreadPool.hpp"
+
+
+namespace noo {
+namespace geometry {
+
+class MeshCodec
+{
+public:
+
+    /// @brief Vertices per SIMD block, one bit per vertex in a bitplane.
+    static constexpr size_t BlockSize = 16;
+
+    /// @brief Vertices and indices per independently decodable chunk.
+    static constexpr size_t ChunkVertices = 8192;
+    static constexpr size_t ChunkIndices = 3 * 8192;
+
+    static std::vector< uint8_t >
+    encodeVertices( void const * vertices, size_t numVertices, size_t stride )
+    {
+        uint8_t const * src = static_cast< uint8_t const * >( vertices );
+
+        return encodeChunks( numVertices, ChunkVertices, [ src, stride ]( size_t first, size_t count, std::vector< uint8_t > & out )
+        {
+            for ( size_t k = 0; k < stride; ++k )
+            {
+                uint8_t prev = 0;
+
+                for ( size_t b = 0; b < count; b += BlockSize )
+                {
+                    uint8_t zz[ BlockSize ];
+                    uint8_t maxZz = 0;
+
+                    // past the end the last value repeats, a zero delta
+                    for ( size_t i = 0; i < BlockSize; ++i )
+                    {
+                        uint8_t const cur = b + i < count ? src[ ( first + b + i ) * stride + k ] : prev;
+                        uint8_t const d = static_cast< uint8_t >( cur - prev );
+
+                        zz[ i ] = static_cast< uint8_t >( ( d << 1 ) ^ ( d & 0x80 ? 0xff : 0x00 ) );
+                        maxZz |= zz[ i ];
+                        prev = cur;
+                    }
+
+                    uint8_t bits = 0;
+
+                    while ( maxZz >> bits )
+                        ++bits;
+
+                    out.push_back( bits );
+
+                    for ( uint8_t p = 0; p < bits; ++p )
+                    {
+                        uint16_t plane = 0;
+
+                        for ( size_t i = 0; i < BlockSize; ++i )
+                            plane |= static_cast< uint16_t >( ( zz[ i ] >> p ) & 1 ) << i;
+
+                        out.push_back( static_cast< uint8_t >( plane ) );
+                        out.push_back( static_cast< uint8_t >( plane >> 8 ) );
+                    }
+                }
+            }
+        } );
+    }
+
+    /// @brief Decodes into numVertices * stride bytes at vertices, both as encoded.
+    /// @return false if the data is truncated or corrupt.
+    static bool
+    decodeVertices( void * vertices, size_t numVertices, size_t stride, uint8_t const * data, size_t size, common::ThreadPool * pool = nullptr )
+    {
+        uint8_t * dst = static_cast< uint8_t * >( vertices );
+
+        return decodeChunks( numVertices, ChunkVertices, data, size, pool, [ dst, stride ]( size_t first, size_t count, uint8_t const * src, uint8_t const * end )
+        {
+            return decodeVertexChunk( dst + first * stride, count, stride, src, end );
+        } );
+    }
+
+    static std::vector< uint8_t >
+    encodeIndices( uint32_t const * indices, size_t numIndices )
+    {
+        return encodeChunks( numIndices, ChunkIndices, [ indices ]( size_t first, size_t count, std::vector< uint8_t > & out )
+        {
+            uint32_t prev = 0;
+
+            for ( size_t i = first; i < first + count; ++i )
+            {
+                int32_t const d = static_cast< int32_t >( indices[ i ] - prev );
+                uint32_t zz = ( static_cast< uint32_t >( d ) << 1 ) ^ static_cast< uint32_t >( d >> 31 );
+
+                while ( zz >= 0x80 )
+                {
+                    out.push_back( static_cast< uint8_t >( zz | 0x80 ) );
+                    zz >>= 7;
+                }
+
+                out.push_back( static_cast< uint8_t >( zz ) );
+                prev = indices[ i ];
+            }
+        } );
+    }
+
+    /// @return false if the data is truncated or corrupt.
+    static bool
+    decodeIndices( uint32_t * indices, size_t numIndices, uint8_t const * data, size_t size, common::ThreadPool * pool = nullptr )
+    {
+        return decodeChunks( numIndices, ChunkIndices, data, size, pool, [ indices ]( size_t first, size_t count, uint8_t const * src, uint8_t const * end )
+        {
+            uint32_t prev = 0;
+
+            for ( size_t i = first; i < first + count; ++i )
+            {
+                uint32_t zz = 0;
+
+                for ( int shift = 0; ; shift += 7 )
+                {
+                    if ( src == end || shift > 28 )
+                        return false;
+
+                    uint8_t const byte = *src++;
+                    zz |= static_cast< uint32_t >( byte & 0x7f ) << shift;
+
+                    if ( ! ( byte & 0x80 ) )
+                        break;
+                }
+
+                prev += ( zz >> 1 ) ^ ( 0u - ( zz & 1 ) );
+                indices[ i ] = prev;
+            }
+
+            return src == end;
+        } );
+    }
+
+    /// @brief Whether size encoded bytes can hold numVertices, from the chunk table
+    ///        and the smallest possible blocks. Lets callers check untrusted counts
+    ///        before they allocate the output, which is at most 16 times size.
+    static bool
+    canHoldVertices( size_t numVertices, size_t stride, uint8_t const * data, size_t size )
+    {
+        size_t const numBlocks = ( numVertices + BlockSize - 1 ) / BlockSize;
+
+        return hasChunkTable( numVertices, ChunkVertices, data, size, stride * numBlocks );
+    }
+
+    /// @brief As canHoldVertices(), every index takes at least one byte.
+    static bool
+    canHoldIndices( size_t numIndices, uint8_t const * data, size_t size )
+    {
+        return hasChunkTable( numIndices, ChunkIndices, data, size, numIndices );
+    }
+
+private:
+
+    /// @brief The chunk table matches count and at least minPayload bytes follow it.
+    static bool
+    hasChunkTable( size_t count, size_t chunkSize, uint8_t const * data, size_t size, size_t minPayload )
+    {
+        size_t const numChunks = ( count + chunkSize - 1 ) / chunkSize;
+
+        return size >= sizeof( uint32_t ) && readU32( data ) == numChunks
+            && ( size - sizeof( uint32_t ) ) / sizeof( uint32_t ) >= numChunks
+            && size - sizeof( uint32_t ) * ( numChunks + 1 ) >= minPayload;
+    }
+
+    template< class F >
+    static std::vector< uint8_t >
+    encodeChunks( size_t count, size_t chunkSize, F && encodeChunk )
+    {
+        size_t const numChunks = ( count + chunkSize - 1 ) / chunkSize;
+
+        std::vector< uint8_t > out( sizeof( uint32_t ) * ( numChunks + 1 ) );
+        writeU32( out.data(), static_cast< uint32_t >( numChunks ) );
+
+        size_t const dataStart = out.size();
+
+        for ( size_t c = 0; c < numChunks; ++c )
+        {
+            size_t const first = c * chunkSize;
+            encodeChunk( first, std::min( chunkSize, count - first ), out );
+
+            writeU32( out.data() + sizeof( uint32_t ) * ( c + 1 ), static_cast< uint32_t >( out.size() - dataStart ) );
+        }
+
+        return out;
+    }
+
+    template< class F >
+    static bool
+    decodeChunks( size_t count, size_t chunkSize, uint8_t const * data, size_t size, common::ThreadPool * pool, F && decodeChunk )
+    {
+        size_t const numChunks = ( count + chunkSize - 1 ) / chunkSize;
+
+        if ( size < sizeof( uint32_t ) || readU32( data ) != numChunks || size < sizeof( uint32_t ) * ( numChunks + 1 ) )
+            return false;
+
+        uint8_t const * const table = data + sizeof( uint32_t );
+        uint8_t const * const payload = table + sizeof( uint32_t ) * numChunks;
+        size_t const payloadSize = size - sizeof( uint32_t ) * ( numChunks + 1 );
+
+        std::atomic< bool > ok( true );
+
+        auto decodeRange = [ & ]( size_t begin, size_t end )
+        {
+            for ( size_t c = begin; c < end; ++c )
+            {
+                size_t const from = c == 0 ? 0 : readU32( table + sizeof( uint32_t ) * ( c - 1 ) );
+                size_t const to = readU32( table + sizeof( uint32_t ) * c );
+                size_t const first = c * chunkSize;
+
+                if ( from > to || to > payloadSize || ! decodeChunk( first, std::min( chunkSize, count - first ), payload + from, payload + to ) )
+                    ok = false;
+            }
+        };
+
+        if ( pool == nullptr )
+            decodeRange( 0, numChunks );
+        else
+            pool->parallelFor( numChunks, 1, decodeRange );
+
+        return ok;
+    }
+
+    static bool
+    decodeVertexChunk( uint8_t * dst, size_t count, size_t stride, uint8_t const * src, uint8_t const * end )
+    {
+        alignas( 16 ) uint8_t values[ BlockSize ];
+
+        for ( size_t k = 0; k < stride; ++k )
+        {
+            uint8_t prev = 0;
+
+            for ( size_t b = 0; b < count; b += BlockSize )
+            {
+                if ( src == end || *src > 8 || end - src < 1 + 2 * *src )
+                    return false;
+
+                uint8_t const bits = *src++;
+
+                decodeBlock( src, bits, prev, values );
+                src += 2 * bits;
+                prev = values[ BlockSize - 1 ];
+
+                size_t const n = std::min( BlockSize, count - b );
+
+                for ( size_t i = 0; i < n; ++i )
+                    dst[ ( b + i ) * stride + k ] = values[ i ];
+            }
+        }
+
+        return src == end;
+    }
+
+    /// @brief Expands the bits bitplanes at planes into the 16 values of a lane
+    ///        block, un-zigzagged and prefix summed starting from prev.
+    static void
+    decodeBlock( uint8_t const * planes, uint8_t bits, uint8_t prev, uint8_t * values )
+    {
+#if defined( __SSE2__ )
+        // lane i of a bitplane is bit ( i % 8 ) of byte ( i / 8 )
+        __m128i const select = _mm_set_epi8( -128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1 );
+        __m128i const one = _mm_set1_epi8( 1 );
+        __m128i const low7 = _mm_set1_epi8( 0x7f );
+
+        __m128i zz = _mm_setzero_si128();
+        __m128i bit = one;
+
+        for ( uint8_t p = 0; p < bits; ++p, planes += 2 )
+        {
+            // spread the plane bytes over the lanes, 0 to 7 and 8 to 15
+            __m128i plane = _mm_cvtsi32_si128( planes[ 0 ] | planes[ 1 ] << 8 );
+            plane = _mm_unpacklo_epi8( plane, plane );
+            plane = _mm_unpacklo_epi16( plane, plane );
+            plane = _mm_unpacklo_epi32( plane, plane );
+
+            // then keep the bit of each lane
+            __m128i const set = _mm_cmpeq_epi8( _mm_and_si128( plane, select ), select );
+
+            zz = _mm_or_si128( zz, _mm_and_si128( set, bit ) );
+            bit = _mm_add_epi8( bit, bit );
+        }
+
+        // zigzag: ( zz >> 1 ) ^ -( zz & 1 )
+        __m128i d = _mm_xor_si128( _mm_and_si128( _mm_srli_epi16( zz, 1 ), low7 )
+                                 , _mm_cmpeq_epi8( _mm_and_si128( zz, one ), one ) );
+
+        // prefix sum over the block, continuing from the previous one
+        d = _mm_add_epi8( d, _mm_slli_si128( d, 1 ) );
+        d = _mm_add_epi8( d, _mm_slli_si128( d, 2 ) );
+        d = _mm_add_epi8( d, _mm_slli_si128( d, 4 ) );
+        d = _mm_add_epi8( d, _mm_slli_si128( d, 8 ) );
+        d = _mm_add_epi8( d, _mm_set1_epi8( static_cast< char >( prev ) ) );
+
+        _mm_storeu_si128( reinterpret_cast< __m128i * >( values ), d );
+#else
+        for ( size_t i = 0; i < BlockSize; ++i )
+        {
+            uint8_t zz = 0;
+
+            for ( uint8_t p = 0; p < bits; ++p )
+                zz |= static_cast< uint8_t >( ( ( planes[ 2 * p + i / 8 ] >> ( i % 8 ) ) & 1 ) << p );
+
+            prev = static_cast< uint8_t >( prev + ( ( zz >> 1 ) ^ -( zz & 1 ) ) );
+            values[ i ] = prev;
+        }
+#endif
+    }
+
+    static void
+    writeU32( uint8_t * p, uint32_t v )
+    { std::memcpy( p, &v, sizeof( v ) ); }
+
+    static uint32_t
+    readU32( uint8_t const * p )
+    {
+        uint32_t v;
+        std::memcpy( &v, p, sizeof( v ) );
+        return v;
+    }
+};
+
+} // - namespace geometry
+} // - namespace noo
+
+
+#endif /* NOO_GEOMETRY_MESHCODEC_HPP_INCLUDED */
@@ -0,0 +1,520 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: MeshOptimizer.hpp                                                ///
+/// @brief: Reorders triangles and vertices of indexed meshes for the GPU.  ///
+///         Tipsify for the post-transform vertex cache, cluster sorting    ///
+///         against overdraw, first-use order for vertex fetch. Also        ///
+///         measures the cache miss ratios and the overdraw of a mesh.      ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_GEOMETRY_MESHOPTIMIZER_HPP__INCLUDED__
+#define NOO_GEOMETRY_MESHOPTIMIZER_HPP__INCLUDED__
+
+
+/// Includes
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+
+namespace noo {
+namespace geometry {
+
+class MeshOptimizer
+{
+public:
+
+    /// @brief Size of the FIFO cache the reordering optimizes for and the analysis simulates.
+    static constexpr int CacheSize = 16;
+
+    struct VertexCacheStats
+    {
+        size_t NumTriangles = 0;
+        size_t NumVertices = 0;
+        size_t NumMisses = 0;
+
+        /// @brief Average cache miss ratio, transformed vertices per triangle (0.5 is ideal).
+        float
+        getAcmr() const
+        { return NumTriangles > 0 ? static_cast< float >( NumMisses ) / NumTriangles : 0.0f; }
+
+        /// @brief Average transform to vertex ratio, transformed vertices per vertex (1 is ideal).
+        float
+        getAtvr() const
+        { return NumVertices > 0 ? static_cast< float >( NumMisses ) / NumVertices : 0.0f; }
+
+        VertexCacheStats &
+        operator+=( VertexCacheStats const & o )
+        {
+            NumTriangles += o.NumTriangles;
+            NumVertices += o.NumVertices;
+            NumMisses += o.NumMisses;
+            return *this;
+        }
+    };
+
+    struct OverdrawStats
+    {
+        size_t PixelsCovered = 0;
+        size_t PixelsShaded = 0;
+
+        /// @brief Fragments shaded per covered pixel (1 is ideal).
+        float
+        getOverdraw() const
+        { return PixelsCovered > 0 ? static_cast< float >( PixelsShaded ) / PixelsCovered : 0.0f; }
+
+        OverdrawStats &
+        operator+=( OverdrawStats const & o )
+        {
+            PixelsCovered += o.PixelsCovered;
+            PixelsShaded += o.PixelsShaded;
+            return *this;
+        }
+    };
+
+    /// @brief Reorders the triangles for the vertex cache (Tipsify, Sander et al. 2007).
+    /// @param outClusters If given, receives the first index of every run of triangles
+    ///        which started at a dead end, the hard boundaries for optimizeOverdraw().
+    static void
+    optimizeVertexCache( std::vector< uint32_t > & indices, size_t numVertices, std::vector< size_t > * outClusters = nullptr )
+    {
+        size_t const numTriangles = indices.size() / 3;
+
+        if ( numTriangles == 0 )
+            return;
+
+        std::vector< uint32_t > adjOffset;
+        std::vector< uint32_t > adjacency;
+        buildAdjacency( indices, numVertices, adjOffset, adjacency );
+
+        std::vector< uint32_t > live( numVertices );
+
+        for ( size_t v = 0; v < numVertices; ++v )
+            live[ v ] = adjOffset[ v + 1 ] - adjOffset[ v ];
+
+        std::vector< uint32_t > cacheTime( numVertices, 0 );
+        std::vector< uint8_t > emitted( numTriangles, 0 );
+        std::vector< uint32_t > deadEnd;
+        std::vector< uint32_t > candidates;
+
+        std::vector< uint32_t > result;
+        result.reserve( indices.size() );
+
+        if ( outClusters != nullptr )
+            outClusters->clear();
+
+        uint32_t time = CacheSize + 1;
+        size_t cursor = 0;
+        int64_t fanning = indices[ 0 ];
+        bool fromDeadEnd = true;
+
+        while ( fanning >= 0 )
+        {
+            if ( fromDeadEnd && outClusters != nullptr )
+                outClusters->push_back( result.size() );
+
+            candidates.clear();
+
+            for ( uint32_t i = adjOffset[ fanning ]; i < adjOffset[ fanning + 1 ]; ++i )
+            {
+                uint32_t const t = adjacency[ i ];
+
+                if ( emitted[ t ] )
+                    continue;
+
+                emitted[ t ] = 1;
+
+                for ( int k = 0; k < 3; ++k )
+                {
+                    uint32_t const v = indices[ 3 * t + k ];
+
+                    result.push_back( v );
+                    deadEnd.push_back( v );
+                    candidates.push_back( v );
+                    --live[ v ];
+
+                    if ( time - cacheTime[ v ] > CacheSize )
+                        cacheTime[ v ] = time++;
+                }
+            }
+
+            // the candidate which stays longest in the cache, if its fan still fits
+            fanning = -1;
+            fromDeadEnd = false;
+            int best = -1;
+
+            for ( uint32_t v : candidates )
+            {
+                if ( live[ v ] == 0 )
+                    continue;
+
+                int priority = 0;
+
+                if ( time - cacheTime[ v ] + 2 * live[ v ] <= CacheSize )
+                    priority = static_cast< int >( time - cacheTime[ v ] );
+
+                if ( priority > best )
+                {
+                    best = priority;
+                    fanning = v;
+                }
+            }
+
+            if ( fanning >= 0 )
+                continue;
+
+            fromDeadEnd = true;
+
+            while ( ! deadEnd.empty() && fanning < 0 )
+            {
+                uint32_t const v = deadEnd.back();
+                deadEnd.pop_back();
+
+                if ( live[ v ] > 0 )
+                    fanning = v;
+            }
+
+            while ( cursor < numVertices && fanning < 0 )
+            {
+                if ( live[ cursor ] > 0 )
+                    fanning = static_cast< int64_t >( cursor );
+
+                ++cursor;
+            }
+        }
+
+        indices.swap( result );
+    }
+
+    /// @brief Reorders clusters of triangles so outward facing ones come first, which
+    ///        lets the depth test reject more of the rest (Sander et al. 2007). Clusters
+    ///        are split further as long as that costs less than threshold in ACMR.
+    /// @param clusters Hard boundaries from optimizeVertexCache().
+    static void
+    optimizeOverdraw( std::vector< uint32_t > & indices, std::vector< glm::vec3 > const & positions
+                    , std::vector< size_t > const & clusters, float threshold = 1.05f )
+    {
+        if ( indices.empty() || clusters.empty() )
+            return;
+
+        std::vector< size_t > starts = splitClusters( indices, positions.size(), clusters, threshold );
+
+        glm::vec3 meshCenter( 0.0f );
+
+        for ( uint32_t i : indices )
+            meshCenter += positions[ i ];
+
+        meshCenter /= static_cast< float >( indices.size() );
+
+        struct Cluster
+        {
+            size_t Begin;
+            size_t End;
+            float Key;
+        };
+
+        std::vector< Cluster > sorted;
+        sorted.reserve( starts.size() );
+
+        for ( size_t c = 0; c < starts.size(); ++c )
+        {
+            size_t const begin = starts[ c ];
+            size_t const end = c + 1 < starts.size() ? starts[ c + 1 ] : indices.size();
+
+            glm::vec3 center( 0.0f );
+            glm::vec3 normal( 0.0f );
+            float area = 0.0f;
+
+            for ( size_t i = begin; i < end; i += 3 )
+            {
+                glm::vec3 const & p0 = positions[ indices[ i ] ];
+                glm::vec3 const & p1 = positions[ indices[ i + 1 ] ];
+                glm::vec3 const & p2 = positions[ indices[ i + 2 ] ];
+
+                glm::vec3 const n = glm::cross( p1 - p0, p2 - p0 );
+                float const a = glm::length( n );
+
+                center += ( p0 + p1 + p2 ) * ( a / 3.0f );
+                normal += n;
+                area += a;
+            }
+
+            center = area > 0.0f ? center / area : positions[ indices[ begin ] ];
+            float const len = glm::length( normal );
+
+            sorted.push_back( { begin, end, len > 0.0f ? glm::dot( center - meshCenter, normal / len ) : 0.0f } );
+        }
+
+        std::stable_sort( sorted.begin(), sorted.end(), []( Cluster const & l, Cluster const & r ) { return l.Key > r.Key; } );
+
+        std::vector< uint32_t > result;
+        result.reserve( indices.size() );
+
+        for ( auto const & c : sorted )
+            result.insert( result.end(), indices.begin() + c.Begin, indices.begin() + c.End );
+
+        indices.swap( result );
+    }
+
+    /// @brief Vertex order of first use by indices, unused vertices go to the end.
+    /// @return remap[ old ] = new, for remapIndices() and remapVertices().
+    static std::vector< uint32_t >
+    optimizeVertexFetch( std::vector< uint32_t > const & indices, size_t numVertices )
+    {
+        uint32_t const unused = std::numeric_limits< uint32_t >::max();
+        std::vector< uint32_t > remap( numVertices, unused );
+        uint32_t next = 0;
+
+        for ( uint32_t i : indices )
+        {
+            if ( remap[ i ] == unused )
+                remap[ i ] = next++;
+        }
+
+        for ( auto & r : remap )
+        {
+            if ( r == unused )
+                r = next++;
+        }
+
+        return remap;
+    }
+
+    static void
+    remapIndices( std::vector< uint32_t > & indices, std::vector< uint32_t > const & remap )
+    {
+        for ( auto & i : indices )
+            i = remap[ i ];
+    }
+
+    template< class T >
+    static void
+    remapVertices( std::vector< T > & vertices, std::vector< uint32_t > const & remap )
+    {
+        std::vector< T > result( vertices.size() );
+
+        for ( size_t v = 0; v < vertices.size(); ++v )
+            result[ remap[ v ] ] = vertices[ v ];
+
+        vertices.swap( result );
+    }
+
+    /// @brief Simulates a FIFO cache of cacheSize entries.
+    static VertexCacheStats
+    analyzeVertexCache( std::vector< uint32_t > const & indices, size_t numVertices, int cacheSize = CacheSize )
+    {
+        VertexCacheStats stats;
+        stats.NumTriangles = indices.size() / 3;
+
+        // a vertex is cached if it entered less than cacheSize misses ago
+        std::vector< int64_t > entered( numVertices, std::numeric_limits< int64_t >::min() / 2 );
+        std::vector< uint8_t > used( numVertices, 0 );
+
+        for ( uint32_t i : indices )
+        {
+            if ( static_cast< int64_t >( stats.NumMisses ) - entered[ i ] >= cacheSize )
+                entered[ i ] = static_cast< int64_t >( stats.NumMisses++ );
+
+            stats.NumVertices += used[ i ] ? 0 : 1;
+            used[ i ] = 1;
+        }
+
+        return stats;
+    }
+
+    /// @brief Rasterizes the mesh orthographically from the six axis directions with
+    ///        back face culling and a depth test, counting shaded against covered pixels.
+    static OverdrawStats
+    analyzeOverdraw( std::vector< uint32_t > const & indices, std::vector< glm::vec3 > const & positions, int resolution = 256 )
+    {
+        OverdrawStats stats;
+
+        if ( indices.empty() )
+            return stats;
+
+        glm::vec3 lo( std::numeric_limits< float >::max() );
+        glm::vec3 hi( -std::numeric_limits< float >::max() );
+
+        for ( uint32_t i : indices )
+        {
+            lo = glm::min( lo, positions[ i ] );
+            hi = glm::max( hi, positions[ i ] );
+        }
+
+        float const extent = std::max( { hi.x - lo.x, hi.y - lo.y, hi.z - lo.z, 1.0e-6f } );
+        float const scale = ( resolution - 1 ) / extent;
+
+        std::vector< float > depth;
+        std::vector< glm::vec3 > screen( positions.size() );
+
+        for ( int view = 0; view < 6; ++view )
+        {
+            glm::vec3 forward( 0.0f );
+            forward[ view / 2 ] = view % 2 ? 1.0f : -1.0f;
+
+            glm::vec3 const up = view / 2 == 1 ? glm::vec3( 0, 0, 1 ) : glm::vec3( 0, 1, 0 );
+            glm::vec3 const right = glm::cross( forward, up );
+
+            for ( size_t v = 0; v < positions.size(); ++v )
+            {
+                glm::vec3 const p = positions[ v ] - lo;
+                screen[ v ] = glm::vec3( glm::dot( p, right ), glm::dot( p, up ), glm::dot( p, forward ) ) * scale;
+            }
+
+            // right may point away from the box, move into [0, resolution)
+            float const offsetX = glm::dot( hi - lo, right ) < 0.0f ? -glm::dot( hi - lo, right ) * scale : 0.0f;
+            float const offsetY = glm::dot( hi - lo, up ) < 0.0f ? -glm::dot( hi - lo, up ) * scale : 0.0f;
+
+            depth.assign( static_cast< size_t >( resolution ) * resolution, std::numeric_limits< float >::max() );
+
+            for ( size_t t = 0; t + 2 < indices.size(); t += 3 )
+            {
+                glm::vec3 v0 = screen[ indices[ t ] ];
+                glm::vec3 v1 = screen[ indices[ t + 1 ] ];
+                glm::vec3 v2 = screen[ indices[ t + 2 ] ];
+
+                v0.x += offsetX; v1.x += offsetX; v2.x += offsetX;
+                v0.y += offsetY; v1.y += offsetY; v2.y += offsetY;
+
+                stats.PixelsShaded += rasterize( v0, v1, v2, resolution, depth );
+            }
+
+            for ( float d : depth )
+                stats.PixelsCovered += d < std::numeric_limits< float >::max() ? 1 : 0;
+        }
+
+        return stats;
+    }
+
+private:
+
+    static void
+    buildAdjacency( std::vector< uint32_t > const & indices, size_t numVertices
+                  , std::vector< uint32_t > & adjOffset, std::vector< uint32_t > & adjacency )
+    {
+        adjOffset.assign( numVertices + 1, 0 );
+
+        for ( uint32_t v : indices )
+            ++adjOffset[ v + 1 ];
+
+        for ( size_t v = 0; v < numVertices; ++v )
+            adjOffset[ v + 1 ] += adjOffset[ v ];
+
+        adjacency.resize( indices.size() );
+        std::vector< uint32_t > fill( adjOffset.begin(), adjOffset.end() - 1 );
+
+        for ( size_t i = 0; i < indices.size(); ++i )
+            adjacency[ fill[ indices[ i ] ]++ ] = static_cast< uint32_t >( i / 3 );
+    }
+
+    /// @brief Splits the hard clusters where the ACMR of the part so far is within
+    ///        threshold of the ACMR of the whole cluster.
+    /// @return The first index of every resulting cluster.
+    static std::vector< size_t >
+    splitClusters( std::vector< uint32_t > const & indices, size_t numVertices, std::vector< size_t > const & clusters, float threshold )
+    {
+        std::vector< size_t > starts;
+
+        // FIFO simulation with a global miss counter, entries older than base count as cold
+        std::vector< int64_t > entered( numVertices, std::numeric_limits< int64_t >::min() / 2 );
+        int64_t misses = 0;
+
+        auto access = [ &entered, &misses ]( uint32_t v, int64_t base )
+        {
+            if ( entered[ v ] < base || misses - entered[ v ] >= CacheSize )
+                entered[ v ] = misses++;
+        };
+
+        for ( size_t c = 0; c < clusters.size(); ++c )
+        {
+            size_t const begin = clusters[ c ];
+            size_t const end = c + 1 < clusters.size() ? clusters[ c + 1 ] : indices.size();
+
+            int64_t base = misses;
+
+            for ( size_t i = begin; i < end; ++i )
+                access( indices[ i ], base );
+
+            float const clusterAcmr = static_cast< float >( misses - base ) * 3.0f / ( end - begin );
+
+            starts.push_back( begin );
+            size_t partStart = begin;
+            base = misses;
+
+            for ( size_t i = begin; i < end; i += 3 )
+            {
+                for ( int k = 0; k < 3; ++k )
+                    access( indices[ i + k ], base );
+
+                size_t const numTriangles = ( i + 3 - partStart ) / 3;
+
+                if ( i + 3 < end && static_cast< float >( misses - base ) / numTriangles <= threshold * clusterAcmr )
+                {
+                    // the next part starts with a cold cache
+                    starts.push_back( i + 3 );
+                    partStart = i + 3;
+                    base = misses;
+                }
+            }
+        }
+
+        return starts;
+    }
+
+    /// @brief Counter clockwise triangles only, pixel centers, depth test less.
+    /// @return The number of pixels which passed the depth test.
+    static size_t
+    rasterize( glm::vec3 const & v0, glm::vec3 const & v1, glm::vec3 const & v2, int resolution, std::vector< float > & depth )
+    {
+        float const area = ( v1.x - v0.x ) * ( v2.y - v0.y ) - ( v2.x - v0.x ) * ( v1.y - v0.y );
+
+        if ( area <= 0.0f )
+            return 0;
+
+        int const minX = std::max( static_cast< int >( std::min( { v0.x, v1.x, v2.x } ) ), 0 );
+        int const minY = std::max( static_cast< int >( std::min( { v0.y, v1.y, v2.y } ) ), 0 );
+        int const maxX = std::min( static_cast< int >( std::max( { v0.x, v1.x, v2.x } ) ) + 1, resolution - 1 );
+        int const maxY = std::min( static_cast< int >( std::max( { v0.y, v1.y, v2.y } ) ) + 1, resolution - 1 );
+
+        size_t numShaded = 0;
+
+        for ( int y = minY; y <= maxY; ++y )
+        {
+            for ( int x = minX; x <= maxX; ++x )
+            {
+                float const px = x + 0.5f;
+                float const py = y + 0.5f;
+
+                float const w0 = ( v2.x - v1.x ) * ( py - v1.y ) - ( v2.y - v1.y ) * ( px - v1.x );
+                float const w1 = ( v0.x - v2.x ) * ( py - v2.y ) - ( v0.y - v2.y ) * ( px - v2.x );
+                float const w2 = ( v1.x - v0.x ) * ( py - v0.y ) - ( v1.y - v0.y ) * ( px - v0.x );
+
+                if ( w0 < 0.0f || w1 < 0.0f || w2 < 0.0f )
+                    continue;
+
+                float const z = ( w0 * v0.z + w1 * v1.z + w2 * v2.z ) / area;
+                float & d = depth[ static_cast< size_t >( y ) * resolution + x ];
+
+                if ( z < d )
+                {
+                    d = z;
+                    ++numShaded;
+                }
+            }
+        }
+
+        return numShaded;
+    }
+};
+
+} // - namespace geometry
+} // - namespace noo
+
+
+#endif /* NOO_GEOMETRY_MESHOPTIMIZER_HPP__INCLUDED__ */
@@ -0,0 +1,482 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: MeshSimplifier.hpp                                               ///
+/// @brief: Reduces the triangle count of an indexed mesh by collapsing     ///
+///         edges in the order of their quadric error. The result indexes   ///
+///         the original vertices, so levels of detail can share one        ///
+///         vertex buffer and only differ in their index ranges.            ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_GEOMETRY_MESHSIMPLIFIER_HPP__INCLUDED__
+#define NOO_GEOMETRY_MESHSIMPLIFIER_HPP__INCLUDED__
+
+
+/// Includes
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+
+namespace noo {
+namespace geometry {
+
+class MeshSimplifier
+{
+public:
+
+    struct Options
+    {
+        Options()
+            : LockBorder( true )
+            , MaxError( std::numeric_limits< float >::max() )
+        { }
+
+        /// @brief Vertices on open edges stay where they are, so holes and the
+        ///        outline of a mesh do not shrink and neighbouring meshes still fit.
+        bool LockBorder;
+
+        /// @brief Collapses with a larger error (model space distance) are not done.
+        float MaxError;
+    };
+
+    /// @brief Simplifies the triangles in indices to about targetIndexCount indices.
+    ///        Vertices sharing a position are treated as one, each corner of the
+    ///        result picks the vertex at its position whose normal fits the new
+    ///        triangle best, which keeps hard edges and flat shading intact.
+    /// @return The approximate deviation from the input surface in model space.
+    static float
+    simplify( std::vector< glm::vec3 > const & positions
+            , std::vector< glm::vec3 > const & normals
+            , std::vector< uint32_t > const & indices
+            , size_t targetIndexCount
+            , std::vector< uint32_t > & outIndices
+            , Options const & options = Options() )
+    {
+        outIndices.clear();
+
+        // one id per distinct position, wedges[ id ] are all vertices at that position
+        std::vector< uint32_t > posId;
+        std::vector< std::vector< uint32_t > > wedges;
+        std::vector< glm::vec3 > pos;
+        weldPositions( positions, posId, wedges, pos );
+
+        std::vector< uint32_t > tris;
+        tris.reserve( indices.size() );
+
+        for ( size_t i = 0; i + 2 < indices.size(); i += 3 )
+        {
+            uint32_t const a = posId[ indices[ i ] ], b = posId[ indices[ i + 1 ] ], c = posId[ indices[ i + 2 ] ];
+
+            if ( a != b && b != c && c != a )
+                tris.insert( tris.end(), { a, b, c } );
+        }
+
+        std::vector< Quadric > quadrics( pos.size() );
+
+        for ( size_t t = 0; t < tris.size(); t += 3 )
+        {
+            Quadric const q = Quadric::fromTriangle( pos[ tris[ t ] ], pos[ tris[ t + 1 ] ], pos[ tris[ t + 2 ] ] );
+
+            for ( int k = 0; k < 3; ++k )
+                quadrics[ tris[ t + k ] ] += q;
+        }
+
+        std::vector< uint8_t > locked;
+        lockVertices( tris, pos.size(), options.LockBorder, locked );
+
+        float const maxCost = options.MaxError < std::sqrt( std::numeric_limits< float >::max() )
+                            ? options.MaxError * options.MaxError : std::numeric_limits< float >::max();
+
+        float resultError = 0.0f;
+
+        while ( tris.size() > targetIndexCount )
+        {
+            size_t const numCollapsed = collapsePass( pos, quadrics, locked, tris, ( tris.size() - targetIndexCount ) / 3, maxCost, resultError );
+
+            if ( numCollapsed == 0 )
+                break;
+        }
+
+        pickWedges( normals, wedges, pos, tris, outIndices );
+
+        return std::sqrt( resultError );
+    }
+
+private:
+
+    /// @brief Plane quadric, the sum of squared distances to a set of area weighted planes.
+    struct Quadric
+    {
+        double A2 = 0, B2 = 0, C2 = 0, D2 = 0;
+        double AB = 0, AC = 0, AD = 0, BC = 0, BD = 0, CD = 0;
+        double Weight = 0;
+
+        static Quadric
+        fromTriangle( glm::vec3 const & p0, glm::vec3 const & p1, glm::vec3 const & p2 )
+        {
+            glm::vec3 const n = glm::cross( p1 - p0, p2 - p0 );
+            float const len = glm::length( n );
+
+            Quadric q;
+
+            if ( len <= 0.0f )
+                return q;
+
+            double const a = n.x / len, b = n.y / len, c = n.z / len;
+            double const d = -( a * p0.x + b * p0.y + c * p0.z );
+            double const w = 0.5 * len;
+
+            q.A2 = w * a * a; q.B2 = w * b * b; q.C2 = w * c * c; q.D2 = w * d * d;
+            q.AB = w * a * b; q.AC = w * a * c; q.AD = w * a * d;
+            q.BC = w * b * c; q.BD = w * b * d; q.CD = w * c * d;
+            q.Weight = w;
+
+            return q;
+        }
+
+        Quadric &
+        operator+=( Quadric const & o )
+        {
+            A2 += o.A2; B2 += o.B2; C2 += o.C2; D2 += o.D2;
+            AB += o.AB; AC += o.AC; AD += o.AD; BC += o.BC; BD += o.BD; CD += o.CD;
+            Weight += o.Weight;
+            return *this;
+        }
+
+        /// @brief Mean squared distance of p to the planes.
+        double
+        error( glm::vec3 const & p ) const
+        {
+            double const x = p.x, y = p.y, z = p.z;
+
+            double const e = A2 * x * x + B2 * y * y + C2 * z * z + D2
+                           + 2.0 * ( AB * x * y + AC * x * z + AD * x + BC * y * z + BD * y + CD * z );
+
+            return Weight > 0.0 ? std::max( e, 0.0 ) / Weight : 0.0;
+        }
+    };
+
+    struct Collapse
+    {
+        uint32_t From;
+        uint32_t To;
+        float Cost;
+    };
+
+    static void
+    weldPositions( std::vector< glm::vec3 > const & positions
+                 , std::vector< uint32_t > & posId
+                 , std::vector< std::vector< uint32_t > > & wedges
+                 , std::vector< glm::vec3 > & pos )
+    {
+        struct Hash
+        {
+            size_t
+            operator()( glm::vec3 const & p ) const
+            {
+                // + 0 turns -0 into 0, they compare equal and need the same hash
+                float const c[ 3 ] = { p.x + 0.0f, p.y + 0.0f, p.z + 0.0f };
+                uint32_t bits[ 3 ];
+                std::memcpy( bits, c, sizeof( bits ) );
+                return ( bits[ 0 ] * 73856093u ) ^ ( bits[ 1 ] * 19349663u ) ^ ( bits[ 2 ] * 83492791u );
+            }
+        };
+
+        std::unordered_map< glm::vec3, uint32_t, Hash > ids;
+        ids.reserve( positions.size() );
+
+        posId.resize( positions.size() );
+
+        for ( uint32_t v = 0; v < positions.size(); ++v )
+        {
+            auto const it = ids.emplace( positions[ v ], static_cast< uint32_t >( pos.size() ) );
+
+            if ( it.second )
+            {
+                pos.push_back( positions[ v ] );
+                wedges.emplace_back();
+            }
+
+            posId[ v ] = it.first->second;
+            wedges[ it.first->second ].push_back( v );
+        }
+    }
+
+    /// @brief Locks the vertices of non-manifold edges and, optionally, of open edges.
+    static void
+    lockVertices( std::vector< uint32_t > const & tris, size_t numVertices, bool lockBorder, std::vector< uint8_t > & locked )
+    {
+        std::unordered_map< uint64_t, int > edgeUse;
+        edgeUse.reserve( tris.size() );
+
+        for ( size_t t = 0; t < tris.size(); t += 3 )
+        {
+            for ( int k = 0; k < 3; ++k )
+                ++edgeUse[ edgeKey( tris[ t + k ], tris[ t + ( k + 1 ) % 3 ] ) ];
+        }
+
+        locked.assign( numVertices, 0 );
+
+        for ( auto const & e : edgeUse )
+        {
+            if ( e.second > 2 || ( lockBorder && e.second == 1 ) )
+            {
+                locked[ static_cast< uint32_t >( e.first >> 32 ) ] = 1;
+                locked[ static_cast< uint32_t >( e.first ) ] = 1;
+            }
+        }
+    }
+
+    static uint64_t
+    edgeKey( uint32_t a, uint32_t b )
+    {
+        return a < b ? ( uint64_t( a ) << 32 ) | b : ( uint64_t( b ) << 32 ) | a;
+    }
+
+    /// @brief Collapses a batch of the cheapest independent edges, at most about
+    ///        enough to remove maxTriangles triangles.
+    /// @return The number of collapsed edges.
+    static size_t
+    collapsePass( std::vector< glm::vec3 > const & pos
+                , std::vector< Quadric > & quadrics
+                , std::vector< uint8_t > const & locked
+                , std::vector< uint32_t > & tris
+                , size_t maxTriangles
+                , float maxCost
+                , float & resultError )
+    {
+        uint32_t const numVertices = static_cast< uint32_t >( pos.size() );
+
+        // vertex to triangle adjacency
+        std::vector< uint32_t > adjOffset( numVertices + 1, 0 );
+
+        for ( uint32_t v : tris )
+            ++adjOffset[ v + 1 ];
+
+        for ( uint32_t v = 0; v < numVertices; ++v )
+            adjOffset[ v + 1 ] += adjOffset[ v ];
+
+        std::vector< uint32_t > adjacency( tris.size() );
+        std::vector< uint32_t > fill( adjOffset.begin(), adjOffset.end() - 1 );
+
+        for ( size_t i = 0; i < tris.size(); ++i )
+            adjacency[ fill[ tris[ i ] ]++ ] = static_cast< uint32_t >( i / 3 );
+
+        // every edge once (interior edges appear in both directions), in the cheaper direction
+        std::vector< Collapse > candidates;
+        candidates.reserve( tris.size() / 2 );
+
+        for ( size_t t = 0; t < tris.size(); t += 3 )
+        {
+            for ( int k = 0; k < 3; ++k )
+            {
+                uint32_t const a = tris[ t + k ];
+                uint32_t const b = tris[ t + ( k + 1 ) % 3 ];
+
+                if ( a > b )
+                    continue;
+
+                if ( locked[ a ] && locked[ b ] )
+                    continue;
+
+                Quadric q = quadrics[ a ];
+                q += quadrics[ b ];
+
+                float const costAB = locked[ a ] ? std::numeric_limits< float >::max() : static_cast< float >( q.error( pos[ b ] ) );
+                float const costBA = locked[ b ] ? std::numeric_limits< float >::max() : static_cast< float >( q.error( pos[ a ] ) );
+
+                if ( costAB <= costBA )
+                    candidates.push_back( { a, b, costAB } );
+                else
+                    candidates.push_back( { b, a, costBA } );
+            }
+        }
+
+        std::sort( candidates.begin(), candidates.end(), []( Collapse const & l, Collapse const & r ) { return l.Cost < r.Cost; } );
+
+        std::vector< uint32_t > remap( numVertices );
+
+        for ( uint32_t v = 0; v < numVertices; ++v )
+            remap[ v ] = v;
+
+        // vertices whose fan changed this pass, their neighbours' tests would be stale
+        std::vector< uint8_t > touched( numVertices, 0 );
+
+        size_t numCollapsed = 0;
+        size_t numRemoved = 0;
+
+        for ( auto const & c : candidates )
+        {
+            if ( numRemoved >= maxTriangles || c.Cost > maxCost )
+                break;
+
+            if ( touched[ c.From ] || touched[ c.To ] )
+                continue;
+
+            int removed = 0;
+
+            if ( ! isCollapseValid( pos, tris, adjacency, adjOffset, c.From, c.To, removed ) )
+                continue;
+
+            remap[ c.From ] = c.To;
+            quadrics[ c.To ] += quadrics[ c.From ];
+            resultError = std::max( resultError, c.Cost );
+
+            for ( uint32_t i = adjOffset[ c.From ]; i < adjOffset[ c.From + 1 ]; ++i )
+            {
+                uint32_t const t = adjacency[ i ];
+                touched[ tris[ 3 * t ] ] = touched[ tris[ 3 * t + 1 ] ] = touched[ tris[ 3 * t + 2 ] ] = 1;
+            }
+
+            numRemoved += removed;
+            ++numCollapsed;
+        }
+
+        if ( numCollapsed == 0 )
+            return 0;
+
+        size_t out = 0;
+
+        for ( size_t t = 0; t < tris.size(); t += 3 )
+        {
+            uint32_t const a = remap[ tris[ t ] ], b = remap[ tris[ t + 1 ] ], c = remap[ tris[ t + 2 ] ];
+
+            if ( a == b || b == c || c == a )
+                continue;
+
+            tris[ out++ ] = a;
+            tris[ out++ ] = b;
+            tris[ out++ ] = c;
+        }
+
+        tris.resize( out );
+
+        return numCollapsed;
+    }
+
+    /// @brief Moving from onto to must keep the surface manifold and must not flip
+    ///        or degenerate any of the remaining triangles.
+    static bool
+    isCollapseValid( std::vector< glm::vec3 > const & pos
+                   , std::vector< uint32_t > const & tris
+                   , std::vector< uint32_t > const & adjacency
+                   , std::vector< uint32_t > const & adjOffset
+                   , uint32_t from, uint32_t to, int & removed )
+    {
+        removed = 0;
+
+        // link condition: the only common neighbours are the tips of the triangles on the edge
+        auto neighbours = [ & ]( uint32_t v, std::vector< uint32_t > & out )
+        {
+            out.clear();
+
+            for ( uint32_t i = adjOffset[ v ]; i < adjOffset[ v + 1 ]; ++i )
+            {
+                for ( int k = 0; k < 3; ++k )
+                {
+                    uint32_t const n = tris[ 3 * adjacency[ i ] + k ];
+
+                    if ( n != v && std::find( out.begin(), out.end(), n ) == out.end() )
+                        out.push_back( n );
+                }
+            }
+        };
+
+        std::vector< uint32_t > ringFrom, ringTo;
+        neighbours( from, ringFrom );
+        neighbours( to, ringTo );
+
+        int numShared = 0;
+        int numEdgeTriangles = 0;
+
+        for ( uint32_t n : ringFrom )
+            numShared += std::find( ringTo.begin(), ringTo.end(), n ) != ringTo.end() ? 1 : 0;
+
+        for ( uint32_t i = adjOffset[ from ]; i < adjOffset[ from + 1 ]; ++i )
+        {
+            uint32_t const * t = &tris[ 3 * adjacency[ i ] ];
+            numEdgeTriangles += ( t[ 0 ] == to || t[ 1 ] == to || t[ 2 ] == to ) ? 1 : 0;
+        }
+
+        if ( numShared != numEdgeTriangles )
+            return false;
+
+        for ( uint32_t i = adjOffset[ from ]; i < adjOffset[ from + 1 ]; ++i )
+        {
+            uint32_t const * t = &tris[ 3 * adjacency[ i ] ];
+
+            if ( t[ 0 ] == to || t[ 1 ] == to || t[ 2 ] == to )
+            {
+                ++removed;
+                continue;
+            }
+
+            int const k = t[ 0 ] == from ? 0 : t[ 1 ] == from ? 1 : 2;
+            glm::vec3 const & p1 = pos[ t[ ( k + 1 ) % 3 ] ];
+            glm::vec3 const & p2 = pos[ t[ ( k + 2 ) % 3 ] ];
+
+            glm::vec3 const before = glm::cross( p1 - pos[ from ], p2 - pos[ from ] );
+            glm::vec3 const after = glm::cross( p1 - pos[ to ], p2 - pos[ to ] );
+
+            // flipped, or turned by more than about 75 degrees
+            if ( glm::dot( before, after ) <= 0.25f * glm::length( before ) * glm::length( after ) )
+                return false;
+        }
+
+        return true;
+    }
+
+    /// @brief Maps the position triangles back to vertices, per corner the vertex
+    ///        whose normal is closest to the normal of the triangle.
+    static void
+    pickWedges( std::vector< glm::vec3 > const & normals
+              , std::vector< std::vector< uint32_t > > const & wedges
+              , std::vector< glm::vec3 > const & pos
+              , std::vector< uint32_t > const & tris
+              , std::vector< uint32_t > & outIndices )
+    {
+        outIndices.resize( tris.size() );
+
+        for ( size_t t = 0; t < tris.size(); t += 3 )
+        {
+            glm::vec3 const n = glm::cross( pos[ tris[ t + 1 ] ] - pos[ tris[ t ] ], pos[ tris[ t + 2 ] ] - pos[ tris[ t ] ] );
+
+            for ( int k = 0; k < 3; ++k )
+            {
+                auto const & w = wedges[ tris[ t + k ] ];
+                uint32_t best = w[ 0 ];
+
+                if ( w.size() > 1 && ! normals.empty() )
+                {
+                    float bestDot = -std::numeric_limits< float >::max();
+
+                    for ( uint32_t v : w )
+                    {
+                        float const d = glm::dot( normals[ v ], n );
+
+                        if ( d > bestDot )
+                        {
+                            bestDot = d;
+                            best = v;
+                        }
+                    }
+                }
+
+                outIndices[ t + k ] = best;
+            }
+        }
+    }
+};
+
+} // - namespace geometry
+} // - namespace noo
+
+
+#endif /* NOO_GEOMETRY_MESHSIMPLIFIER_HPP__INCLUDED__ */
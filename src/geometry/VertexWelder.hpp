@@ -0,0 +1,162 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: VertexWelder.hpp                                                 ///
+/// @brief: Merges vertices whose position and normal agree up to an        ///
+///         epsilon, and generates smooth normals for meshes without them.  ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_GEOMETRY_VERTEXWELDER_HPP__INCLUDED__
+#define NOO_GEOMETRY_VERTEXWELDER_HPP__INCLUDED__
+
+
+/// Includes
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+
+namespace noo {
+namespace geometry {
+
+class VertexWelder
+{
+public:
+
+    /// @brief Vertices are merged if both attributes quantize to the same grid cell.
+    ///        Attributes of the first vertex of a cell are kept.
+    /// @return The number of vertices left.
+    static size_t
+    weld( std::vector< glm::vec3 > & positions
+        , std::vector< glm::vec3 > & normals
+        , std::vector< uint32_t > & indices
+        , float positionEpsilon = 1.0e-5f
+        , float normalEpsilon = 1.0e-3f )
+    {
+        bool const hasNormals = normals.size() == positions.size();
+
+        std::unordered_map< Key, uint32_t, KeyHash > cells;
+        cells.reserve( positions.size() );
+
+        std::vector< uint32_t > remap( positions.size() );
+        uint32_t numUnique = 0;
+
+        for ( size_t v = 0; v < positions.size(); ++v )
+        {
+            Key key;
+            quantize( positions[ v ], positionEpsilon, &key[ 0 ] );
+
+            if ( hasNormals )
+                quantize( normals[ v ], normalEpsilon, &key[ 3 ] );
+            else
+                key[ 3 ] = key[ 4 ] = key[ 5 ] = 0;
+
+            auto const it = cells.emplace( key, numUnique );
+
+            if ( it.second )
+            {
+                // compact in place, the target slot is never behind v
+                positions[ numUnique ] = positions[ v ];
+
+                if ( hasNormals )
+                    normals[ numUnique ] = normals[ v ];
+
+                ++numUnique;
+            }
+
+            remap[ v ] = it.first->second;
+        }
+
+        positions.resize( numUnique );
+
+        if ( hasNormals )
+            normals.resize( numUnique );
+
+        for ( auto & i : indices )
+            i = remap[ i ];
+
+        return numUnique;
+    }
+
+    /// @brief Area weighted vertex normals. Vertices at the same position share the
+    ///        normal, so meshes split along seams are still shaded smoothly.
+    static void
+    generateNormals( std::vector< glm::vec3 > const & positions
+                   , std::vector< uint32_t > const & indices
+                   , std::vector< glm::vec3 > & normals
+                   , float positionEpsilon = 1.0e-5f )
+    {
+        std::unordered_map< Key, uint32_t, KeyHash > cells;
+        cells.reserve( positions.size() );
+
+        std::vector< uint32_t > group( positions.size() );
+
+        for ( size_t v = 0; v < positions.size(); ++v )
+        {
+            Key key{};
+            quantize( positions[ v ], positionEpsilon, &key[ 0 ] );
+            group[ v ] = cells.emplace( key, static_cast< uint32_t >( cells.size() ) ).first->second;
+        }
+
+        std::vector< glm::vec3 > sums( cells.size(), glm::vec3( 0.0f ) );
+
+        for ( size_t t = 0; t + 2 < indices.size(); t += 3 )
+        {
+            glm::vec3 const & p0 = positions[ indices[ t ] ];
+            glm::vec3 const & p1 = positions[ indices[ t + 1 ] ];
+            glm::vec3 const & p2 = positions[ indices[ t + 2 ] ];
+
+            // the length of the cross product is twice the area
+            glm::vec3 const n = glm::cross( p1 - p0, p2 - p0 );
+
+            for ( int k = 0; k < 3; ++k )
+                sums[ group[ indices[ t + k ] ] ] += n;
+        }
+
+        normals.resize( positions.size() );
+
+        for ( size_t v = 0; v < positions.size(); ++v )
+        {
+            glm::vec3 const & n = sums[ group[ v ] ];
+            float const len = glm::length( n );
+
+            normals[ v ] = len > 0.0f ? n / len : glm::vec3( 0.0f, 0.0f, 1.0f );
+        }
+    }
+
+private:
+
+    /// @brief Quantized position followed by the quantized normal.
+    using Key = std::array< int64_t, 6 >;
+
+    struct KeyHash
+    {
+        size_t
+        operator()( Key const & k ) const
+        {
+            uint64_t h = 1469598103934665603ull;
+
+            for ( int64_t v : k )
+                h = ( h ^ static_cast< uint64_t >( v ) ) * 1099511628211ull;
+
+            return static_cast< size_t >( h ^ ( h >> 32 ) );
+        }
+    };
+
+    static void
+    quantize( glm::vec3 const & v, float epsilon, int64_t * out )
+    {
+        for ( int c = 0; c < 3; ++c )
+            out[ c ] = static_cast< int64_t >( std::floor( v[ c ] / epsilon + 0.5f ) );
+    }
+};
+
+} // - namespace geometry
+} // - namespace noo
+
+
+#endif /* NOO_GEOMETRY_VERTEXWELDER_HPP__INCLUDED__ */
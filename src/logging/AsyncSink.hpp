@@ -0,0 +1,233 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: AsyncSink.hpp                                                    ///
+/// @brief: Writes log records on a background thread. Producers only move  ///
+///         a record into a lock-free bounded queue, the writer thread      ///
+///         drains it in batches and writes each batch with one call. A     ///
+///         full queue drops the record and counts it, unless the producer  ///
+///         asks to block.                                                  ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_LOGGING_ASYNCSINK_HPP_INCLUDED
+#define NOO_LOGGING_ASYNCSINK_HPP_INCLUDED
+
+
+/// Includes
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+#include "../common/BoundedQueue.hpp"
+
+
+namespace noo {
+namespace logging {
+
+class AsyncSink
+{
+public:
+
+    /// @brief Records the queue holds, a power of two.
+    static constexpr size_t Capacity = 4096;
+
+    struct Record
+    {
+        /// @brief Written before the text, must outlive the sink, e.g. a literal.
+        char const * Prefix = "";
+        char const * Suffix = "";
+
+        std::string Text;
+
+        /// @brief Appends the text in place of Text if set, called by the writer
+        ///        thread, so the producer does not pay for formatting.
+        std::function< void( std::string & ) > Format;
+
+        /// @brief Set once the record and everything before it is written.
+        std::promise< void > * Written = nullptr;
+    };
+
+    explicit AsyncSink( std::ostream & out )
+        : m_Out( out )
+        , m_Queue( Capacity )
+        , m_Writer( [ this ] { run(); } )
+    {}
+
+    AsyncSink( AsyncSink const & ) = delete;
+    AsyncSink & operator=( AsyncSink const & ) = delete;
+
+    /// @brief Writes everything queued before it returns.
+    ~AsyncSink()
+    {
+        flush();
+
+        m_Stop.store( true, std::memory_order_release );
+        wake();
+        m_Writer.join();
+    }
+
+    /// @return false if the queue was full, the record is dropped then.
+    bool
+    push( Record && record )
+    {
+        bool const pushed = m_Queue.tryPush( std::move( record ) );
+
+        if ( ! pushed )
+            m_Dropped.fetch_add( 1, std::memory_order_relaxed );
+
+        wake();
+
+        return pushed;
+    }
+
+    /// @brief Waits for room instead of dropping the record.
+    void
+    pushBlocking( Record && record )
+    {
+        while ( ! m_Queue.tryPush( std::move( record ) ) )
+        {
+            wake();
+            std::this_thread::yield();
+        }
+
+        wake();
+    }
+
+    /// @brief Blocks until every record pushed by this thread so far is written.
+    void
+    flush()
+    {
+        std::promise< void > written;
+        std::future< void > done = written.get_future();
+
+        Record marker;
+        marker.Written = &written;
+
+        pushBlocking( std::move( marker ) );
+
+        done.wait();
+    }
+
+    /// @brief Records lost to a full queue so far.
+    uint64_t
+    getNumDropped() const
+    { return m_Dropped.load( std::memory_order_relaxed ); }
+
+private:
+
+    /// @brief Wakes the writer if it sleeps, costs producers a fence otherwise.
+    void
+    wake()
+    {
+        // pairs with the fence in run(), either the writer sees the record or we see it sleeping
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+
+        if ( ! m_Sleeping.load( std::memory_order_relaxed ) )
+            return;
+
+        {
+            std::lock_guard< std::mutex > lock( m_WakeMutex );
+            m_Sleeping.store( false, std::memory_order_relaxed );
+        }
+
+        m_Wake.notify_one();
+    }
+
+    void
+    run()
+    {
+        std::string batch;
+        Record record;
+
+        for ( ;; )
+        {
+            batch.clear();
+
+            // the queue is popped in push order, so a flush marker comes after the records it waits for
+            std::promise< void > * written = nullptr;
+            size_t numRecords = 0;
+
+            while ( written == nullptr && numRecords++ < Capacity && m_Queue.tryPop( record ) )
+            {
+                batch += record.Prefix;
+
+                if ( record.Format )
+                {
+                    record.Format( batch );
+                    record.Format = nullptr;
+                }
+                else
+                {
+                    batch += record.Text;
+                }
+
+                batch += record.Suffix;
+                written = record.Written;
+            }
+
+            uint64_t const dropped = m_Dropped.load( std::memory_order_relaxed );
+
+            if ( dropped != m_DroppedReported )
+            {
+                batch += "(" + std::to_string( dropped - m_DroppedReported ) + " log messages dropped)\n";
+                m_DroppedReported = dropped;
+            }
+
+            if ( ! batch.empty() || written != nullptr )
+            {
+                m_Out.write( batch.data(), static_cast< std::streamsize >( batch.size() ) );
+                m_Out.flush();
+
+                if ( written != nullptr )
+                    written->set_value();
+
+                continue;
+            }
+
+            if ( m_Stop.load( std::memory_order_acquire ) )
+                return;
+
+            std::unique_lock< std::mutex > lock( m_WakeMutex );
+            m_Sleeping.store( true, std::memory_order_relaxed );
+            std::atomic_thread_fence( std::memory_order_seq_cst );
+
+            // records pushed before the producer could see m_Sleeping are visible now
+            if ( m_Queue.isEmpty() && m_Dropped.load( std::memory_order_relaxed ) == m_DroppedReported && ! m_Stop.load( std::memory_order_acquire ) )
+                m_Wake.wait( lock, [ this ] { return ! m_Sleeping.load( std::memory_order_relaxed ); } );
+
+            m_Sleeping.store( false, std::memory_order_relaxed );
+        }
+    }
+
+    std::ostream & m_Out;
+
+    common::BoundedQueue< Record > m_Queue;
+
+    std::atomic< uint64_t > m_Dropped{ 0 };
+
+    /// @brief Writer thread only.
+    uint64_t m_DroppedReported = 0;
+
+    std::atomic< bool > m_Stop{ false };
+
+    /// @brief Set by the writer before it waits for m_Wake, cleared by whoever wakes it.
+    std::atomic< bool > m_Sleeping{ false };
+
+    std::mutex m_WakeMutex;
+    std::condition_variable m_Wake;
+
+    /// @brief Last, it starts running once the members above are constructed.
+    std::thread m_Writer;
+};
+
+} // - namespace logging
+} // - namespace noo
+
+
+#endif /* NOO_LOGGING_ASYNCSINK_HPP_INCLUDED */
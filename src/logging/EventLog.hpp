@@ -0,0 +1,387 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: EventLog.hpp                                                     ///
+/// @brief: Binary log of typed events for per-frame telemetry. Records     ///
+///         have a fixed size and go straight into a memory-mapped file,    ///
+///         grown one chunk at a time. Reserving a record is one atomic     ///
+///         add, only the thread crossing into a new chunk maps it. The     ///
+///         tool noo_telemetry converts the file to CSV or JSON.            ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_LOGGING_EVENTLOG_HPP_INCLUDED
+#define NOO_LOGGING_EVENTLOG_HPP_INCLUDED
+
+
+/// Includes
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+
+namespace noo {
+namespace logging {
+
+enum class EFieldType : uint8_t
+{
+    INT,
+    FLOAT
+};
+
+/// @brief A record payload value, the event definition tells which member is set.
+union EventValue
+{
+    int64_t Int;
+    double Float;
+};
+
+/// @brief Layout of the file. The header page holds the file header and the
+///        event definitions, the records follow it in chunks.
+namespace eventlog {
+
+static constexpr char Magic[ 4 ] = { 'N', 'O', 'O', 'T' };
+static constexpr uint32_t Version = 1;
+
+static constexpr size_t MaxFields = 6;
+static constexpr size_t MaxEvents = 64;
+static constexpr size_t NameLength = 24;
+
+static constexpr size_t HeaderSize = 16384;
+static constexpr size_t ChunkSize = 1 << 20;
+
+struct FileHeader
+{
+    char Magic[ 4 ];
+    uint32_t Version;
+    uint32_t RecordSize;
+    uint32_t HeaderSize;
+
+    /// @brief Wall clock at open() in ns since the epoch, the records count from there.
+    uint64_t StartTimeNs;
+
+    uint32_t NumEvents;
+    uint32_t Reserved[ 9 ];
+};
+
+struct EventDefinition
+{
+    char Name[ NameLength ];
+    char FieldNames[ MaxFields ][ NameLength ];
+    EFieldType FieldTypes[ MaxFields ];
+    uint8_t NumFields;
+    uint8_t Reserved[ 17 ];
+};
+
+struct Record
+{
+    /// @brief Steady clock since open().
+    uint64_t TimeNs;
+
+    /// @brief 1 based index of the definition, 0 if the record was never written.
+    uint16_t Event;
+
+    /// @brief Small per process index of the writing thread.
+    uint16_t Thread;
+
+    uint32_t Reserved;
+
+    EventValue Values[ MaxFields ];
+};
+
+static_assert( sizeof( FileHeader ) == 64, "The file header is part of the format" );
+static_assert( sizeof( EventDefinition ) == 192, "Event definitions are part of the format" );
+static_assert( sizeof( Record ) == 64, "Records are part of the format" );
+static_assert( sizeof( FileHeader ) + MaxEvents * sizeof( EventDefinition ) <= HeaderSize, "The definitions have to fit the header" );
+static_assert( ChunkSize % sizeof( Record ) == 0 && HeaderSize % 4096 == 0, "Chunks are mapped at page offsets" );
+
+} // - namespace eventlog
+
+
+class EventLog
+{
+public:
+
+    using EventId = uint16_t;
+
+    struct Field
+    {
+        char const * Name;
+        EFieldType Type;
+    };
+
+    /// @brief The file grows up to this many chunks, later records are dropped.
+    static constexpr size_t MaxChunks = 4096;
+
+    static constexpr size_t RecordsPerChunk = eventlog::ChunkSize / sizeof( eventlog::Record );
+
+    EventLog() = default;
+
+    EventLog( EventLog const & ) = delete;
+    EventLog & operator=( EventLog const & ) = delete;
+
+    ~EventLog()
+    { close(); }
+
+    /// @brief Creates filename, or overwrites it.
+    bool
+    open( std::string const & filename )
+    {
+        close();
+
+        m_File = ::open( filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+
+        if ( m_File < 0 )
+            return false;
+
+        // allocated, not sparse, a full disk must not fault on the first store
+        if ( ::posix_fallocate( m_File, 0, eventlog::HeaderSize ) != 0 )
+        {
+            close();
+            return false;
+        }
+
+        void * header = ::mmap( nullptr, eventlog::HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_File, 0 );
+
+        if ( header == MAP_FAILED )
+        {
+            close();
+            return false;
+        }
+
+        m_Header = static_cast< uint8_t * >( header );
+        m_FileSize = eventlog::HeaderSize;
+        m_Chunks.reset( new Chunk[ MaxChunks ] );
+        m_Start = std::chrono::steady_clock::now();
+
+        eventlog::FileHeader & h = getFileHeader();
+        std::memcpy( h.Magic, eventlog::Magic, sizeof( h.Magic ) );
+        h.Version = eventlog::Version;
+        h.RecordSize = sizeof( eventlog::Record );
+        h.HeaderSize = eventlog::HeaderSize;
+        h.StartTimeNs = static_cast< uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::system_clock::now().time_since_epoch() ).count() );
+        h.NumEvents = 0;
+
+        return true;
+    }
+
+    /// @brief Cuts the file after the last record. No thread may record meanwhile.
+    void
+    close()
+    {
+        if ( m_Chunks )
+        {
+            for ( size_t c = 0; c < MaxChunks; ++c )
+            {
+                if ( eventlog::Record * records = m_Chunks[ c ].Records.load( std::memory_order_relaxed ) )
+                    ::munmap( records, eventlog::ChunkSize );
+            }
+
+            size_t const numRecords = std::min< uint64_t >( m_Next.load(), MaxChunks * RecordsPerChunk );
+
+            // if this fails the unused rest of the last chunk stays, its records read as never written
+            int const truncated = ::ftruncate( m_File, static_cast< off_t >( eventlog::HeaderSize + numRecords * sizeof( eventlog::Record ) ) );
+            static_cast< void >( truncated );
+        }
+
+        if ( m_Header != nullptr )
+            ::munmap( m_Header, eventlog::HeaderSize );
+
+        if ( m_File >= 0 )
+            ::close( m_File );
+
+        m_Header = nullptr;
+        m_File = -1;
+        m_Chunks.reset();
+        m_Next = 0;
+        m_Dropped = 0;
+    }
+
+    bool
+    isOpen() const
+    { return m_Header != nullptr; }
+
+    /// @brief Adds an event type with up to MaxFields payload values.
+    /// @return The id to record() it with, 0 if the log is not open or full.
+    EventId
+    defineEvent( char const * name, std::initializer_list< Field > fields )
+    {
+        std::lock_guard< std::mutex > lock( m_Mutex );
+
+        if ( ! isOpen() || getFileHeader().NumEvents == eventlog::MaxEvents || fields.size() > eventlog::MaxFields )
+            return 0;
+
+        eventlog::EventDefinition & d = getDefinitions()[ getFileHeader().NumEvents ];
+        std::strncpy( d.Name, name, eventlog::NameLength - 1 );
+
+        for ( Field const & f : fields )
+        {
+            std::strncpy( d.FieldNames[ d.NumFields ], f.Name, eventlog::NameLength - 1 );
+            d.FieldTypes[ d.NumFields++ ] = f.Type;
+        }
+
+        return static_cast< EventId >( ++getFileHeader().NumEvents );
+    }
+
+    /// @brief Appends a record of event, values in the order of its fields.
+    ///        Callable from any thread, does nothing if event is 0.
+    template< class... Args >
+    void
+    record( EventId event, Args... values )
+    {
+        static_assert( sizeof...( Args ) <= eventlog::MaxFields, "Too many values for a record" );
+
+        if ( event == 0 )
+            return;
+
+        std::array< EventValue, eventlog::MaxFields > const v = { { toValue( values )... } };
+        write( event, v );
+    }
+
+    /// @brief Records lost because the file reached its maximum size or could not grow.
+    uint64_t
+    getNumDropped() const
+    { return m_Dropped.load( std::memory_order_relaxed ); }
+
+private:
+
+    struct Chunk
+    {
+        std::atomic< eventlog::Record * > Records{ nullptr };
+        std::atomic< uint32_t > NumWritten{ 0 };
+    };
+
+    template< class T >
+    static EventValue
+    toValue( T value )
+    {
+        EventValue v;
+
+        if ( std::is_floating_point< T >::value )
+            v.Float = static_cast< double >( value );
+        else
+            v.Int = static_cast< int64_t >( value );
+
+        return v;
+    }
+
+    void
+    write( EventId event, std::array< EventValue, eventlog::MaxFields > const & values )
+    {
+        uint64_t const index = m_Next.fetch_add( 1, std::memory_order_relaxed );
+        size_t const c = static_cast< size_t >( index / RecordsPerChunk );
+
+        if ( c >= MaxChunks )
+        {
+            m_Dropped.fetch_add( 1, std::memory_order_relaxed );
+            return;
+        }
+
+        eventlog::Record * records = m_Chunks[ c ].Records.load( std::memory_order_acquire );
+
+        if ( records == nullptr )
+            records = mapChunk( c );
+
+        if ( records != nullptr )
+        {
+            eventlog::Record & r = records[ index % RecordsPerChunk ];
+            r.TimeNs = static_cast< uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - m_Start ).count() );
+            r.Event = event;
+            r.Thread = getThreadIndex();
+            r.Reserved = 0;
+            std::copy( values.begin(), values.end(), r.Values );
+        }
+        else
+        {
+            m_Dropped.fetch_add( 1, std::memory_order_relaxed );
+        }
+
+        // the last writer of a chunk leaves it to the page cache
+        if ( m_Chunks[ c ].NumWritten.fetch_add( 1, std::memory_order_acq_rel ) + 1 == RecordsPerChunk && records != nullptr )
+        {
+            m_Chunks[ c ].Records.store( nullptr, std::memory_order_relaxed );
+            ::munmap( records, eventlog::ChunkSize );
+        }
+    }
+
+    /// @brief Maps chunk c and the one after it, so the next crossing rarely waits.
+    eventlog::Record *
+    mapChunk( size_t c )
+    {
+        std::lock_guard< std::mutex > lock( m_Mutex );
+
+        for ( size_t i = c; i < std::min( c + 2, MaxChunks ); ++i )
+        {
+            if ( m_Chunks[ i ].Records.load( std::memory_order_relaxed ) != nullptr || m_Chunks[ i ].NumWritten.load() == RecordsPerChunk )
+                continue;
+
+            size_t const offset = eventlog::HeaderSize + i * eventlog::ChunkSize;
+
+            if ( m_FileSize < offset + eventlog::ChunkSize )
+            {
+                // a sparse chunk would raise SIGBUS on a full disk, a failed allocation only drops records
+                if ( ::posix_fallocate( m_File, static_cast< off_t >( offset ), static_cast< off_t >( eventlog::ChunkSize ) ) != 0 )
+                    break;
+
+                m_FileSize = offset + eventlog::ChunkSize;
+            }
+
+            void * data = ::mmap( nullptr, eventlog::ChunkSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_File, static_cast< off_t >( offset ) );
+
+            if ( data == MAP_FAILED )
+                break;
+
+            m_Chunks[ i ].Records.store( static_cast< eventlog::Record * >( data ), std::memory_order_release );
+        }
+
+        return m_Chunks[ c ].Records.load( std::memory_order_acquire );
+    }
+
+    static uint16_t
+    getThreadIndex()
+    {
+        static std::atomic< uint16_t > numThreads{ 0 };
+        thread_local uint16_t const index = numThreads.fetch_add( 1, std::memory_order_relaxed );
+
+        return index;
+    }
+
+    eventlog::FileHeader &
+    getFileHeader()
+    { return *reinterpret_cast< eventlog::FileHeader * >( m_Header ); }
+
+    eventlog::EventDefinition *
+    getDefinitions()
+    { return reinterpret_cast< eventlog::EventDefinition * >( m_Header + sizeof( eventlog::FileHeader ) ); }
+
+    int m_File = -1;
+    size_t m_FileSize = 0;
+    uint8_t * m_Header = nullptr;
+
+    std::unique_ptr< Chunk[] > m_Chunks;
+
+    std::atomic< uint64_t > m_Next{ 0 };
+    std::atomic< uint64_t > m_Dropped{ 0 };
+
+    std::chrono::steady_clock::time_point m_Start;
+
+    /// @brief Guards definitions and mapping, never taken to record into a mapped chunk.
+    std::mutex m_Mutex;
+};
+
+} // - namespace logging
+} // - namespace noo
+
+
+#endif /* NOO_LOGGING_EVENTLOG_HPP_INCLUDED */
@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: Format.hpp                                                       ///
+/// @brief: Minimal "{}" format strings for the logger. Every {} is         ///
+///         replaced by the next argument as written by operator<<, "{{"    ///
+///         and "}}" are literal braces.                                    ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_LOGGING_FORMAT_HPP_INCLUDED
+#define NOO_LOGGING_FORMAT_HPP_INCLUDED
+
+
+/// Includes
+#include <sstream>
+#include <string>
+
+
+namespace noo {
+namespace logging {
+
+namespace detail {
+
+/// @brief Appends fmt up to its next placeholder, or all of it.
+/// @return Behind the placeholder, nullptr if there was none.
+inline char const *
+appendLiteral( std::string & out, char const * fmt )
+{
+    for ( ; *fmt != '\0'; ++fmt )
+    {
+        if ( ( fmt[ 0 ] == '{' && fmt[ 1 ] == '{' ) || ( fmt[ 0 ] == '}' && fmt[ 1 ] == '}' ) )
+        {
+            out += *fmt++;
+            continue;
+        }
+
+        if ( fmt[ 0 ] == '{' && fmt[ 1 ] == '}' )
+            return fmt + 2;
+
+        out += *fmt;
+    }
+
+    return nullptr;
+}
+
+inline void
+appendArg( std::string & out, std::string const & arg )
+{ out += arg; }
+
+inline void
+appendArg( std::string & out, char const * arg )
+{ out += arg; }
+
+template< class T >
+void
+appendArg( std::string & out, T const & arg )
+{
+    std::ostringstream ss;
+    ss << arg;
+    out += ss.str();
+}
+
+inline void
+formatTo( std::string & out, char const * fmt )
+{
+    // placeholders without argument are kept as they are
+    while ( fmt != nullptr && ( fmt = appendLiteral( out, fmt ) ) != nullptr )
+        out += "{}";
+}
+
+template< class T, class... Args >
+void
+formatTo( std::string & out, char const * fmt, T const & arg, Args const &... args )
+{
+    fmt = appendLiteral( out, fmt );
+
+    // surplus arguments are dropped
+    if ( fmt == nullptr )
+        return;
+
+    appendArg( out, arg );
+    formatTo( out, fmt, args... );
+}
+
+} // - namespace detail
+
+/// @brief Appends fmt with its placeholders replaced by args to out.
+template< class... Args >
+void
+formatTo( std::string & out, char const * fmt, Args const &... args )
+{
+    detail::formatTo( out, fmt, args... );
+}
+
+template< class... Args >
+std::string
+format( char const * fmt, Args const &... args )
+{
+    std::string out;
+    detail::formatTo( out, fmt, args... );
+
+    return out;
+}
+
+} // - namespace logging
+} // - namespace noo
+
+
+#endif /* NOO_LOGGING_FORMAT_HPP_INCLUDED */
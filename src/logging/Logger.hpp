@@ -1,6 +1,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 /// @file: Logger.hpp                                                       ///
-/// @brief:                                                                 ///
+/// @brief: Colored console log. Optionally the messages are written by a  ///
+///         background thread, see AsyncSink, so logging never waits for    ///
+///         the terminal.                                                   ///
 /// @author: Ben Schneider                                                  ///
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -13,7 +15,62 @@
 
 
 /// Includes
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+#include "AsyncSink.hpp"
+#include "Format.hpp"
+
+
+/// @brief Calls of the NOO_LOG_* macros below this level are compiled out, the
+///        arguments are not even evaluated. 0 trace, 1 debug, 2 info, 3 warn, 4 error.
+#ifndef NOO_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define NOO_LOG_MIN_LEVEL 2
+#else
+#define NOO_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+/// @brief Logs fmt with its {} replaced by the arguments, if level passes the
+///        runtime filter. The arguments are evaluated only then.
+#define NOO_LOG( level, ... ) \
+    do { if ( noo::logging::Logger::isEnabled( level ) ) noo::logging::Logger::log( level, __VA_ARGS__ ); } while ( false )
+
+/// @brief Still type checks the call, but never evaluates the arguments.
+#define NOO_LOG_DISABLED( level, ... ) \
+    do { if ( false ) noo::logging::Logger::log( level, __VA_ARGS__ ); } while ( false )
+
+#if NOO_LOG_MIN_LEVEL <= 0
+#define NOO_LOG_TRACE( ... ) NOO_LOG( noo::logging::Logger::LogLevel::TRACE, __VA_ARGS__ )
+#else
+#define NOO_LOG_TRACE( ... ) NOO_LOG_DISABLED( noo::logging::Logger::LogLevel::TRACE, __VA_ARGS__ )
+#endif
+
+#if NOO_LOG_MIN_LEVEL <= 1
+#define NOO_LOG_DEBUG( ... ) NOO_LOG( noo::logging::Logger::LogLevel::DEBUG, __VA_ARGS__ )
+#else
+#define NOO_LOG_DEBUG( ... ) NOO_LOG_DISABLED( noo::logging::Logger::LogLevel::DEBUG, __VA_ARGS__ )
+#endif
+
+#if NOO_LOG_MIN_LEVEL <= 2
+#define NOO_LOG_INFO( ... ) NOO_LOG( noo::logging::Logger::LogLevel::INFO, __VA_ARGS__ )
+#else
+#define NOO_LOG_INFO( ... ) NOO_LOG_DISABLED( noo::logging::Logger::LogLevel::INFO, __VA_ARGS__ )
+#endif
+
+#if NOO_LOG_MIN_LEVEL <= 3
+#define NOO_LOG_WARN( ... ) NOO_LOG( noo::logging::Logger::LogLevel::WARN, __VA_ARGS__ )
+#else
+#define NOO_LOG_WARN( ... ) NOO_LOG_DISABLED( noo::logging::Logger::LogLevel::WARN, __VA_ARGS__ )
+#endif
+
+#define NOO_LOG_ERROR( ... ) NOO_LOG( noo::logging::Logger::LogLevel::ERROR, __VA_ARGS__ )
 
 /// Using declarations
 
@@ -22,6 +79,50 @@
 namespace noo {
 namespace logging {
 
+namespace detail {
+
+/// @brief How log() keeps an argument until it is formatted. C strings are
+///        copied, they may point into a buffer of the caller.
+template< class T >
+struct Capture
+{ using Type = typename std::decay< T >::type; };
+
+template<>
+struct Capture< char * >
+{ using Type = std::string; };
+
+template<>
+struct Capture< char const * >
+{ using Type = std::string; };
+
+template< class T, class = void >
+struct IsEqualityComparable : std::false_type {};
+
+template< class T >
+struct IsEqualityComparable< T, decltype( void( std::declval< T const & >() == std::declval< T const & >() ) ) > : std::true_type {};
+
+/// @brief Whether log() can tell repeats of captured arguments apart, tuple's
+///        own operator== does not say.
+template< class Tuple >
+struct AreComparable;
+
+template< class... T >
+struct AreComparable< std::tuple< T... > >
+{ static constexpr bool value = ( IsEqualityComparable< T >::value && ... ); };
+
+/// @brief Compares two tuples of type Tuple, never equal if their elements can't be compared.
+template< class Tuple >
+bool
+sameValues( void const * a, void const * b )
+{
+    if constexpr ( AreComparable< Tuple >::value )
+        return *static_cast< Tuple const * >( a ) == *static_cast< Tuple const * >( b );
+    else
+        return false;
+}
+
+} // - namespace detail
+
 class Logger
 {
 public:
@@ -50,11 +151,130 @@ public:
         }
     }
 
+    /// @brief Repeats of the last message of a thread within this interval are
+    ///        counted instead of written.
+    static constexpr std::chrono::seconds RepeatInterval{ 1 };
+
+    /// @brief Messages below level are discarded at runtime.
+    static void
+    setLevel( LogLevel ll )
+    { minLevel().store( ll, std::memory_order_relaxed ); }
+
+    static LogLevel
+    getLevel()
+    { return minLevel().load( std::memory_order_relaxed ); }
+
+    static bool
+    isEnabled( LogLevel ll )
+    { return ll >= getLevel(); }
+
+    /// @brief Logs fmt with every {} replaced by the next argument, see Format.hpp.
+    ///        fmt must stay valid, e.g. a literal, the arguments are copied.
+    ///        When logging asynchronously the text is formatted on the
+    ///        background thread. Prefer the NOO_LOG_* macros, they skip the
+    ///        call for disabled levels.
+    template< class... Args >
+    static void
+    log( LogLevel ll, char const * fmt, Args &&... args )
+    {
+        if ( ! isEnabled( ll ) )
+            return;
+
+        using Values = std::tuple< typename detail::Capture< typename std::decay< Args >::type >::Type... >;
+
+        // by value, the caller's arguments may be gone before the writer gets to them
+        auto values = std::make_shared< Values const >( std::forward< Args >( args )... );
+
+        // repeats are told by format and arguments, the text is not formatted here
+        bool const repeated = filterRepeat( ll, true, [ & ]( Repeats const & r )
+        {
+            return r.LastFormat == fmt && r.SameValues == &detail::sameValues< Values > && detail::sameValues< Values >( r.LastValues.get(), values.get() );
+        }, [ & ]( Repeats & r )
+        {
+            r.LastMsg.clear();
+            r.LastFormat = fmt;
+            r.LastValues = values;
+            r.SameValues = &detail::sameValues< Values >;
+        } );
+
+        if ( repeated )
+            return;
+
+        AsyncSink * sink = activeSink().load( std::memory_order_acquire );
+
+        if ( sink == nullptr )
+        {
+            std::string msg;
+            std::apply( [ & ]( auto const &... v ) { formatTo( msg, fmt, v... ); }, *values );
+            write( msg, ll, true, true );
+            return;
+        }
+
+        AsyncSink::Record record;
+        record.Prefix = logLevelToAnsiColor( ll );
+        record.Suffix = "\033[0m\n";
+        record.Format = [ fmt, values ]( std::string & out )
+        {
+            std::apply( [ & ]( auto const &... v ) { formatTo( out, fmt, v... ); }, *values );
+        };
+
+        submit( sink, std::move( record ), ll );
+    }
+
     static void
     print( std::string const & msg, LogLevel ll, bool lineBreak = true, bool flush = true )
     {
-        std::cout << logLevelToAnsiColor( ll ) << msg << "\033[0m" << ( lineBreak ? "\n" : "" );
-        if ( flush ) std::cout.flush();
+        if ( ! isEnabled( ll ) )
+            return;
+
+        bool const repeated = filterRepeat( ll, flush, [ & ]( Repeats const & r )
+        {
+            return r.LastFormat == nullptr && r.LastMsg == msg;
+        }, [ & ]( Repeats & r )
+        {
+            r.LastMsg = msg;
+            r.LastFormat = nullptr;
+            r.LastValues.reset();
+            r.SameValues = nullptr;
+        } );
+
+        if ( ! repeated )
+            write( msg, ll, lineBreak, flush );
+    }
+
+    /// @brief From now on messages are only queued by the logging thread and
+    ///        written by a background thread, errors still wait until written.
+    static void
+    enableAsync()
+    {
+        if ( ! asyncSink() )
+            asyncSink().reset( new AsyncSink( std::cout ) );
+
+        activeSink().store( asyncSink().get(), std::memory_order_release );
+    }
+
+    /// @brief Writes the queued messages and logs synchronously again. Call once
+    ///        no other thread logs anymore, e.g. at shutdown.
+    static void
+    disableAsync()
+    {
+        threadRepeats().writePending( true );
+
+        activeSink().store( nullptr, std::memory_order_release );
+        asyncSink().reset();
+    }
+
+    /// @brief Returns once the messages logged by this thread are written,
+    ///        including the count of a repeated last message.
+    static void
+    flush()
+    {
+        threadRepeats().writePending( false );
+
+        if ( AsyncSink * sink = activeSink().load( std::memory_order_acquire ) )
+            sink->flush();
+        else
+            std::cout.flush();
     }
 
     static void
@@ -86,6 +306,130 @@ public:
     {
         print( msg, LogLevel::ERROR, lineBreak );
     }
+
+private:
+
+    /// @brief The last message print() or log() wrote on a thread and how often
+    ///        it was repeated since. A count left at the exit of the thread is written.
+    struct Repeats
+    {
+        /// @brief Text of a print().
+        std::string LastMsg;
+
+        /// @brief Format and captured arguments of a log(), LastFormat is null after a print().
+        char const * LastFormat = nullptr;
+        std::shared_ptr< void const > LastValues;
+        bool ( * SameValues )( void const *, void const * ) = nullptr;
+
+        LogLevel LastLevel = LogLevel::TRACE;
+        uint32_t NumRepeats = 0;
+        std::chrono::steady_clock::time_point LastWritten;
+
+        ~Repeats()
+        { writePending( true ); }
+
+        void
+        writePending( bool flush )
+        {
+            if ( NumRepeats == 0 )
+                return;
+
+            write( "(last message repeated " + std::to_string( NumRepeats ) + " times)", LastLevel, true, flush );
+            NumRepeats = 0;
+        }
+    };
+
+    static Repeats &
+    threadRepeats()
+    {
+        thread_local Repeats repeats;
+        return repeats;
+    }
+
+    /// @brief Counts the message if same( repeats ) tells it repeats the last one
+    ///        of the thread within RepeatInterval, e.g. a message logged every
+    ///        frame shows up once a second. Otherwise writes the pending count
+    ///        first and has remember( repeats ) keep the message.
+    /// @return true if the message was counted and must not be written.
+    template< class Same, class Remember >
+    static bool
+    filterRepeat( LogLevel ll, bool flush, Same && same, Remember && remember )
+    {
+        Repeats & repeats = threadRepeats();
+
+        auto const now = std::chrono::steady_clock::now();
+
+        if ( ll == repeats.LastLevel && now - repeats.LastWritten < RepeatInterval && same( static_cast< Repeats const & >( repeats ) ) )
+        {
+            ++repeats.NumRepeats;
+            return true;
+        }
+
+        repeats.writePending( flush );
+
+        remember( repeats );
+        repeats.LastLevel = ll;
+        repeats.LastWritten = now;
+
+        return false;
+    }
+
+    static void
+    write( std::string const & msg, LogLevel ll, bool lineBreak, bool flush )
+    {
+        AsyncSink * sink = activeSink().load( std::memory_order_acquire );
+
+        if ( sink == nullptr )
+        {
+            std::cout << logLevelToAnsiColor( ll ) << msg << "\033[0m" << ( lineBreak ? "\n" : "" );
+            if ( flush ) std::cout.flush();
+            return;
+        }
+
+        AsyncSink::Record record;
+        record.Prefix = logLevelToAnsiColor( ll );
+        record.Suffix = lineBreak ? "\033[0m\n" : "\033[0m";
+        record.Text = msg;
+
+        submit( sink, std::move( record ), ll );
+    }
+
+    static void
+    submit( AsyncSink * sink, AsyncSink::Record && record, LogLevel ll )
+    {
+        // an error may precede a crash, it must not be dropped or left in the queue
+        if ( ll == LogLevel::ERROR )
+        {
+            sink->pushBlocking( std::move( record ) );
+            sink->flush();
+        }
+        else
+        {
+            sink->push( std::move( record ) );
+        }
+    }
+
+    /// @brief Owns the sink, destroyed at exit if still enabled.
+    static std::unique_ptr< AsyncSink > &
+    asyncSink()
+    {
+        static std::unique_ptr< AsyncSink > sink;
+        return sink;
+    }
+
+    static std::atomic< LogLevel > &
+    minLevel()
+    {
+        static std::atomic< LogLevel > level{ LogLevel::TRACE };
+        return level;
+    }
+
+    static std::atomic< AsyncSink * > &
+    activeSink()
+    {
+        static std::atomic< AsyncSink * > sink{ nullptr };
+        return sink;
+    }
 };
 
 } // - namespace logging
@@ -3,12 +3,22 @@
 ///////////////////
 
 
+#include "scene/AssetStreamer.hpp"
 #include "scene/Camera.hpp"
 #include "scene/Model.hpp"
+#include "scene/Scene.hpp"
+#include "scene/TransformHierarchy.hpp"
+#include "scene/OcclusionCuller.hpp"
+#include "scene/PointLight.hpp"
+#include "scene/DeferredLightPass.hpp"
 #include "renderer/Renderer.hpp"
 #include "renderer/VertexTypes.hpp"
 #include "logging/Logger.hpp"
+#include "logging/EventLog.hpp"
 #include "common/Utils.hpp"
+#include "common/ThreadPool.hpp"
+#include "common/DoubleBuffer.hpp"
+#include "common/FrameScheduler.hpp"
 #include "geometry/GeometryUtils.hpp"
 
 #include <string>
@@ -16,7 +26,11 @@
 #include <fstream>
 #include <array>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <map>
+#include <thread>
 
 #include <GLFW/glfw3.h>
 
@@ -31,38 +45,48 @@ class InputHandler
 {
 public:
 
+    using Clock = std::chrono::steady_clock;
+
+    /// @brief The input enums are stored in recordings, keep their values.
     enum class MouseButton
     {
-        LEFT,
-        MIDDLE,
-        RIGHT
+        LEFT = 0,
+        MIDDLE = 1,
+        RIGHT = 2
     };
 
     enum class MouseAction
     {
-        PRESS,
-        RELEASE
+        PRESS = 0,
+        RELEASE = 1
     };
 
+    /// @brief The values are the GLFW key codes, recordings store them.
     enum class Key
     {
-        KEY_0,
-        KEY_1,
-        KEY_2,
-        KEY_3,
-        KEY_4,
-        KEY_5,
-        KEY_6,
-        KEY_7,
-        KEY_8,
-        KEY_9,
-        KEY_W
+        KEY_0 = GLFW_KEY_0,
+        KEY_1 = GLFW_KEY_1,
+        KEY_2 = GLFW_KEY_2,
+        KEY_3 = GLFW_KEY_3,
+        KEY_4 = GLFW_KEY_4,
+        KEY_5 = GLFW_KEY_5,
+        KEY_6 = GLFW_KEY_6,
+        KEY_7 = GLFW_KEY_7,
+        KEY_8 = GLFW_KEY_8,
+        KEY_9 = GLFW_KEY_9,
+        KEY_F = GLFW_KEY_F,
+        KEY_L = GLFW_KEY_L,
+        KEY_O = GLFW_KEY_O,
+        KEY_P = GLFW_KEY_P,
+        KEY_S = GLFW_KEY_S,
+        KEY_V = GLFW_KEY_V,
+        KEY_W = GLFW_KEY_W
     };
 
     enum class KeyAction
     {
-        PRESS,
-        RELEASE
+        PRESS = 0,
+        RELEASE = 1
     };
 
     class Listener
@@ -118,6 +142,12 @@ public:
             case Key::KEY_7: return "KEY_7";
             case Key::KEY_8: return "KEY_8";
             case Key::KEY_9: return "KEY_9";
+            case Key::KEY_F: return "KEY_F";
+            case Key::KEY_L: return "KEY_L";
+            case Key::KEY_O: return "KEY_O";
+            case Key::KEY_P: return "KEY_P";
+            case Key::KEY_S: return "KEY_S";
+            case Key::KEY_V: return "KEY_V";
             case Key::KEY_W: return "KEY_W";
         }
     }
@@ -132,15 +162,28 @@ public:
         }
     }
 
+    /// @brief Called by the window callbacks as an event arrives, before it is dispatched.
+    void
+    stampEvent( Clock::time_point time )
+    { m_LatestEvent = std::max( m_LatestEvent, time ); }
+
+    /// @brief Arrival of the newest event since the last call, a default
+    ///        time_point if there was none.
+    Clock::time_point
+    takeLatestEventTime()
+    {
+        Clock::time_point const time = m_LatestEvent;
+        m_LatestEvent = {};
+
+        return time;
+    }
+
     void
     onMouseMove( double xpos, double ypos )
     {
         //noolog::info( "Mouse moved to " + std::to_string( xpos ) + " " + std::to_string( ypos ) + "." );
 
-        for ( auto * l : m_Listeners )
-        {
-            l->onMouseMove( xpos, ypos );
-        }
+        handleLiveEvent( { 0, EventType::MOUSE_MOVE, 0, 0, xpos, ypos } );
     }
 
     void
@@ -148,10 +191,7 @@ public:
     {
         //noolog::info( "Mouse wheel x: " + std::to_string( x_offset ) + " y: " + std::to_string( y_offset ) );
 
-        for ( auto * l : m_Listeners )
-        {
-            l->onMouseWheel( x_offset, y_offset );
-        }
+        handleLiveEvent( { 0, EventType::MOUSE_WHEEL, 0, 0, x_offset, y_offset } );
     }
 
     void
@@ -159,10 +199,7 @@ public:
     {
         //noolog::info( "Mouse button " + to_string( button ) + " was " + to_string( action ) + "ed." );
 
-        for ( auto * l : m_Listeners )
-        {
-            l->onMouseButton( button, action );
-        }
+        handleLiveEvent( { 0, EventType::MOUSE_BUTTON, static_cast< uint8_t >( button ), static_cast< uint8_t >( action ), 0.0, 0.0 } );
     }
 
     void
@@ -170,15 +207,225 @@ public:
     {
         //noolog::info( "Key " + to_string( key ) + " was " + to_string( action ) + "ed." );
 
-        for ( auto * l : m_Listeners )
+        handleLiveEvent( { 0, EventType::KEY, static_cast< uint8_t >( key ), static_cast< uint8_t >( action ), 0.0, 0.0 } );
+    }
+
+    /// @brief Writes every event from now on to filename, tagged with the index
+    ///        of the frame it arrived in.
+    bool
+    startRecording( std::string const & filename )
+    {
+        m_Recording.open( filename, std::ios::binary | std::ios::trunc );
+
+        if ( ! m_Recording )
         {
-            l->onKeyEvent( key, action );
+            NOO_LOG_ERROR( "Couldn't open input recording {}.", filename );
+            return false;
         }
+
+        m_Recording.write( RecordingMagic, sizeof( RecordingMagic ) );
+        m_Recording.write( reinterpret_cast< char const * >( &RecordingVersion ), sizeof( RecordingVersion ) );
+        m_Frame = 0;
+
+        return true;
+    }
+
+    /// @brief Marks the last recorded frame, a replay ends after it.
+    void
+    stopRecording()
+    {
+        if ( ! m_Recording.is_open() )
+            return;
+
+        writeEvent( { m_Frame, EventType::END, 0, 0, 0.0, 0.0 } );
+        m_Recording.close();
+    }
+
+    /// @brief Feeds the events of filename to the listeners instead of the live
+    ///        ones, each in the frame it was recorded in.
+    bool
+    startReplay( std::string const & filename )
+    {
+        std::ifstream in( filename, std::ios::binary );
+
+        char magic[ sizeof( RecordingMagic ) ] = {};
+        uint32_t version = 0;
+
+        in.read( magic, sizeof( magic ) );
+        in.read( reinterpret_cast< char * >( &version ), sizeof( version ) );
+
+        if ( ! in || ! std::equal( magic, magic + sizeof( magic ), RecordingMagic ) || version != RecordingVersion )
+        {
+            NOO_LOG_ERROR( "Couldn't read input recording {}.", filename );
+            return false;
+        }
+
+        m_Replay.clear();
+
+        Event e;
+
+        while ( readEvent( in, e ) )
+        {
+            m_Replay.push_back( e );
+
+            if ( e.Type == EventType::END )
+                break;
+        }
+
+        m_ReplayNext = 0;
+        m_Frame = 0;
+        m_Replaying = true;
+
+        return true;
+    }
+
+    bool
+    isReplaying() const
+    { return m_Replaying; }
+
+    /// @brief Advances the frame index, call once per frame before polling the
+    ///        window events. During a replay the events recorded up to the new
+    ///        frame are dispatched.
+    /// @return false once a replay has passed its last recorded frame.
+    bool
+    beginFrame()
+    {
+        ++m_Frame;
+
+        if ( ! m_Replaying )
+            return true;
+
+        while ( m_ReplayNext < m_Replay.size() && m_Replay[ m_ReplayNext ].Frame <= m_Frame )
+        {
+            Event const & e = m_Replay[ m_ReplayNext ];
+
+            if ( e.Type == EventType::END )
+                break;
+
+            stampEvent( Clock::now() );
+            dispatch( e );
+
+            ++m_ReplayNext;
+        }
+
+        // a recording cut short has no END, it ends with its last event
+        return ! m_Replay.empty() && m_Frame < m_Replay.back().Frame;
     }
 
 private:
 
+    /// @brief Followed by the version and the events of a recording.
+    static constexpr char RecordingMagic[ 4 ] = { 'N', 'O', 'O', 'I' };
+    /// @brief 2 stores the GLFW key codes, 1 stored the index of the key in the enum.
+    static constexpr uint32_t RecordingVersion = 2;
+
+    enum class EventType : uint8_t
+    {
+        MOUSE_MOVE,
+        MOUSE_WHEEL,
+        MOUSE_BUTTON,
+        KEY,
+        END
+    };
+
+    /// @brief Any input event. Code and Action hold the button or key enums,
+    ///        X and Y the cursor position or wheel offset.
+    struct Event
+    {
+        uint32_t Frame;
+        EventType Type;
+        uint8_t Code;
+        uint8_t Action;
+        double X;
+        double Y;
+    };
+
+    void
+    handleLiveEvent( Event e )
+    {
+        // the recording alone drives the listeners
+        if ( m_Replaying )
+            return;
+
+        if ( m_Recording.is_open() )
+        {
+            e.Frame = m_Frame;
+            writeEvent( e );
+        }
+
+        dispatch( e );
+    }
+
+    void
+    dispatch( Event const & e )
+    {
+        for ( auto * l : m_Listeners )
+        {
+            switch ( e.Type )
+            {
+                case EventType::MOUSE_MOVE  : l->onMouseMove( e.X, e.Y ); break;
+                case EventType::MOUSE_WHEEL : l->onMouseWheel( e.X, e.Y ); break;
+                case EventType::MOUSE_BUTTON: l->onMouseButton( static_cast< MouseButton >( e.Code ), static_cast< MouseAction >( e.Action ) ); break;
+                case EventType::KEY         : l->onKeyEvent( static_cast< Key >( e.Code ), static_cast< KeyAction >( e.Action ) ); break;
+                case EventType::END         : break;
+            }
+        }
+    }
+
+    /// @brief Frame and type, then two doubles for moves and wheel or two bytes
+    ///        for buttons and keys.
+    void
+    writeEvent( Event const & e )
+    {
+        m_Recording.write( reinterpret_cast< char const * >( &e.Frame ), sizeof( e.Frame ) );
+        m_Recording.write( reinterpret_cast< char const * >( &e.Type ), sizeof( e.Type ) );
+
+        if ( e.Type == EventType::MOUSE_MOVE || e.Type == EventType::MOUSE_WHEEL )
+        {
+            m_Recording.write( reinterpret_cast< char const * >( &e.X ), sizeof( e.X ) );
+            m_Recording.write( reinterpret_cast< char const * >( &e.Y ), sizeof( e.Y ) );
+        }
+        else if ( e.Type != EventType::END )
+        {
+            m_Recording.write( reinterpret_cast< char const * >( &e.Code ), sizeof( e.Code ) );
+            m_Recording.write( reinterpret_cast< char const * >( &e.Action ), sizeof( e.Action ) );
+        }
+    }
+
+    static bool
+    readEvent( std::istream & in, Event & e )
+    {
+        e = { 0, EventType::END, 0, 0, 0.0, 0.0 };
+
+        in.read( reinterpret_cast< char * >( &e.Frame ), sizeof( e.Frame ) );
+        in.read( reinterpret_cast< char * >( &e.Type ), sizeof( e.Type ) );
+
+        if ( e.Type == EventType::MOUSE_MOVE || e.Type == EventType::MOUSE_WHEEL )
+        {
+            in.read( reinterpret_cast< char * >( &e.X ), sizeof( e.X ) );
+            in.read( reinterpret_cast< char * >( &e.Y ), sizeof( e.Y ) );
+        }
+        else if ( e.Type != EventType::END )
+        {
+            in.read( reinterpret_cast< char * >( &e.Code ), sizeof( e.Code ) );
+            in.read( reinterpret_cast< char * >( &e.Action ), sizeof( e.Action ) );
+        }
+
+        return static_cast< bool >( in );
+    }
+
     std::vector< Listener * > m_Listeners;
+
+    Clock::time_point m_LatestEvent;
+
+    /// @brief Frames since recording or replay started.
+    uint32_t m_Frame = 0;
+
+    std::ofstream m_Recording;
+
+    std::vector< Event > m_Replay;
+    size_t m_ReplayNext = 0;
+    bool m_Replaying = false;
 };
 
 
@@ -252,13 +499,32 @@ private:
 
     noo::scene::Camera & m_Camera;
 
-    bool m_LeftMousePressed;
+    // initialized, a replay has to start from the same state as its recording
+    bool m_LeftMousePressed = false;
+
+    double m_LastX = 0.0, m_LastY = 0.0;
+};
+
+
+/// @brief Render options, switched by RenderModeSwitch.
+struct RenderSettings
+{
+    int State = 1;
+    bool Wireframe = false;
+    bool DepthPrePass = false;
+    bool OcclusionCulling = true;
+    bool Lods = true;
+    bool PrintStats = false;
 
-    double m_LastX, m_LastY;
+    /// @brief 0 presents immediately, 1 waits for vertical sync.
+    int SwapInterval = 1;
+
+    /// @brief Frames the render thread may record ahead of the GPU, 1 to 3.
+    int MaxFramesInFlight = 2;
 };
 
 
-class RenderModeSwitch : public InputHandler::Listener
+class RenderModeSwitch : public InputHandler::Listener, public RenderSettings
 {
 public:
 
@@ -277,12 +543,30 @@ public:
         if ( key == InputHandler::Key::KEY_4 && action == InputHandler::KeyAction::PRESS )
             State = 4;
 
+        if ( key == InputHandler::Key::KEY_5 && action == InputHandler::KeyAction::PRESS )
+            State = 5;
+
         if ( key == InputHandler::Key::KEY_W && action == InputHandler::KeyAction::PRESS )
             Wireframe = !Wireframe;
-    }
 
-    int State = 1;
-    bool Wireframe = false;
+        if ( key == InputHandler::Key::KEY_L && action == InputHandler::KeyAction::PRESS )
+            Lods = !Lods;
+
+        if ( key == InputHandler::Key::KEY_O && action == InputHandler::KeyAction::PRESS )
+            OcclusionCulling = !OcclusionCulling;
+
+        if ( key == InputHandler::Key::KEY_P && action == InputHandler::KeyAction::PRESS )
+            DepthPrePass = !DepthPrePass;
+
+        if ( key == InputHandler::Key::KEY_S && action == InputHandler::KeyAction::PRESS )
+            PrintStats = true;
+
+        if ( key == InputHandler::Key::KEY_V && action == InputHandler::KeyAction::PRESS )
+            SwapInterval = 1 - SwapInterval;
+
+        if ( key == InputHandler::Key::KEY_F && action == InputHandler::KeyAction::PRESS )
+            MaxFramesInFlight = MaxFramesInFlight % 3 + 1;
+    }
 };
 
 
@@ -290,6 +574,7 @@ public:
 static void keyCallback( GLFWwindow * window, int key, int /* scancode */, int action, int /* mods */ )
 {
     InputHandler & input = *static_cast< InputHandler * >( glfwGetWindowUserPointer( window ) );
+    input.stampEvent( InputHandler::Clock::now() );
 
     static std::map< int, InputHandler::Key > glfw2nooKey = { { GLFW_KEY_0, InputHandler::Key::KEY_0 }
                                                             , { GLFW_KEY_1, InputHandler::Key::KEY_1 }
@@ -301,6 +586,12 @@ static void keyCallback( GLFWwindow * window, int key, int /* scancode */, int a
                                                             , { GLFW_KEY_7, InputHandler::Key::KEY_7 }
                                                             , { GLFW_KEY_8, InputHandler::Key::KEY_8 }
                                                             , { GLFW_KEY_9, InputHandler::Key::KEY_9 }
+                                                            , { GLFW_KEY_F, InputHandler::Key::KEY_F }
+                                                            , { GLFW_KEY_L, InputHandler::Key::KEY_L }
+                                                            , { GLFW_KEY_O, InputHandler::Key::KEY_O }
+                                                            , { GLFW_KEY_P, InputHandler::Key::KEY_P }
+                                                            , { GLFW_KEY_S, InputHandler::Key::KEY_S }
+                                                            , { GLFW_KEY_V, InputHandler::Key::KEY_V }
                                                             , { GLFW_KEY_W, InputHandler::Key::KEY_W } };
 
     static std::map< int, InputHandler::KeyAction > glfw2nooAction = { { GLFW_PRESS  , InputHandler::KeyAction::PRESS }
@@ -320,6 +611,7 @@ static void keyCallback( GLFWwindow * window, int key, int /* scancode */, int a
 static void cursorPositionCallback( GLFWwindow * window, double xpos, double ypos )
 {
     InputHandler & input = *static_cast< InputHandler * >( glfwGetWindowUserPointer( window ) );
+    input.stampEvent( InputHandler::Clock::now() );
     input.onMouseMove( xpos, ypos );
 }
 
@@ -327,6 +619,7 @@ static void cursorPositionCallback( GLFWwindow * window, double xpos, double ypo
 static void mouseButtonCallback( GLFWwindow * window, int button, int action, int /* mods */ )
 {
     InputHandler & input = *static_cast< InputHandler * >( glfwGetWindowUserPointer( window ) );
+    input.stampEvent( InputHandler::Clock::now() );
 
     using ib = InputHandler::MouseButton;
     using ia = InputHandler::MouseAction;
@@ -345,42 +638,39 @@ static void mouseButtonCallback( GLFWwindow * window, int button, int action, in
 static void scrollCallback( GLFWwindow * window, double xoffset, double yoffset )
 {
     InputHandler & input = *static_cast< InputHandler * >( glfwGetWindowUserPointer( window ) );
+    input.stampEvent( InputHandler::Clock::now() );
 
     input.onMouseWheel( xoffset, yoffset );
 }
 
 
-/// @brief Application entry point.
-int main( int /* argc */, char ** /* argv */ )
+/// @brief Everything the render thread needs of one simulated frame.
+struct FrameSnapshot
 {
-    noolog::info( "Hello Deferred Rendering!" );
-
-    if ( ! glfwInit() )
-    {
-        return -1;
-    }
-
-    glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, 4 );
-    glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 5 );
-    //glfwWindowHint( GLFW_SAMPLES, 16 ); // enable multi-sampling
+    noo::scene::CameraSnapshot Camera;
+    RenderSettings Settings;
+    std::vector< noo::scene::PointLight > Lights;
 
-    glm::ivec2 const window_size( 1200, 800 );
-    GLFWwindow * window = glfwCreateWindow( window_size.x, window_size.y, "Deferred Rendering Demo", nullptr, nullptr );
-
-    InputHandler inputHandler;
-    glfwSetWindowUserPointer( window, &inputHandler );
+    /// @brief Arrival of the newest input the frame reflects, default if there was none.
+    std::chrono::steady_clock::time_point InputTime;
 
-    if ( ! window )
-    {
-        glfwTerminate();
-        return -1;
-    }
+    /// @brief World matrices of the simulated objects that changed this frame,
+    ///        the scene instances follow their nodes. Every frame is rendered,
+    ///        so the render thread sees each change once.
+    std::vector< noo::scene::TransformHierarchy::NodeWorld > MovedNodes;
+};
 
-    glfwSetKeyCallback( window, keyCallback );
-    glfwSetCursorPosCallback( window, cursorPositionCallback );
-    glfwSetMouseButtonCallback( window, mouseButtonCallback );
-    glfwSetScrollCallback( window, scrollCallback );
 
+/// @brief Owns the GL context. Renders the frames simulated by the main thread,
+///        one frame behind it, until frames is closed.
+static void renderLoop( GLFWwindow * window, glm::ivec2 const window_size
+                      , noo::common::DoubleBuffer< FrameSnapshot > & frames
+                      , noo::common::ThreadPool & workers
+                      , noo::scene::TransformHierarchy::NodeId const terrainNode
+                      , noo::logging::EventLog & telemetry
+                      , std::atomic< bool > & loadFinished )
+{
+    // the context belongs to this thread from here on
     glfwMakeContextCurrent( window );
 
     gladLoadGLLoader( reinterpret_cast< GLADloadproc >( glfwGetProcAddress ) );
@@ -390,9 +680,8 @@ int main( int /* argc */, char ** /* argv */ )
 
     glm::vec4 const clrColor{ 0.39, 0.58, 0.92, 1.0 };
 
-    {
     noo::renderer::Renderer renderer;
-    renderer.initialize( window_size.x, window_size.y );
+    renderer.initialize( window_size.x, window_size.y, reinterpret_cast< GLADloadproc >( glfwGetProcAddress ) );
 
     using noo::renderer::ETextureFormat;
     using noo::renderer::EImageFormat;
@@ -426,43 +715,60 @@ int main( int /* argc */, char ** /* argv */ )
     //rt_def->attachTexture2D( noo::renderer::EAttachmentUsage::COLOR_ATTACHMENT3, *rt_def_texcoord );
     rt_def->attachRenderbuffer( noo::renderer::EAttachmentUsage::DEPTH_STENCIL_ATTACHMENT, *rt_def_depth );
 
+    /* Light accumulation, shares depth and stencil with the G-Buffer */
+    auto rt_def_light = renderer.createRenderTarget( rt_width, rt_height );
+    auto rt_def_light_color = renderer.createTexture2D( rt_width, rt_height, ETextureFormat::RGB_16F, nullptr, EImageFormat::RGB, EImagePixelType::FLOAT );
+
+    rt_def_light->attachTexture2D( noo::renderer::EAttachmentUsage::COLOR_ATTACHMENT0, *rt_def_light_color );
+    rt_def_light->attachRenderbuffer( noo::renderer::EAttachmentUsage::DEPTH_STENCIL_ATTACHMENT, *rt_def_depth );
+
     std::string const def_pre_VS = noo::common::readFile( "resources/shaders/deferred_pre.vsh" );
     std::string const def_pre_FS = noo::common::readFile( "resources/shaders/deferred_pre.fsh" );
 
     auto shader_def_pre = renderer.createShader( def_pre_VS.c_str(), nullptr, nullptr, nullptr, def_pre_FS.c_str() );
 
+    std::string const depth_only_VS = noo::common::readFile( "resources/shaders/depth_only.vsh" );
+    std::string const depth_only_FS = noo::common::readFile( "resources/shaders/depth_only.fsh" );
+
+    auto shader_depth_only = renderer.createShader( depth_only_VS.c_str(), nullptr, nullptr, nullptr, depth_only_FS.c_str() );
+
     std::string const def_light_VS = noo::common::readFile( "resources/shaders/deferred_light.vsh" );
     std::string const def_light_FS = noo::common::readFile( "resources/shaders/deferred_light.fsh" );
 
     auto shader_def_light = renderer.createShader( def_light_VS.c_str(), nullptr, nullptr, nullptr, def_light_FS.c_str() );
 
     noo::renderer::Shader::Data shdDefPre( *shader_def_pre );
+    noo::renderer::Shader::Data shdDepthOnly( *shader_depth_only );
     noo::renderer::Shader::Data shdDefLight( *shader_def_light );
 
+    noo::scene::DeferredLightPass lightPass;
+    lightPass.initialize( renderer );
+
 
-    std::vector< noo::renderer::Vertex_Pos3Color4 > vData =
+    std::vector< noo::renderer::Vertex_Pos3Color4UB > vData =
     {
-        { -0.5f,  0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f },
-        { -0.5f, -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f },
-        {  0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f },
+        { -0.5f,  0.5f, 0.0f, 255,   0,   0, 255 },
+        { -0.5f, -0.5f, 0.0f,   0, 255,   0, 255 },
+        {  0.5f, -0.5f, 0.0f,   0,   0, 255, 255 },
     };
 
     auto vbo_tri = renderer.createVertexBuffer();
-    vbo_tri->upload( vData.size() * noo::renderer::Vertex_Pos3Color4::SizeInBytes, vData.data() );
+    vbo_tri->upload( vData.size() * noo::renderer::Vertex_Pos3Color4UB::SizeInBytes, vData.data() );
 
-    std::vector< noo::renderer::Vertex_Pos3Tex2 > vQuad =
+    // the corners of the texture are exact in normalized shorts
+    std::vector< noo::renderer::Vertex_Pos3Tex2US > vQuad =
     {
-        { -1.0f, -1.0f, 0.0f, 0.0f, 0.0f },
-        {  1.0f,  1.0f, 0.0f, 1.0f, 1.0f },
-        { -1.0f,  1.0f, 0.0f, 0.0f, 1.0f },
+        { -1.0f, -1.0f, 0.0f,     0,     0 },
+        {  1.0f,  1.0f, 0.0f, 65535, 65535 },
+        { -1.0f,  1.0f, 0.0f,     0, 65535 },
 
-        {  1.0f,  1.0f, 0.0f, 1.0f, 1.0f },
-        { -1.0f, -1.0f, 0.0f, 0.0f, 0.0f },
-        {  1.0f, -1.0f, 0.0f, 1.0f, 0.0f },
+        {  1.0f,  1.0f, 0.0f, 65535, 65535 },
+        { -1.0f, -1.0f, 0.0f,     0,     0 },
+        {  1.0f, -1.0f, 0.0f, 65535,     0 },
     };
 
     auto vbo_quad = renderer.createVertexBuffer();
-    vbo_quad->upload( vQuad.size() * noo::renderer::Vertex_Pos3Tex2::SizeInBytes, vQuad.data() );
+    vbo_quad->upload( vQuad.size() * noo::renderer::Vertex_Pos3Tex2US::SizeInBytes, vQuad.data() );
 
     std::string const solidVS = noo::common::readFile( "resources/shaders/simple.vsh" );
     std::string const solidFS = noo::common::readFile( "resources/shaders/simple.fsh" );
@@ -495,16 +801,7 @@ int main( int /* argc */, char ** /* argv */ )
     auto tex = renderer.createTexture2D( tex_size, tex_size, ETextureFormat::RGBA, imgData.data(), EImageFormat::RGBA, EImagePixelType::UBYTE );
 
 
-    noo::scene::Camera cam;
-    cam.setAspectRatio( static_cast< float >( window_size.x ) / window_size.y );
-    cam.setPosition( 0, 0, 3 );
-    cam.lookAt( 0, 0, 0 );
 
-    CameraOrbitController camControl( cam );
-    inputHandler.addListener( &camControl );
-
-    RenderModeSwitch rms;
-    inputHandler.addListener( &rms );
 
     noo::renderer::Shader::Data shdSolid( *shaderSolid );
     noo::renderer::Shader::Data shdTex( *shaderTex );
@@ -514,13 +811,13 @@ int main( int /* argc */, char ** /* argv */ )
     geoTri.Vertices = vbo_tri.get();
     geoTri.Indices = nullptr;
     geoTri.NumPrimitives = vData.size() / 3;
-    geoTri.VertexFormat = noo::renderer::Vertex_Pos3Color4::VertexDesc();
+    geoTri.VertexFormat = noo::renderer::Vertex_Pos3Color4UB::VertexDesc();
 
     noo::renderer::Geometry geoQuad;
     geoQuad.Vertices = vbo_quad.get();
     geoQuad.Indices = nullptr;
     geoQuad.NumPrimitives = vQuad.size() / 3;
-    geoQuad.VertexFormat = noo::renderer::Vertex_Pos3Tex2::VertexDesc();
+    geoQuad.VertexFormat = noo::renderer::Vertex_Pos3Tex2US::VertexDesc();
 
 
     std::vector< glm::vec3 > sphere_pos;
@@ -551,58 +848,178 @@ int main( int /* argc */, char ** /* argv */ )
     //std::string const meshFilename = "/home/ben/torus.obj";
     //std::string const meshFilename = "/home/ben/torus_smooth.obj";
     std::string const meshFilename = "/home/ben/Documents/models/low_poly_terrain.dae";
-    auto myModel = std::make_unique< noo::scene::Model >();
 
-    bool model_loaded = noo::scene::Model::createFromFile( meshFilename, *myModel );
+    // loads in the background, the window is responsive from the first frame
+    noo::scene::AssetStreamer streamer( workers );
+    // only the occluder copy of the terrain is needed once it is on the GPU
+    std::shared_future< noo::scene::Model * > pendingModel = streamer.load( meshFilename, noo::scene::EResidency::KEEP_OCCLUDERS );
+    auto const loadStart = std::chrono::steady_clock::now();
+    bool model_loaded = false;
 
-    if ( model_loaded )
-    {
-        noolog::info( "Model " + meshFilename + " successfully loaded." );
-    }
-    else
-    {
-        noolog::error( "Model " + meshFilename + " couldn't be loaded." );
-    }
+    // world matrices of the simulated nodes, kept up to date from the moved ones
+    std::vector< glm::mat4 > nodeWorlds( terrainNode + 1, glm::mat4( 1 ) );
+
+    using noo::logging::EFieldType;
+
+    // a record per frame, cheap enough to stay on in every session. The times are
+    // of that frame alone, gpu_ms is -1 if a pass timing was not available
+    noo::logging::EventLog::EventId const frameEvent = telemetry.defineEvent( "frame", { { "frame", EFieldType::INT }
+                                                                                       , { "cpu_ms", EFieldType::FLOAT }
+                                                                                       , { "gpu_ms", EFieldType::FLOAT }
+                                                                                       , { "draws", EFieldType::INT }
+                                                                                       , { "triangles", EFieldType::INT } } );
+
+    uint64_t lastRecordedFrame = 0;
+
+    noo::logging::EventLog::EventId const loadEvent = telemetry.defineEvent( "model_load", { { "load_ms", EFieldType::FLOAT }
+                                                                                           , { "loaded", EFieldType::INT } } );
+
+    noo::scene::Scene scene;
+    std::vector< noo::scene::Scene::InstanceId > visibleInstances;
+
+    noo::scene::OcclusionCuller occlusion;
+    occlusion.resize( 256, 256 * rt_height / rt_width );
 
     using noo::renderer::EWrapMode;
     using noo::renderer::EMinFilterMode;
     using noo::renderer::EMagFilterMode;
     using noo::renderer::state::StateSet;
 
-    while ( ! glfwWindowShouldClose( window ) )
+    int swapInterval = -1;
+
+    while ( FrameSnapshot const * frame = frames.beginRead() )
     {
+        RenderSettings const & settings = frame->Settings;
+
+        if ( settings.SwapInterval != swapInterval )
+        {
+            swapInterval = settings.SwapInterval;
+            glfwSwapInterval( swapInterval );
+        }
+
+        renderer.setMaxFramesInFlight( settings.MaxFramesInFlight );
+        renderer.setInputTime( frame->InputTime );
+
+        renderer.beginFrame();
+
+        streamer.update( renderer );
+
+        for ( auto const & moved : frame->MovedNodes )
+        {
+            if ( moved.Node >= nodeWorlds.size() )
+                nodeWorlds.resize( moved.Node + 1, glm::mat4( 1 ) );
+
+            nodeWorlds[ moved.Node ] = moved.World;
+        }
+
+        if ( pendingModel.valid() && pendingModel.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready )
+        {
+            double const loadMs = std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - loadStart ).count();
+            telemetry.record( loadEvent, loadMs, pendingModel.get() != nullptr );
+
+            if ( noo::scene::Model * model = pendingModel.get() )
+            {
+                // the terrain hides parts of itself behind its hills
+                noo::scene::Scene::InstanceId const terrain = scene.addInstance( *model, nodeWorlds[ terrainNode ] );
+                scene.setOccluder( terrain, true );
+                scene.setNode( terrain, terrainNode, nodeWorlds[ terrainNode ] );
+                model_loaded = true;
+
+                NOO_LOG_INFO( "Model {} successfully loaded.", meshFilename );
+            }
+            else
+            {
+                NOO_LOG_ERROR( "Model {} couldn't be loaded.", meshFilename );
+            }
+
+            pendingModel = {};
+            loadFinished.store( true, std::memory_order_release );
+        }
+
+        scene.updateTransforms( frame->MovedNodes, &workers );
+
+        // the camera as simulated for this frame, read by everything below
+        noo::scene::CameraSnapshot const & view = frame->Camera;
 
         // pre-pass - render to texture
         {
-            if ( rms.State == 4 && model_loaded )
+            if ( ( settings.State == 4 || settings.State == 5 ) && model_loaded )
             {
                 renderer.clear( *rt_def, { 0, 0, 0, 0 }, 1.0f, 0 );
 
                 StateSet stateSet;
-                if ( rms.Wireframe ) stateSet.rasterizer = noo::renderer::state::RasterizerState::Wireframe();
+                if ( settings.Wireframe ) stateSet.rasterizer = noo::renderer::state::RasterizerState::Wireframe();
 
-                shdDefPre[ "u_mvp" ] = cam.getViewProjectionMatrix();
-                shdDefPre[ "u_mat_rot" ] = glm::mat3(1); //glm::mat3( cam.getViewMatrix() );
+                glm::mat4 const & viewProj = view.ViewProjection;
 
-                myModel->draw( renderer, *rt_def, shdDefPre, stateSet );
+                scene.update();
+                scene.setLodView( settings.Lods ? noo::scene::LodView::fromCamera( view, rt_height ) : noo::scene::LodView() );
+                size_t const numInstances = scene.cull( view.Frustum, visibleInstances );
+                renderer.setCounter( "instances visible", numInstances );
+                renderer.setCounter( "instances culled", scene.getNumInstances() - numInstances );
+
+                noo::scene::OcclusionCuller const * occluders = nullptr;
+
+                if ( settings.OcclusionCulling )
+                {
+                    auto const occlusionStart = std::chrono::steady_clock::now();
+                    size_t const numOccluded = scene.occlusionCull( occlusion, viewProj, visibleInstances, &workers );
+                    auto const occlusionTime = std::chrono::steady_clock::now() - occlusionStart;
+
+                    renderer.setCounter( "instances occluded", numOccluded );
+                    renderer.setCounter( "occlusion us", std::chrono::duration_cast< std::chrono::microseconds >( occlusionTime ).count() );
+
+                    occluders = &occlusion;
+                }
+
+                if ( settings.DepthPrePass )
+                {
+                    // lay down depth first, so the g-buffer is written once per pixel
+                    StateSet depthStateSet = stateSet;
+                    depthStateSet.blend = noo::renderer::state::BlendState::NoColorWrite();
+
+                    renderer.beginPass( "depth pre-pass" );
+                    scene.drawDepth( renderer, *rt_def, shdDepthOnly, depthStateSet, viewProj, visibleInstances, &workers, occluders );
+                    renderer.endPass();
+
+                    stateSet.depth = { noo::renderer::state::EEnableDepthTest::ENABLE
+                                     , noo::renderer::state::EEnableDepthWrite::DISABLE
+                                     , noo::renderer::state::EDepthFunc::EQUAL };
+                }
+
+                renderer.beginPass( "g-buffer" );
+                size_t const numMeshes = scene.draw( renderer, *rt_def, shdDefPre, stateSet, viewProj, visibleInstances, &workers, occluders );
+                renderer.endPass();
+
+                renderer.setCounter( "meshes visible", numMeshes );
+                renderer.setCounter( "meshes occluded", scene.getNumOccludedMeshes() );
+
+                if ( settings.State == 4 )
+                {
+                    renderer.beginPass( "light volumes" );
+                    renderer.clearColor( *rt_def_light, { 0, 0, 0, 1 } );
+                    lightPass.draw( renderer, *rt_def_light, view, frame->Lights, rt_def_diffuse.get(), rt_def_position.get(), rt_def_normal.get() );
+                    renderer.endPass();
+                }
 
                 /*stateSet.cull.FrontFaceWinding = noo::renderer::state::EFrontFaceWinding::CW;
                 shdDefPre[ "u_color" ] = glm::vec3( 0, 1, 0 );
-                shdDefPre[ "u_mvp" ] = cam.getViewProjectionMatrix() * glm::scale( glm::vec3{ 0.5, 0.5, 0.5 } );
+                shdDefPre[ "u_mvp" ] = view.ViewProjection * glm::scale( glm::vec3{ 0.5, 0.5, 0.5 } );
 
                 renderer.draw( *rt_def, shdDefPre, stateSet, geoSphere );*/
             }
             else
             {
+                renderer.beginPass( "forward" );
                 renderer.clear( *rt, clrColor, 1.0f, 0 );
                 {
                     // render a lit sphere
                     StateSet stateSet;
                     stateSet.depth = noo::renderer::state::DepthState::WriteOnly();
                     stateSet.cull.FrontFaceWinding = noo::renderer::state::EFrontFaceWinding::CW;
-                    if ( rms.Wireframe ) stateSet.rasterizer = noo::renderer::state::RasterizerState::Wireframe();
+                    if ( settings.Wireframe ) stateSet.rasterizer = noo::renderer::state::RasterizerState::Wireframe();
 
-                    shdLit[ "u_mvp" ] = cam.getViewProjectionMatrix();
+                    shdLit[ "u_mvp" ] = view.ViewProjection;
                     shdLit[ "u_color" ] = glm::vec3( 0.5, 0.5, 1.0 );
                     shdLit[ "u_light_dir" ] = glm::normalize( glm::vec3( 1, 1, 1 ) );
 
@@ -614,13 +1031,14 @@ int main( int /* argc */, char ** /* argv */ )
                     StateSet stateSet;
                     stateSet.depth = noo::renderer::state::DepthState::WriteOnly();
                     stateSet.cull = noo::renderer::state::CullState::Disabled();
-                    if ( rms.Wireframe ) stateSet.rasterizer = noo::renderer::state::RasterizerState::Wireframe();
+                    if ( settings.Wireframe ) stateSet.rasterizer = noo::renderer::state::RasterizerState::Wireframe();
 
-                    shdSolid[ "u_mvp" ] = cam.getViewProjectionMatrix();
+                    shdSolid[ "u_mvp" ] = view.ViewProjection;
                     shdSolid[ "u_color" ] = glm::vec4( 1, 1, 1, 1 );
 
                     renderer.draw( *rt, shdSolid, stateSet, geoTri );
                 }
+                renderer.endPass();
             }
         }
 
@@ -628,21 +1046,23 @@ int main( int /* argc */, char ** /* argv */ )
         {
             StateSet stateSet;
 
+            renderer.beginPass( "composite" );
+
             renderer.clear( renderer.defaultRenderTarget(), glm::vec4( 0, 1, 0, 1 ) );
             {
                 shdTex[ "u_mvp" ] = glm::mat4(1);
 
-                if ( rms.State == 1 )
+                if ( settings.State == 1 )
                 {
                     shdTex[ "s2D_tex" ] = noo::renderer::TextureSampler{ rt_color.get(), EWrapMode::REPEAT, EWrapMode::REPEAT, EMinFilterMode::NEAREST, EMagFilterMode::NEAREST };
                     renderer.draw( renderer.defaultRenderTarget(), shdTex, stateSet, geoQuad );
                 }
-                else if ( rms.State == 2 )
+                else if ( settings.State == 2 )
                 {
                     shdTex[ "s2D_tex" ] = noo::renderer::TextureSampler{ rt_depth.get(), EWrapMode::REPEAT, EWrapMode::REPEAT, EMinFilterMode::LINEAR, EMagFilterMode::LINEAR };
                     renderer.draw( renderer.defaultRenderTarget(), shdTex, stateSet, geoQuad );
                 }
-                else if ( rms.State == 3 )
+                else if ( settings.State == 3 )
                 {
                     shdTex[ "s2D_tex" ] = noo::renderer::TextureSampler{ tex.get(), EWrapMode::CLAMP, EWrapMode::MIRROR, EMinFilterMode::NEAREST, EMagFilterMode::NEAREST };
                     renderer.draw( renderer.defaultRenderTarget(), shdTex, stateSet, geoQuad );
@@ -668,27 +1088,246 @@ int main( int /* argc */, char ** /* argv */ )
                     renderer.draw( renderer.defaultRenderTarget(), shdTex, stateSet, geoQuad );
 
                     stateSet.viewport = noo::renderer::state::ViewportState( w/2, h/2, w/2, h/2 );
-                    shdDefLight[ "s2D_diffuse" ] = noo::renderer::TextureSampler{ rt_def_diffuse.get(), EWrapMode::CLAMP, EWrapMode::CLAMP, EMinFilterMode::NEAREST, EMagFilterMode::NEAREST };
-                    shdDefLight[ "s2D_position" ] = noo::renderer::TextureSampler{ rt_def_position.get(), EWrapMode::CLAMP, EWrapMode::CLAMP, EMinFilterMode::NEAREST, EMagFilterMode::NEAREST };
-                    shdDefLight[ "s2D_normal" ] = noo::renderer::TextureSampler{ rt_def_normal.get(), EWrapMode::CLAMP, EWrapMode::CLAMP, EMinFilterMode::NEAREST, EMagFilterMode::NEAREST };
-                    shdDefLight[ "u_light_pos" ] = glm::vec3( 0, 0, 5 );
-                    shdDefLight[ "u_light_color" ] = glm::vec3( 1.0, 1.0, 1.0 );
-                    shdDefLight[ "u_view_pos" ] = cam.getPosition();
-                    renderer.draw( renderer.defaultRenderTarget(), shdDefLight, stateSet, geoQuad );
+
+                    if ( settings.State == 4 )
+                    {
+                        // light volumes
+                        shdTex[ "s2D_tex" ] = noo::renderer::TextureSampler{ rt_def_light_color.get(), EWrapMode::CLAMP, EWrapMode::CLAMP, EMinFilterMode::NEAREST, EMagFilterMode::NEAREST };
+                        renderer.draw( renderer.defaultRenderTarget(), shdTex, stateSet, geoQuad );
+                    }
+                    else
+                    {
+                        // full-screen lighting for comparison
+                        shdDefLight[ "s2D_diffuse" ] = noo::renderer::TextureSampler{ rt_def_diffuse.get(), EWrapMode::CLAMP, EWrapMode::CLAMP, EMinFilterMode::NEAREST, EMagFilterMode::NEAREST };
+                        shdDefLight[ "s2D_position" ] = noo::renderer::TextureSampler{ rt_def_position.get(), EWrapMode::CLAMP, EWrapMode::CLAMP, EMinFilterMode::NEAREST, EMagFilterMode::NEAREST };
+                        shdDefLight[ "s2D_normal" ] = noo::renderer::TextureSampler{ rt_def_normal.get(), EWrapMode::CLAMP, EWrapMode::CLAMP, EMinFilterMode::NEAREST, EMagFilterMode::NEAREST };
+                        shdDefLight[ "u_light_pos" ] = glm::vec3( 0, 0, 5 );
+                        shdDefLight[ "u_light_color" ] = glm::vec3( 1.0, 1.0, 1.0 );
+                        shdDefLight[ "u_view_pos" ] = view.Position;
+                        renderer.draw( renderer.defaultRenderTarget(), shdDefLight, stateSet, geoQuad );
+                    }
+                }
+            }
+
+            renderer.endPass();
+        }
+
+        renderer.endFrame();
+
+        // the stats lag the frame by the query latency, each frame is recorded once resolved
+        if ( renderer.getFrameStats().Frame != lastRecordedFrame )
+        {
+            noo::renderer::FrameStats const & stats = renderer.getFrameStats();
+            double gpuMs = 0.0;
+
+            for ( auto const & p : stats.Passes )
+            {
+                if ( p.GpuSampleMs < 0.0 )
+                {
+                    gpuMs = -1.0;
+                    break;
                 }
+
+                gpuMs += p.GpuSampleMs;
             }
+
+            telemetry.record( frameEvent, stats.Frame, stats.CpuSampleMs, gpuMs, stats.DrawCalls, stats.Primitives );
+            lastRecordedFrame = stats.Frame;
         }
 
+        if ( settings.PrintStats )
+        {
+            NOO_LOG_INFO( "Depth pre-pass {}, {}", settings.DepthPrePass ? "on" : "off", renderer.getFrameStats() );
+
+            // each print covers the latencies since the last one
+            renderer.resetLatencyStats();
+        }
+
+        // all is submitted, the simulation may refill the snapshot while the swap waits
+        frames.endRead();
+
         glfwSwapBuffers( window );
-        glfwPollEvents();
+
+        renderer.framePresented();
     }
 
     renderer.destroy();
+
+    glfwMakeContextCurrent( nullptr );
+}
+
+
+/// @brief Application entry point.
+int main( int argc, char ** argv )
+{
+    // the render loop logs too, it must not wait for the terminal
+    noolog::enableAsync();
+    noolog::info( "Hello Deferred Rendering!" );
+
+    if ( ! glfwInit() )
+    {
+        return -1;
+    }
+
+    glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, 4 );
+    glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 5 );
+    //glfwWindowHint( GLFW_SAMPLES, 16 ); // enable multi-sampling
+
+    glm::ivec2 const window_size( 1200, 800 );
+    GLFWwindow * window = glfwCreateWindow( window_size.x, window_size.y, "Deferred Rendering Demo", nullptr, nullptr );
+
+    InputHandler inputHandler;
+    glfwSetWindowUserPointer( window, &inputHandler );
+
+    if ( ! window )
+    {
+        glfwTerminate();
+        return -1;
+    }
+
+    glfwSetKeyCallback( window, keyCallback );
+    glfwSetCursorPosCallback( window, cursorPositionCallback );
+    glfwSetMouseButtonCallback( window, mouseButtonCallback );
+    glfwSetScrollCallback( window, scrollCallback );
+
+    std::string telemetryFilename = "telemetry.noot";
+
+    // caps the frame rate when vsync is off, at the refresh rate of the monitor by default
+    GLFWvidmode const * videoMode = glfwGetVideoMode( glfwGetPrimaryMonitor() );
+    double targetFrameRate = videoMode != nullptr ? videoMode->refreshRate : 60.0;
+
+    // --record <file> saves the input of the session, --replay <file> plays it
+    // back in place of the live input, for benchmarks along the same camera path.
+    // --fps <rate> overrides the frame rate cap, 0 disables it
+    for ( int i = 1; i + 1 < argc; i += 2 )
+    {
+        std::string const option = argv[ i ];
+
+        if ( option == "--record" )
+            inputHandler.startRecording( argv[ i + 1 ] );
+        else if ( option == "--replay" )
+            inputHandler.startReplay( argv[ i + 1 ] );
+        else if ( option == "--telemetry" )
+            telemetryFilename = argv[ i + 1 ];
+        else if ( option == "--fps" )
+            targetFrameRate = std::atof( argv[ i + 1 ] );
+        else
+            NOO_LOG_WARN( "Unknown option {}.", option );
+    }
+
+    // per frame statistics in binary, decoded by noo_telemetry
+    noo::logging::EventLog telemetry;
+
+    if ( ! telemetry.open( telemetryFilename ) )
+        NOO_LOG_WARN( "Couldn't open {}, telemetry is off.", telemetryFilename );
+
+    noo::scene::Camera cam;
+    cam.setAspectRatio( static_cast< float >( window_size.x ) / window_size.y );
+    cam.setPosition( 0, 0, 3 );
+    cam.lookAt( 0, 0, 0 );
+
+    CameraOrbitController camControl( cam );
+    inputHandler.addListener( &camControl );
+
+    RenderModeSwitch rms;
+    inputHandler.addListener( &rms );
+
+    noo::common::ThreadPool workers;
+
+    // a big light over the scene plus a ring of small ones, each only touching a few pixels
+    std::vector< noo::scene::PointLight > lights = { { { 0, 0, 5 }, { 1.0f, 1.0f, 1.0f }, 10.0f } };
+
+    int const numRingLights = 16;
+
+    for ( int i = 0; i < numRingLights; ++i )
+    {
+        float const a = glm::two_pi< float >() * i / numRingLights;
+        glm::vec3 const color( 0.5f + 0.5f * std::cos( a ), 0.5f + 0.5f * std::sin( a ), 1.0f - 0.5f * std::cos( a ) );
+
+        lights.push_back( { { 2.0f * std::cos( a ), 0.5f, 2.0f * std::sin( a ) }, color, 1.0f } );
+    }
+
+    // the ring turns with the fixed simulation step, frames show it between the last two steps
+    float const ringSpeed = 0.25f;
+    float ringAngle = 0.0f;
+    float lastRingAngle = 0.0f;
+
+    noo::common::FrameScheduler scheduler( 1.0 / 60.0 );
+
+    scheduler.setTargetFrameRate( targetFrameRate );
+
+    noo::scene::TransformHierarchy transforms;
+    noo::scene::TransformHierarchy::NodeId const terrainNode = transforms.addNode();
+
+    // simulates frame N while the render thread draws frame N - 1
+    noo::common::DoubleBuffer< FrameSnapshot > frames;
+    std::atomic< bool > loadFinished{ false };
+    std::thread renderThread( renderLoop, window, window_size, std::ref( frames ), std::ref( workers ), terrainNode, std::ref( telemetry ), std::ref( loadFinished ) );
+
+    // a replay simulates one step per frame, so it does not depend on the frame rate
+    scheduler.setFixedStepping( inputHandler.isReplaying() );
+
+    while ( ! glfwWindowShouldClose( window ) )
+    {
+        scheduler.pace();
+
+        // recordings count frames from the loaded scene on, so loading times don't shift a replay
+        bool const loaded = loadFinished.load( std::memory_order_acquire );
+
+        if ( loaded && ! inputHandler.beginFrame() )
+        {
+            // the last replayed frame reports the timings of the run
+            noolog::info( "Input replay finished." );
+            rms.PrintStats = true;
+            glfwSetWindowShouldClose( window, 1 );
+        }
+
+        glfwPollEvents();
+
+        // a replay holds the simulation until it starts
+        for ( int steps = loaded || ! inputHandler.isReplaying() ? scheduler.beginFrame() : 0; steps > 0; --steps )
+        {
+            lastRingAngle = ringAngle;
+            ringAngle += ringSpeed * static_cast< float >( scheduler.getStep() );
+        }
+
+        float const shownAngle = glm::mix( lastRingAngle, ringAngle, static_cast< float >( scheduler.getAlpha() ) );
+
+        for ( int i = 0; i < numRingLights; ++i )
+        {
+            float const a = shownAngle + glm::two_pi< float >() * i / numRingLights;
+            lights[ 1 + i ].Position = { 2.0f * std::cos( a ), 0.5f, 2.0f * std::sin( a ) };
+        }
+
+        transforms.update( &workers );
+
+        FrameSnapshot * frame = frames.beginWrite();
+
+        if ( frame == nullptr )
+            break;
+
+        frame->InputTime = inputHandler.takeLatestEventTime();
+        frame->Camera = cam.getSnapshot();
+        frame->Settings = rms;
+        frame->Lights = lights;
+        // the slot still holds the changes of two frames ago
+        frame->MovedNodes.clear();
+        transforms.getChanged( frame->MovedNodes );
+
+        frames.endWrite();
+
+        rms.PrintStats = false;
     }
 
+    inputHandler.stopRecording();
+
+    frames.close();
+    renderThread.join();
+
     glfwTerminate();
 
     noolog::info( "Goodbye." );
+    noolog::disableAsync();
 
     return 0;
 }
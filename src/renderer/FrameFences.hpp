@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: FrameFences.hpp                                                  ///
+/// @brief: Limits how many frames the CPU may queue ahead of the GPU. A    ///
+///         fence is inserted after every frame, before a new frame is      ///
+///         recorded the CPU waits for the fence of the frame that many     ///
+///         frames ago. Fewer frames in flight means less input latency.    ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_RENDERER_FRAMEFENCES_HPP_INCLUDED
+#define NOO_RENDERER_FRAMEFENCES_HPP_INCLUDED
+
+
+/// Includes
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "glad/glad.h"
+
+
+namespace noo {
+namespace renderer {
+
+class FrameFences
+{
+    friend class Renderer;
+
+public:
+
+    /// @brief Upper bound of setMaxFramesInFlight().
+    static constexpr int MaxFramesInFlight = 3;
+
+    /// @brief Clamped to [1, MaxFramesInFlight]. 1 waits for the GPU to finish
+    ///        the last frame before the next one is recorded.
+    void
+    setMaxFramesInFlight( int numFrames )
+    { m_FramesInFlight = std::max( 1, std::min( numFrames, MaxFramesInFlight ) ); }
+
+    int
+    getMaxFramesInFlight() const
+    { return m_FramesInFlight; }
+
+private:
+
+    /// @brief Single waits are this long, the wait is repeated until the fence signals.
+    static constexpr GLuint64 WaitTimeoutNs = 100000000;
+
+    struct Slot
+    {
+        GLsync Fence = nullptr;
+        uint64_t Frame = 0;
+    };
+
+    void
+    destroy()
+    {
+        for ( auto & s : m_Slots )
+        {
+            if ( s.Fence != nullptr )
+                glDeleteSync( s.Fence );
+
+            s.Fence = nullptr;
+        }
+    }
+
+    /// @brief Blocks until fewer than the max frames are in flight.
+    /// @return The time spent waiting in microseconds.
+    int64_t
+    wait()
+    {
+        auto const start = std::chrono::steady_clock::now();
+
+        for ( auto & s : m_Slots )
+        {
+            if ( s.Fence == nullptr || s.Frame + m_FramesInFlight > m_Frame )
+                continue;
+
+            // the first wait flushes, so the fence is sure to be submitted
+            GLenum result = glClientWaitSync( s.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, WaitTimeoutNs );
+
+            while ( result == GL_TIMEOUT_EXPIRED )
+                result = glClientWaitSync( s.Fence, 0, WaitTimeoutNs );
+
+            glDeleteSync( s.Fence );
+            s.Fence = nullptr;
+        }
+
+        return std::chrono::duration_cast< std::chrono::microseconds >( std::chrono::steady_clock::now() - start ).count();
+    }
+
+    /// @brief Marks the end of the commands of the current frame.
+    void
+    signal()
+    {
+        // at most MaxFramesInFlight fences are alive, wait() freed this one already
+        Slot & s = m_Slots[ m_Frame % MaxFramesInFlight ];
+
+        if ( s.Fence != nullptr )
+            glDeleteSync( s.Fence );
+
+        s.Fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+        s.Frame = m_Frame++;
+    }
+
+    std::array< Slot, MaxFramesInFlight > m_Slots;
+
+    uint64_t m_Frame = 0;
+    int m_FramesInFlight = 2;
+};
+
+} // - namespace renderer
+} // - namespace noo
+
+
+#endif /* NOO_RENDERER_FRAMEFENCES_HPP_INCLUDED */
@@ -13,6 +13,8 @@
 
 
 /// Includes
+#include <vector>
+
 #include "VertexBuffer.hpp"
 #include "VertexTypes.hpp"
 #include "IndexBuffer.hpp"
@@ -24,6 +26,12 @@
 namespace noo {
 namespace renderer {
 
+struct VertexStream
+{
+    VertexBuffer * Buffer;
+    VertexDescription Format;
+};
+
 struct Geometry
 {
     bool IsIndexed() const
@@ -33,6 +41,11 @@ struct Geometry
     int NumPrimitives;
     VertexDescription VertexFormat;
 
+    /// @brief Streams read besides Vertices, e.g. normals next to a position-only
+    ///        stream. Their components get the attribute locations following
+    ///        those of VertexFormat, in order.
+    std::vector< VertexStream > AttributeStreams;
+
     IndexBuffer * Indices;
 
     int Offset = 0;
@@ -43,13 +43,65 @@ public:
     { glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 ); }
 
     void
-    upload( uint32_t numBytes, void * data )
+    upload( uint32_t numBytes, void const * data )
     {
         glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_GLHandle );
         glBufferData( GL_ELEMENT_ARRAY_BUFFER, numBytes, data, GL_STATIC_DRAW );
         glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
     }
 
+    /// @brief Reserves storage without data, filled with uploadRange().
+    void
+    allocate( size_t numBytes )
+    {
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_GLHandle );
+        glBufferData( GL_ELEMENT_ARRAY_BUFFER, numBytes, nullptr, GL_STATIC_DRAW );
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+    }
+
+    void
+    uploadRange( size_t offset, size_t numBytes, void const * data )
+    {
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_GLHandle );
+        glBufferSubData( GL_ELEMENT_ARRAY_BUFFER, offset, numBytes, data );
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+    }
+
+    /// @brief Creates immutable storage of numBytes and maps all of it for
+    ///        writing, so data is produced in place instead of copied in.
+    ///        The mapping is persistent, any thread may write through it while
+    ///        the render thread goes on with other GL work. The buffer must not
+    ///        be drawn from until unmap().
+    /// @return nullptr if the storage could not be mapped.
+    void *
+    map( size_t numBytes )
+    {
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_GLHandle );
+        glBufferStorage( GL_ELEMENT_ARRAY_BUFFER, numBytes, nullptr, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT );
+        void * data = glMapBufferRange( GL_ELEMENT_ARRAY_BUFFER, 0, numBytes, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_FLUSH_EXPLICIT_BIT | GL_MAP_INVALIDATE_BUFFER_BIT );
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+        m_MappedSize = data != nullptr ? numBytes : 0;
+
+        return data;
+    }
+
+    /// @brief Makes the writes through the mapping visible to the GL, call it on
+    ///        the render thread after the writing threads are done.
+    /// @return false if the contents were lost while mapped and need writing again.
+    bool
+    unmap()
+    {
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_GLHandle );
+        glFlushMappedBufferRange( GL_ELEMENT_ARRAY_BUFFER, 0, m_MappedSize );
+        GLboolean const ok = glUnmapBuffer( GL_ELEMENT_ARRAY_BUFFER );
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+        m_MappedSize = 0;
+
+        return ok == GL_TRUE;
+    }
+
 protected:
 
     IndexBuffer()
@@ -61,6 +113,9 @@ protected:
 private:
 
     GLuint m_GLHandle;
+
+    /// @brief Size of the mapping while mapped, 0 otherwise.
+    size_t m_MappedSize = 0;
 };
 
 } // - namespace renderer
@@ -0,0 +1,491 @@
+
+///////////////////////////////////////////////////////////////////////////////
+/// @file: RenderStats.hpp                                                  ///
+/// @brief: Per frame draw call / primitive counters and GPU pass timings.  ///
+///         GPU times are measured with timestamp queries which are read    ///
+///         back a few frames later, so measuring never stalls the CPU.     ///
+///         Input latency is tracked to the swap and, with fences polled    ///
+///         every frame, to the GPU finishing the frame.                    ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_RENDERER_RENDERSTATS_HPP_INCLUDED
+#define NOO_RENDERER_RENDERSTATS_HPP_INCLUDED
+
+
+/// Includes
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "glad/glad.h"
+
+
+namespace noo {
+namespace renderer {
+
+struct PassStats
+{
+    std::string Name;
+
+    int DrawCalls = 0;
+    uint64_t Primitives = 0;
+
+    /// @brief GPU time of the pass, smoothed over several frames.
+    double GpuTimeMs = 0.0;
+
+    /// @brief GPU time of the pass in FrameStats::Frame alone, -1 if its query
+    ///        was not available.
+    double GpuSampleMs = -1.0;
+};
+
+/// @brief Distribution of latencies in 1 ms buckets.
+struct LatencyHistogram
+{
+    /// @brief The last bucket collects everything above.
+    static constexpr int NumBuckets = 128;
+
+    std::array< uint32_t, NumBuckets > Buckets = {};
+
+    uint64_t Count = 0;
+    double SumMs = 0.0;
+    double MaxMs = 0.0;
+
+    void
+    add( double ms )
+    {
+        int const bucket = std::min( static_cast< int >( std::max( ms, 0.0 ) ), NumBuckets - 1 );
+
+        ++Buckets[ bucket ];
+        ++Count;
+        SumMs += ms;
+        MaxMs = std::max( MaxMs, ms );
+    }
+
+    double
+    getMeanMs() const
+    { return Count > 0 ? SumMs / Count : 0.0; }
+
+    /// @brief Upper end of the bucket the given fraction of samples falls into, e.g. 0.99.
+    double
+    getPercentileMs( double fraction ) const
+    {
+        uint64_t const rank = static_cast< uint64_t >( fraction * Count );
+        uint64_t sum = 0;
+
+        for ( int i = 0; i < NumBuckets; ++i )
+        {
+            sum += Buckets[ i ];
+
+            if ( sum > rank )
+                return i + 1 < NumBuckets ? std::min( i + 1.0, MaxMs ) : MaxMs;
+        }
+
+        return MaxMs;
+    }
+
+    void
+    reset()
+    { *this = LatencyHistogram(); }
+
+    std::string
+    toString() const
+    {
+        std::ostringstream ss;
+        ss.precision( 1 );
+        ss << std::fixed << "p50 " << getPercentileMs( 0.5 ) << " ms, p95 " << getPercentileMs( 0.95 ) << " ms, p99 " << getPercentileMs( 0.99 )
+           << " ms, max " << MaxMs << " ms, " << Count << " samples";
+
+        return ss.str();
+    }
+};
+
+struct FrameStats
+{
+    /// @brief 1 based index of the frame the statistics belong to, 0 until the
+    ///        first frame is resolved. The samples below are of this frame.
+    uint64_t Frame = 0;
+
+    int DrawCalls = 0;
+    uint64_t Primitives = 0;
+
+    /// @brief CPU time between beginFrame() and endFrame(), smoothed.
+    double CpuTimeMs = 0.0;
+
+    /// @brief CPU time of Frame alone.
+    double CpuSampleMs = 0.0;
+
+    std::vector< PassStats > Passes;
+
+    /// @brief Application defined values of the frame, e.g. culling results.
+    std::vector< std::pair< std::string, int64_t > > Counters;
+
+    /// @brief From the newest input a frame reflects to the return of its buffer
+    ///        swap, accumulated until reset.
+    LatencyHistogram InputToSwap;
+
+    /// @brief From the newest input to the GPU having executed the frame, up to
+    ///        a frame late as the fences are polled at frame start and swap.
+    LatencyHistogram InputToGpu;
+
+    PassStats const *
+    findPass( std::string const & name ) const
+    {
+        for ( auto const & p : Passes )
+        {
+            if ( p.Name == name )
+                return &p;
+        }
+
+        return nullptr;
+    }
+
+    std::string
+    toString() const
+    {
+        std::ostringstream ss;
+        ss << *this;
+
+        return ss.str();
+    }
+
+    /// @brief Writes toString(), lets the logger format the stats on its own thread.
+    friend std::ostream &
+    operator<<( std::ostream & ss, FrameStats const & stats )
+    {
+        stats.write( ss );
+        return ss;
+    }
+
+private:
+
+    void
+    write( std::ostream & ss ) const
+    {
+        std::ios::fmtflags const flags = ss.flags();
+        std::streamsize const precision = ss.precision( 3 );
+        ss << std::fixed << "cpu " << CpuTimeMs << " ms, " << DrawCalls << " draws, " << Primitives << " tris";
+
+        for ( auto const & p : Passes )
+        {
+            ss << "\n    " << p.Name << ": gpu " << p.GpuTimeMs << " ms, " << p.DrawCalls << " draws, " << p.Primitives << " tris";
+        }
+
+        for ( auto const & c : Counters )
+        {
+            ss << "\n    " << c.first << ": " << c.second;
+        }
+
+        if ( InputToSwap.Count > 0 )
+            ss << "\n    input to swap: " << InputToSwap.toString();
+
+        if ( InputToGpu.Count > 0 )
+            ss << "\n    input to gpu: " << InputToGpu.toString();
+
+        ss.flags( flags );
+        ss.precision( precision );
+    }
+};
+
+
+class RenderStats
+{
+    friend class Renderer;
+
+public:
+
+    /// @brief The statistics of the newest frame whose GPU timings are known,
+    ///        FrameLatency frames back. Totals, counters and passes all belong to it.
+    FrameStats const &
+    getFrameStats() const
+    { return m_Resolved; }
+
+private:
+
+    /// @brief Number of frames a timestamp query may stay in flight.
+    static constexpr int FrameLatency = 3;
+
+    /// @brief Weight of the newest sample in the running averages.
+    static constexpr double Smoothing = 0.1;
+
+    struct PassQuery
+    {
+        std::string Name;
+        GLuint Begin = 0;
+        GLuint End = 0;
+        int DrawCalls = 0;
+        uint64_t Primitives = 0;
+    };
+
+    /// @brief Everything recorded for one frame, resolved together once its queries are done.
+    struct FrameSlot
+    {
+        std::vector< PassQuery > Passes;
+        size_t NumUsed = 0;
+
+        uint64_t Frame = 0;
+        int DrawCalls = 0;
+        uint64_t Primitives = 0;
+        double CpuTimeMs = 0.0;
+        std::vector< std::pair< std::string, int64_t > > Counters;
+
+        /// @brief Whether endFrame() completed the slot.
+        bool Ended = false;
+    };
+
+    void
+    destroy()
+    {
+        for ( auto & slot : m_Slots )
+        {
+            for ( auto & p : slot.Passes )
+            {
+                glDeleteQueries( 1, &p.Begin );
+                glDeleteQueries( 1, &p.End );
+            }
+
+            slot.Passes.clear();
+            slot.NumUsed = 0;
+        }
+
+        for ( auto & f : m_LatencyFences )
+            glDeleteSync( f.Fence );
+
+        m_LatencyFences.clear();
+    }
+
+    void
+    beginFrame()
+    {
+        m_Current = ( m_Current + 1 ) % FrameLatency;
+
+        // the queries of this slot were issued FrameLatency frames ago
+        FrameSlot & slot = m_Slots[ m_Current ];
+        resolve( slot );
+        slot.NumUsed = 0;
+        slot.Frame = ++m_NumFrames;
+        slot.Counters.clear();
+        slot.Ended = false;
+
+        m_DrawCalls = 0;
+        m_Primitives = 0;
+        m_FrameStart = std::chrono::steady_clock::now();
+
+        pollLatencyFences();
+    }
+
+    void
+    endFrame()
+    {
+        // the totals wait in the slot for the pass timings of the same frame
+        FrameSlot & slot = m_Slots[ m_Current ];
+        slot.DrawCalls = m_DrawCalls;
+        slot.Primitives = m_Primitives;
+        slot.CpuTimeMs = std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - m_FrameStart ).count();
+        slot.Counters.swap( m_Counters );
+        slot.Ended = true;
+
+        m_Counters.clear();
+    }
+
+    void
+    beginPass( char const * name )
+    {
+        endPass();
+
+        FrameSlot & slot = m_Slots[ m_Current ];
+
+        if ( slot.NumUsed == slot.Passes.size() )
+        {
+            slot.Passes.emplace_back();
+            glGenQueries( 1, &slot.Passes.back().Begin );
+            glGenQueries( 1, &slot.Passes.back().End );
+        }
+
+        m_ActivePass = &slot.Passes[ slot.NumUsed++ ];
+        m_ActivePass->Name = name;
+        m_ActivePass->DrawCalls = 0;
+        m_ActivePass->Primitives = 0;
+
+        glQueryCounter( m_ActivePass->Begin, GL_TIMESTAMP );
+    }
+
+    void
+    endPass()
+    {
+        if ( m_ActivePass != nullptr )
+        {
+            glQueryCounter( m_ActivePass->End, GL_TIMESTAMP );
+            m_ActivePass = nullptr;
+        }
+    }
+
+    void
+    setCounter( char const * name, int64_t value )
+    {
+        for ( auto & c : m_Counters )
+        {
+            if ( c.first == name )
+            {
+                c.second = value;
+                return;
+            }
+        }
+
+        m_Counters.emplace_back( name, value );
+    }
+
+    void
+    setInputTime( std::chrono::steady_clock::time_point time )
+    { m_InputTime = time; }
+
+    void
+    framePresented()
+    {
+        pollLatencyFences();
+
+        if ( m_InputTime == std::chrono::steady_clock::time_point() )
+            return;
+
+        m_Resolved.InputToSwap.add( std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - m_InputTime ).count() );
+
+        // signals once the GPU executed everything up to and including the swap
+        m_LatencyFences.push_back( { glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 ), m_InputTime } );
+        m_InputTime = {};
+    }
+
+    void
+    resetLatency()
+    {
+        m_Resolved.InputToSwap.reset();
+        m_Resolved.InputToGpu.reset();
+    }
+
+    /// @brief Records the frames the GPU finished since the last poll, never waits.
+    void
+    pollLatencyFences()
+    {
+        while ( ! m_LatencyFences.empty() )
+        {
+            LatencyFence const & f = m_LatencyFences.front();
+
+            if ( glClientWaitSync( f.Fence, 0, 0 ) == GL_TIMEOUT_EXPIRED )
+                break;
+
+            m_Resolved.InputToGpu.add( std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - f.InputTime ).count() );
+
+            glDeleteSync( f.Fence );
+            m_LatencyFences.pop_front();
+        }
+    }
+
+    void
+    countDraw( int numPrimitives )
+    {
+        ++m_DrawCalls;
+        m_Primitives += numPrimitives;
+
+        if ( m_ActivePass != nullptr )
+        {
+            ++m_ActivePass->DrawCalls;
+            m_ActivePass->Primitives += numPrimitives;
+        }
+    }
+
+    /// @brief Passes which were not issued in the resolved frame are dropped from the stats.
+    void
+    resolve( FrameSlot const & slot )
+    {
+        if ( ! slot.Ended )
+            return;
+
+        m_Resolved.Frame = slot.Frame;
+        m_Resolved.DrawCalls = slot.DrawCalls;
+        m_Resolved.Primitives = slot.Primitives;
+        m_Resolved.CpuTimeMs = smooth( m_Resolved.CpuTimeMs, slot.CpuTimeMs );
+        m_Resolved.CpuSampleMs = slot.CpuTimeMs;
+        m_Resolved.Counters = slot.Counters;
+
+        std::vector< PassStats > passes;
+        passes.reserve( slot.NumUsed );
+
+        for ( size_t i = 0; i < slot.NumUsed; ++i )
+        {
+            PassQuery const & q = slot.Passes[ i ];
+
+            passes.emplace_back();
+            PassStats & ps = passes.back();
+
+            if ( PassStats const * previous = m_Resolved.findPass( q.Name ) )
+                ps = *previous;
+
+            ps.Name = q.Name;
+            ps.DrawCalls = q.DrawCalls;
+            ps.Primitives = q.Primitives;
+            ps.GpuSampleMs = -1.0;
+
+            GLint available = 0;
+            glGetQueryObjectiv( q.End, GL_QUERY_RESULT_AVAILABLE, &available );
+
+            if ( ! available )
+                continue;
+
+            GLuint64 t0 = 0, t1 = 0;
+            glGetQueryObjectui64v( q.Begin, GL_QUERY_RESULT, &t0 );
+            glGetQueryObjectui64v( q.End, GL_QUERY_RESULT, &t1 );
+
+            ps.GpuSampleMs = static_cast< double >( t1 - t0 ) * 1.0e-6;
+            ps.GpuTimeMs = smooth( ps.GpuTimeMs, ps.GpuSampleMs );
+        }
+
+        m_Resolved.Passes.swap( passes );
+    }
+
+    static double
+    smooth( double average, double sample )
+    {
+        return average == 0.0 ? sample : average + ( sample - average ) * Smoothing;
+    }
+
+    std::array< FrameSlot, FrameLatency > m_Slots;
+    int m_Current = 0;
+
+    /// @brief Frames begun so far.
+    uint64_t m_NumFrames = 0;
+
+    PassQuery * m_ActivePass = nullptr;
+
+    int m_DrawCalls = 0;
+    uint64_t m_Primitives = 0;
+    std::chrono::steady_clock::time_point m_FrameStart;
+
+    std::vector< std::pair< std::string, int64_t > > m_Counters;
+
+    struct LatencyFence
+    {
+        GLsync Fence;
+        std::chrono::steady_clock::time_point InputTime;
+    };
+
+    /// @brief Input time of the frame being recorded, none if default.
+    std::chrono::steady_clock::time_point m_InputTime;
+
+    /// @brief Presented frames with input, oldest first.
+    std::deque< LatencyFence > m_LatencyFences;
+
+    FrameStats m_Resolved;
+};
+
+} // - namespace renderer
+} // - namespace noo
+
+
+#endif /* NOO_RENDERER_RENDERSTATS_HPP_INCLUDED */
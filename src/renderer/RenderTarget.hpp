@@ -98,7 +98,7 @@ public:
 
         checkStatus();
 
-        noolog::debug( "Attached texture successfully." );
+        NOO_LOG_DEBUG( "Attached texture successfully." );
 
         glBindFramebuffer( GL_FRAMEBUFFER, 0 );
 
@@ -113,7 +113,7 @@ public:
 
         checkStatus();
 
-        noolog::debug( "Attached render buffer successfully." );
+        NOO_LOG_DEBUG( "Attached render buffer successfully." );
 
         glBindFramebuffer( GL_FRAMEBUFFER, 0 );
 
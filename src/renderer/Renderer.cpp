@@ -1,6 +1,7 @@
 #include "Renderer.hpp"
 #include "../logging/Logger.hpp"
 #include <iostream>
+#include <cstring>
 #include "glad/glad.h"
 
 using noolog = noo::logging::Logger;
@@ -9,27 +10,57 @@ namespace noo {
 namespace renderer {
 
 
-void Renderer::initialize( int width, int height )
+void Renderer::initialize( int width, int height, GLADloadproc loadProc )
 {
     m_DefaultRenderTarget.reset( new RenderTarget( width, height, 0 ) );
     noolog::info( "Initialized Renderer." );
 
     glGenVertexArrays( 1, &m_DefaultVAO );
     glBindVertexArray( m_DefaultVAO );
+
+    if ( loadProc != nullptr )
+    {
+        GLint numExtensions = 0;
+        glGetIntegerv( GL_NUM_EXTENSIONS, &numExtensions );
+
+        for ( GLint i = 0; i < numExtensions; ++i )
+        {
+            char const * ext = reinterpret_cast< char const * >( glGetStringi( GL_EXTENSIONS, i ) );
+
+            if ( std::strcmp( ext, "GL_EXT_depth_bounds_test" ) == 0 )
+            {
+                m_DepthBoundsEXT = reinterpret_cast< PFNGLDEPTHBOUNDSEXTPROC >( loadProc( "glDepthBoundsEXT" ) );
+            }
+        }
+    }
+
+    NOO_LOG_INFO( "Depth bounds test {}available.", supportsDepthBounds() ? "" : "not " );
 }
 
 
 void Renderer::destroy()
 {
+    m_Stats.destroy();
+    m_Fences.destroy();
     glDeleteVertexArrays( 1, &m_DefaultVAO );
     noolog::info( "Destroyed Renderer." );
 }
 
 
-void Renderer::clear( RenderTarget const & rt, glm::vec4 const & clearColor, float clearDepth, int clearStencil )
+void Renderer::prepareClear( RenderTarget const & rt )
 {
     glViewport( 0, 0, rt.getWidth(), rt.getHeight() );
+    glDisable( GL_SCISSOR_TEST );
+    glColorMask( GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
+    glDepthMask( GL_TRUE );
+    glStencilMask( 0xFF );
     rt.activate();
+}
+
+
+void Renderer::clear( RenderTarget const & rt, glm::vec4 const & clearColor, float clearDepth, int clearStencil )
+{
+    prepareClear( rt );
     glClearColor( clearColor.r, clearColor.g, clearColor.b, clearColor.a );
     glClearDepth( clearDepth );
     glClearStencil( clearStencil );
@@ -37,5 +68,21 @@ void Renderer::clear( RenderTarget const & rt, glm::vec4 const & clearColor, flo
 }
 
 
+void Renderer::clearColor( RenderTarget const & rt, glm::vec4 const & clearColor )
+{
+    prepareClear( rt );
+    glClearColor( clearColor.r, clearColor.g, clearColor.b, clearColor.a );
+    glClear( GL_COLOR_BUFFER_BIT );
+}
+
+
+void Renderer::clearStencil( RenderTarget const & rt, int clearStencil )
+{
+    prepareClear( rt );
+    glClearStencil( clearStencil );
+    glClear( GL_STENCIL_BUFFER_BIT );
+}
+
+
 } // - namespace renderer
 } // - namespace noo
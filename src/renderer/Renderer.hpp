@@ -12,6 +12,15 @@
 #include "IndexBuffer.hpp"
 #include "RenderTarget.hpp"
 #include "Geometry.hpp"
+#include "RenderStats.hpp"
+#include "FrameFences.hpp"
+
+
+#ifndef GL_DEPTH_BOUNDS_TEST_EXT
+#define GL_DEPTH_BOUNDS_TEST_EXT 0x8890
+#endif
+
+typedef void ( APIENTRYP PFNGLDEPTHBOUNDSEXTPROC )( GLclampd zmin, GLclampd zmax );
 
 
 namespace noo {
@@ -22,8 +31,11 @@ class Renderer
 {
 public:
 
+    /// @brief Set up the default render target and vertex array object.
+    /// @param loadProc Optional GL function loader used to query extensions
+    ///        which are not part of core profile (e.g. GL_EXT_depth_bounds_test).
     void
-    initialize( int width, int height );
+    initialize( int width, int height, GLADloadproc loadProc = nullptr );
 
     void
     destroy();
@@ -33,6 +45,82 @@ public:
     void
     clear( RenderTarget const & rt, glm::vec4 const & clearColor, float clearDepth = 1.0f, int clearStencil = 0 );
 
+    /// @brief Clear only the color buffers, depth and stencil are left untouched.
+    void
+    clearColor( RenderTarget const & rt, glm::vec4 const & clearColor );
+
+    /// @brief Clear only the stencil buffer, color and depth are left untouched.
+    void
+    clearStencil( RenderTarget const & rt, int clearStencil );
+
+    /// @brief Marks the start of a new frame for the statistics. Waits first
+    ///        if the GPU is more than the max frames in flight behind.
+    void
+    beginFrame()
+    {
+        int64_t const waited = m_Fences.wait();
+
+        m_Stats.beginFrame();
+        m_Stats.setCounter( "fence wait us", waited );
+    }
+
+    void
+    endFrame()
+    {
+        m_Stats.endFrame();
+        m_Fences.signal();
+    }
+
+    /// @brief Number of frames the CPU may record ahead of the GPU, 1 to 3.
+    void
+    setMaxFramesInFlight( int numFrames )
+    { m_Fences.setMaxFramesInFlight( numFrames ); }
+
+    int
+    getMaxFramesInFlight() const
+    { return m_Fences.getMaxFramesInFlight(); }
+
+    /// @brief Draw calls until endPass() are accounted to the named pass and timed on the GPU.
+    void
+    beginPass( char const * name )
+    { m_Stats.beginPass( name ); }
+
+    void
+    endPass()
+    { m_Stats.endPass(); }
+
+    /// @brief Reports an application defined value for the current frame.
+    void
+    setCounter( char const * name, int64_t value )
+    { m_Stats.setCounter( name, value ); }
+
+    /// @brief Time of the newest input the current frame reflects. Its latency to
+    ///        the swap and to the GPU finishing the frame is added to the
+    ///        histograms of the frame statistics.
+    void
+    setInputTime( std::chrono::steady_clock::time_point time )
+    { m_Stats.setInputTime( time ); }
+
+    /// @brief Call right after the buffer swap of the frame.
+    void
+    framePresented()
+    { m_Stats.framePresented(); }
+
+    /// @brief Clears the latency histograms.
+    void
+    resetLatencyStats()
+    { m_Stats.resetLatency(); }
+
+    /// @brief Statistics of a frame completed a few frames ago, the newest with GPU timings.
+    FrameStats const &
+    getFrameStats() const
+    { return m_Stats.getFrameStats(); }
+
+    /// @brief Whether DepthBoundsState is honored by draw().
+    bool
+    supportsDepthBounds() const
+    { return m_DepthBoundsEXT != nullptr; }
+
 
     /// @brief Create a new shader from the given source. Vertex and fragment stages are mandatory.
     ///        Tesselation control/evaluation and geometry stages are optional.
@@ -108,6 +196,9 @@ public:
             glDisable( GL_BLEND );
         }
 
+        GLboolean const colorWrite = state.blend.ColorWrite == state::EColorWriteEnable::ENABLE ? GL_TRUE : GL_FALSE;
+        glColorMask( colorWrite, colorWrite, colorWrite, colorWrite );
+
         // cull
         if ( state.cull.CullMode == state::ECullMode::NONE )
         {
@@ -132,8 +223,38 @@ public:
             glDisable( GL_DEPTH_TEST );
         }
 
+        // depth bounds
+        if ( m_DepthBoundsEXT != nullptr )
+        {
+            if ( state.depthBounds.Enabled == state::EDepthBoundsEnable::ENABLE )
+            {
+                glEnable( GL_DEPTH_BOUNDS_TEST_EXT );
+                m_DepthBoundsEXT( state.depthBounds.Min, state.depthBounds.Max );
+            }
+            else
+            {
+                glDisable( GL_DEPTH_BOUNDS_TEST_EXT );
+            }
+        }
+
         // stencil
-        // ... TODO
+        if ( state.stencil.Enabled == state::EStencilEnable::ENABLE )
+        {
+            state::StencilState const & st = state.stencil;
+
+            glEnable( GL_STENCIL_TEST );
+            glStencilMask( st.WriteMask );
+
+            glStencilFuncSeparate( GL_FRONT, toGLStencilFunc( st.Front.CompareFunc ), st.Reference, st.ReadMask );
+            glStencilOpSeparate( GL_FRONT, toGLStencilOp( st.Front.StencilFailOp ), toGLStencilOp( st.Front.DepthFailOp ), toGLStencilOp( st.Front.PassOp ) );
+
+            glStencilFuncSeparate( GL_BACK, toGLStencilFunc( st.Back.CompareFunc ), st.Reference, st.ReadMask );
+            glStencilOpSeparate( GL_BACK, toGLStencilOp( st.Back.StencilFailOp ), toGLStencilOp( st.Back.DepthFailOp ), toGLStencilOp( st.Back.PassOp ) );
+        }
+        else
+        {
+            glDisable( GL_STENCIL_TEST );
+        }
 
         // rasterizer
         if ( state.rasterizer.FillMode == state::EPolygonFillMode::LINE )
@@ -156,6 +277,17 @@ public:
             glViewport( state.viewport.X, state.viewport.Y, state.viewport.Width, state.viewport.Height );
         }
 
+        // scissor
+        if ( state.scissor.isEnabled() )
+        {
+            glEnable( GL_SCISSOR_TEST );
+            glScissor( state.scissor.X, state.scissor.Y, state.scissor.Width, state.scissor.Height );
+        }
+        else
+        {
+            glDisable( GL_SCISSOR_TEST );
+        }
+
         rt.activate();
 
         shd.getShader().activate();
@@ -189,16 +321,14 @@ public:
             }
         }
 
-        // TODO: expand to multiple vertex streams
-        geo.Vertices->activate();
+        GLuint location = 0;
 
-        for ( int i = 0; i < geo.VertexFormat.Components.size(); ++i )
-        {
-            VertexComponent const & v = geo.VertexFormat.Components[ i ];
+        bindVertexStream( *geo.Vertices, geo.VertexFormat, location );
 
-            glEnableVertexAttribArray( i );
-            glVertexAttribPointer( i, vcSize( v.Type ), toGLType( v.Type ), GL_FALSE, geo.VertexFormat.Stride, (GLvoid*)( v.Offset ) );
-        }
+        for ( auto const & stream : geo.AttributeStreams )
+            bindVertexStream( *stream.Buffer, stream.Format, location );
+
+        m_Stats.countDraw( geo.NumPrimitives );
 
         if ( geo.IsIndexed() )
         {
@@ -213,6 +343,25 @@ public:
 
 private:
 
+    /// @brief Points the attributes from location on at the components of the stream.
+    static void
+    bindVertexStream( VertexBuffer & buffer, VertexDescription const & format, GLuint & location )
+    {
+        buffer.activate();
+
+        for ( VertexComponent const & v : format.Components )
+        {
+            glEnableVertexAttribArray( location );
+
+            if ( isInteger( v.Type ) )
+                glVertexAttribIPointer( location, vcSize( v.Type ), toGLType( v.Type ), format.Stride, (GLvoid*)( v.Offset ) );
+            else
+                glVertexAttribPointer( location, vcSize( v.Type ), toGLType( v.Type ), isNormalized( v.Type ) ? GL_TRUE : GL_FALSE, format.Stride, (GLvoid*)( v.Offset ) );
+
+            ++location;
+        }
+    }
+
     static GLenum
     toGLBlendFunc( state::EBlendFunc b )
     {
@@ -284,13 +433,55 @@ private:
         }
     }
 
+    static GLenum
+    toGLStencilFunc( state::EStencilFunc f )
+    {
+        switch ( f )
+        {
+            case state::EStencilFunc::ALWAYS: return GL_ALWAYS;
+            case state::EStencilFunc::NEVER: return GL_NEVER;
+            case state::EStencilFunc::LESS: return GL_LESS;
+            case state::EStencilFunc::EQUAL: return GL_EQUAL;
+            case state::EStencilFunc::LESS_EQUAL: return GL_LEQUAL;
+            case state::EStencilFunc::GREATER: return GL_GREATER;
+            case state::EStencilFunc::NOT_EQUAL: return GL_NOTEQUAL;
+            case state::EStencilFunc::GREATER_EQUAL: return GL_GEQUAL;
+        }
+    }
+
+    static GLenum
+    toGLStencilOp( state::EStencilOp o )
+    {
+        switch ( o )
+        {
+            case state::EStencilOp::KEEP: return GL_KEEP;
+            case state::EStencilOp::ZERO: return GL_ZERO;
+            case state::EStencilOp::REPLACE: return GL_REPLACE;
+            case state::EStencilOp::INCR: return GL_INCR;
+            case state::EStencilOp::INCR_WRAP: return GL_INCR_WRAP;
+            case state::EStencilOp::DECR: return GL_DECR;
+            case state::EStencilOp::DECR_WRAP: return GL_DECR_WRAP;
+            case state::EStencilOp::INVERT: return GL_INVERT;
+        }
+    }
+
 private:
 
+    /// @brief Resets all write masks and the scissor test, both would restrict glClear.
+    void
+    prepareClear( RenderTarget const & rt );
+
     /// @brief The window surface back buffer.
     std::shared_ptr< RenderTarget > m_DefaultRenderTarget;
 
     /// @brief In OpenGL 4 core profile a vertex array object has to be used.
     GLuint m_DefaultVAO;
+
+    /// @brief glDepthBoundsEXT, null if GL_EXT_depth_bounds_test is not available.
+    PFNGLDEPTHBOUNDSEXTPROC m_DepthBoundsEXT = nullptr;
+
+    RenderStats m_Stats;
+    FrameFences m_Fences;
 };
 
 } // - namespace renderer
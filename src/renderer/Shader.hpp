@@ -279,7 +279,7 @@ public:
 
         glDeleteProgram( m_ProgramHandle );
 
-        noolog::trace( "line " + std::to_string( __LINE__ ) + ":" + std::string( __func__ ) + " :: Destroyed shader." );
+        NOO_LOG_TRACE( "line {}:{} :: Destroyed shader.", __LINE__, __func__ );
     }
 
 
@@ -359,7 +359,7 @@ protected:
             std::vector< char > logInfo( logLen );
             glGetProgramInfoLog( m_ProgramHandle, logLen, NULL, &logInfo[ 0 ] );
 
-            noolog::debug( logInfo.data() );
+            NOO_LOG_DEBUG( "{}", logInfo.data() );
         }
 
         // enumerate uniforms
@@ -378,15 +378,15 @@ protected:
             GLint loc = glGetUniformLocation( m_ProgramHandle, name );
             if ( loc == -1 )
             {
-                noolog::error( name );
+                NOO_LOG_ERROR( "{}", name );
             }
 
             m_Uniforms.emplace_back( loc, type, std::string( name ) );
 
-            noolog::info( "Added uniform " + std::string( name ) );
+            NOO_LOG_INFO( "Added uniform {}", name );
         }
 
-        noolog::trace( "line " + std::to_string( __LINE__ ) + ":" + std::string( __func__ ) + " :: Created shader." );
+        NOO_LOG_TRACE( "line {}:{} :: Created shader.", __LINE__, __func__ );
     }
 
     std::vector< UniformDesc > const &
@@ -408,7 +408,7 @@ private:
             std::vector< char > logInfo( logLen );
             glGetShaderInfoLog( shader, logLen, NULL, &logInfo[ 0 ] );
 
-            noolog::debug( logInfo.data() );
+            NOO_LOG_DEBUG( "{}", logInfo.data() );
         }
     }
 
@@ -0,0 +1,200 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: VertexPacking.hpp                                                ///
+/// @brief: Encoders for the packed vertex component types and conversion   ///
+///         of float meshes into the packed vertex formats.                 ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_RENDERER_VERTEXPACKING_HPP_INCLUDED
+#define NOO_RENDERER_VERTEXPACKING_HPP_INCLUDED
+
+
+/// Includes
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "VertexTypes.hpp"
+
+
+namespace noo {
+namespace renderer {
+
+/// @brief Restores a quantized position in the shader: p = q * Scale + Offset,
+///        with q the normalized [0,1] position read from the vertex.
+struct PositionQuantization
+{
+    glm::vec3 Scale = glm::vec3( 1 );
+    glm::vec3 Offset = glm::vec3( 0 );
+};
+
+class VertexPacking
+{
+public:
+
+    static int16_t
+    packSnorm16( float v )
+    { return static_cast< int16_t >( std::lround( std::min( std::max( v, -1.0f ), 1.0f ) * 32767.0f ) ); }
+
+    static uint16_t
+    packUnorm16( float v )
+    { return static_cast< uint16_t >( std::lround( std::min( std::max( v, 0.0f ), 1.0f ) * 65535.0f ) ); }
+
+    static uint8_t
+    packUnorm8( float v )
+    { return static_cast< uint8_t >( std::lround( std::min( std::max( v, 0.0f ), 1.0f ) * 255.0f ) ); }
+
+    /// @brief Maps a unit vector onto the octahedron unfolded into [-1,1]^2.
+    static glm::vec2
+    encodeOctahedral( glm::vec3 const & n )
+    {
+        float const l1 = std::abs( n.x ) + std::abs( n.y ) + std::abs( n.z );
+
+        if ( l1 == 0.0f )
+            return glm::vec2( 0.0f );
+
+        glm::vec2 p( n.x / l1, n.y / l1 );
+
+        // the lower half is folded over the diagonals
+        if ( n.z < 0.0f )
+        {
+            glm::vec2 const folded( ( 1.0f - std::abs( p.y ) ) * ( p.x >= 0.0f ? 1.0f : -1.0f )
+                                  , ( 1.0f - std::abs( p.x ) ) * ( p.y >= 0.0f ? 1.0f : -1.0f ) );
+            p = folded;
+        }
+
+        return p;
+    }
+
+    /// @brief Inverse of encodeOctahedral(), as done in the shaders.
+    static glm::vec3
+    decodeOctahedral( glm::vec2 const & e )
+    {
+        glm::vec3 n( e.x, e.y, 1.0f - std::abs( e.x ) - std::abs( e.y ) );
+        float const t = std::max( -n.z, 0.0f );
+
+        n.x += n.x >= 0.0f ? -t : t;
+        n.y += n.y >= 0.0f ? -t : t;
+
+        return glm::normalize( n );
+    }
+
+    /// @brief The quantization that spans the bounds of positions with 16 bits per axis.
+    static PositionQuantization
+    computeQuantization( std::vector< glm::vec3 > const & positions )
+    {
+        PositionQuantization q;
+
+        if ( positions.empty() )
+            return q;
+
+        glm::vec3 lo = positions[ 0 ];
+        glm::vec3 hi = positions[ 0 ];
+
+        for ( auto const & p : positions )
+        {
+            lo = glm::min( lo, p );
+            hi = glm::max( hi, p );
+        }
+
+        return computeQuantization( lo, hi );
+    }
+
+    /// @brief The quantization that spans the box from lo to hi, e.g. the bounds
+    ///        of a whole model to share one grid between its meshes.
+    static PositionQuantization
+    computeQuantization( glm::vec3 const & lo, glm::vec3 const & hi )
+    {
+        PositionQuantization q;
+        q.Scale = hi - lo;
+        q.Offset = lo;
+
+        return q;
+    }
+
+    /// @brief Appends the vertices of a float mesh in packed form, interleaved.
+    /// @return What the shader needs to restore the positions.
+    static PositionQuantization
+    packMesh( std::vector< glm::vec3 > const & positions
+            , std::vector< glm::vec3 > const & normals
+            , std::vector< Vertex_PosQ4NrmOct > & outVertices )
+    {
+        std::vector< Vertex_PosQ4 > qp;
+        std::vector< Vertex_NrmOct > qn;
+
+        PositionQuantization const q = packMesh( positions, normals, qp, qn );
+
+        outVertices.reserve( outVertices.size() + qp.size() );
+
+        for ( size_t i = 0; i < qp.size(); ++i )
+            outVertices.push_back( { qp[ i ].x, qp[ i ].y, qp[ i ].z, qp[ i ].w, qn[ i ].nu, qn[ i ].nv } );
+
+        return q;
+    }
+
+    /// @brief Appends the vertices of a float mesh in packed form as two streams,
+    ///        so passes that need positions only fetch nothing else.
+    /// @return What the shader needs to restore the positions.
+    static PositionQuantization
+    packMesh( std::vector< glm::vec3 > const & positions
+            , std::vector< glm::vec3 > const & normals
+            , std::vector< Vertex_PosQ4 > & outPositions
+            , std::vector< Vertex_NrmOct > & outNormals )
+    {
+        size_t const first = outPositions.size();
+
+        outPositions.resize( first + positions.size() );
+        outNormals.resize( first + normals.size() );
+
+        return packMesh( positions, normals, outPositions.data() + first, outNormals.data() + first );
+    }
+
+    /// @brief Writes positions.size() packed vertices to each of the two streams,
+    ///        which may be mapped buffer memory, so it is written only once.
+    ///        The grid spans the bounds of the mesh. Meshes packed on separate
+    ///        grids round a shared border differently and may crack along it.
+    static PositionQuantization
+    packMesh( std::vector< glm::vec3 > const & positions
+            , std::vector< glm::vec3 > const & normals
+            , Vertex_PosQ4 * outPositions
+            , Vertex_NrmOct * outNormals )
+    {
+        return packMesh( positions, normals, computeQuantization( positions ), outPositions, outNormals );
+    }
+
+    /// @brief As above on the grid q, which has to contain all positions. Equal
+    ///        positions of meshes packed on the same grid stay equal.
+    static PositionQuantization
+    packMesh( std::vector< glm::vec3 > const & positions
+            , std::vector< glm::vec3 > const & normals
+            , PositionQuantization const & q
+            , Vertex_PosQ4 * outPositions
+            , Vertex_NrmOct * outNormals )
+    {
+        // flat axes store 0 and are restored from Offset alone
+        glm::vec3 const invScale( q.Scale.x > 0.0f ? 1.0f / q.Scale.x : 0.0f
+                                , q.Scale.y > 0.0f ? 1.0f / q.Scale.y : 0.0f
+                                , q.Scale.z > 0.0f ? 1.0f / q.Scale.z : 0.0f );
+
+        for ( size_t i = 0; i < positions.size(); ++i )
+        {
+            glm::vec3 const p = ( positions[ i ] - q.Offset ) * invScale;
+            glm::vec2 const n = encodeOctahedral( normals[ i ] );
+
+            outPositions[ i ] = { packUnorm16( p.x ), packUnorm16( p.y ), packUnorm16( p.z ), 0 };
+            outNormals[ i ] = { packSnorm16( n.x ), packSnorm16( n.y ) };
+        }
+
+        return q;
+    }
+};
+
+} // - namespace renderer
+} // - namespace noo
+
+
+#endif /* NOO_RENDERER_VERTEXPACKING_HPP_INCLUDED */
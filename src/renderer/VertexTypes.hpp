@@ -32,6 +32,14 @@ enum class EVertexComponentType
     FLOAT_2,
     FLOAT_3,
     FLOAT_4,
+
+    /// @brief Normalized, read as floats in [-1,1] or [0,1] by the shader.
+    BYTE_4_NORM,
+    UBYTE_4_NORM,
+    SHORT_2_NORM,
+    SHORT_4_NORM,
+    USHORT_2_NORM,
+    USHORT_4_NORM,
 };
 
 inline int
@@ -48,6 +56,13 @@ vcSize( EVertexComponentType t )
         case EVertexComponentType::FLOAT_2: return 2;
         case EVertexComponentType::FLOAT_3: return 3;
         case EVertexComponentType::FLOAT_4: return 4;
+
+        case EVertexComponentType::BYTE_4_NORM  : return 4;
+        case EVertexComponentType::UBYTE_4_NORM : return 4;
+        case EVertexComponentType::SHORT_2_NORM : return 2;
+        case EVertexComponentType::SHORT_4_NORM : return 4;
+        case EVertexComponentType::USHORT_2_NORM: return 2;
+        case EVertexComponentType::USHORT_4_NORM: return 4;
     }
 }
 
@@ -65,6 +80,45 @@ toGLType( EVertexComponentType t )
         case EVertexComponentType::FLOAT_2: return GL_FLOAT;
         case EVertexComponentType::FLOAT_3: return GL_FLOAT;
         case EVertexComponentType::FLOAT_4: return GL_FLOAT;
+
+        case EVertexComponentType::BYTE_4_NORM  : return GL_BYTE;
+        case EVertexComponentType::UBYTE_4_NORM : return GL_UNSIGNED_BYTE;
+        case EVertexComponentType::SHORT_2_NORM : return GL_SHORT;
+        case EVertexComponentType::SHORT_4_NORM : return GL_SHORT;
+        case EVertexComponentType::USHORT_2_NORM: return GL_UNSIGNED_SHORT;
+        case EVertexComponentType::USHORT_4_NORM: return GL_UNSIGNED_SHORT;
+    }
+}
+
+/// @brief Integer components are bound with glVertexAttribIPointer and read as
+///        (u)int/(u)ivecN, everything else as float/vecN.
+inline bool
+isInteger( EVertexComponentType t )
+{
+    switch ( t )
+    {
+        case EVertexComponentType::INT  :
+        case EVertexComponentType::INT_2:
+        case EVertexComponentType::INT_3:
+        case EVertexComponentType::INT_4: return true;
+
+        default: return false;
+    }
+}
+
+inline bool
+isNormalized( EVertexComponentType t )
+{
+    switch ( t )
+    {
+        case EVertexComponentType::BYTE_4_NORM  :
+        case EVertexComponentType::UBYTE_4_NORM :
+        case EVertexComponentType::SHORT_2_NORM :
+        case EVertexComponentType::SHORT_4_NORM :
+        case EVertexComponentType::USHORT_2_NORM:
+        case EVertexComponentType::USHORT_4_NORM: return true;
+
+        default: return false;
     }
 }
 
@@ -151,8 +205,104 @@ struct Vertex_Pos3Nrm3
     }
 };
 
+
+/// @brief Texture coordinates as 2 normalized shorts, for coordinates in [0,1].
+struct Vertex_Pos3Tex2US
+{
+    float x, y, z;
+    uint16_t u, v;
+
+    static constexpr int SizeInBytes = sizeof( float ) * 3 + sizeof( uint16_t ) * 2;
+
+    static VertexDescription const &
+    VertexDesc()
+    {
+        static VertexDescription vd{ { { EVertexComponentType::FLOAT_3, 0 }
+                                     , { EVertexComponentType::USHORT_2_NORM, 3 * sizeof( float ) } }
+                                   , SizeInBytes };
+        return vd;
+    }
+};
+
+
+/// @brief Colour as 4 normalized bytes.
+struct Vertex_Pos3Color4UB
+{
+    float x, y, z;
+    uint8_t r, g, b, a;
+
+    static constexpr int SizeInBytes = sizeof( float ) * 3 + 4;
+
+    static VertexDescription const &
+    VertexDesc()
+    {
+        static VertexDescription vd{ { { EVertexComponentType::FLOAT_3, 0 }
+                                     , { EVertexComponentType::UBYTE_4_NORM, 3 * sizeof( float ) } }
+                                   , SizeInBytes };
+        return vd;
+    }
+};
+
+
+/// @brief Position normalized to the bounds of its mesh or model, w is padding.
+///        The shader restores it with the PositionQuantization of the mesh.
+struct Vertex_PosQ4
+{
+    uint16_t x, y, z, w;
+
+    static constexpr int SizeInBytes = sizeof( uint16_t ) * 4;
+
+    static VertexDescription const &
+    VertexDesc()
+    {
+        static VertexDescription vd{ { { EVertexComponentType::USHORT_4_NORM, 0 } }
+                                   , SizeInBytes };
+        return vd;
+    }
+};
+
+
+/// @brief Packed replacement of Vertex_Pos3Nrm3, 12 instead of 24 bytes.
+///        Position as in Vertex_PosQ4, normal octahedron encoded.
+struct Vertex_PosQ4NrmOct
+{
+    uint16_t x, y, z, w;
+    int16_t nu, nv;
+
+    static constexpr int SizeInBytes = sizeof( uint16_t ) * 4 + sizeof( int16_t ) * 2;
+
+    static VertexDescription const &
+    VertexDesc()
+    {
+        static VertexDescription vd{ { { EVertexComponentType::USHORT_4_NORM, 0 }
+                                     , { EVertexComponentType::SHORT_2_NORM, 4 * sizeof( uint16_t ) } }
+                                   , SizeInBytes };
+        return vd;
+    }
+};
+
+
+/// @brief Normal alone, the attribute stream next to a Vertex_PosQ4 stream.
+struct Vertex_NrmOct
+{
+    int16_t nu, nv;
+
+    static constexpr int SizeInBytes = sizeof( int16_t ) * 2;
+
+    static VertexDescription const &
+    VertexDesc()
+    {
+        static VertexDescription vd{ { { EVertexComponentType::SHORT_2_NORM, 0 } }
+                                   , SizeInBytes };
+        return vd;
+    }
+};
+
 #pragma pack(pop)
 
+static_assert( sizeof( Vertex_PosQ4NrmOct ) == Vertex_PosQ4NrmOct::SizeInBytes, "Vertex_PosQ4NrmOct is not packed" );
+static_assert( sizeof( Vertex_Pos3Tex2US ) == Vertex_Pos3Tex2US::SizeInBytes, "Vertex_Pos3Tex2US is not packed" );
+
 } // - namespace renderer
 } // - namespace noo
 
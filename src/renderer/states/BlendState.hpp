@@ -22,6 +22,12 @@ enum class EBlendEnable
     DISABLE
 };
 
+enum class EColorWriteEnable
+{
+    ENABLE,
+    DISABLE
+};
+
 enum class EBlendEquation
 {
     ADD,
@@ -53,20 +59,23 @@ struct BlendState
     EBlendEquation BlendEq;
     EBlendFunc SourceBlendFunc;
     EBlendFunc DestBlendFunc;
+    EColorWriteEnable ColorWrite;
 
-    /// @brief Per default blending is DISABLED.
+    /// @brief Per default blending is DISABLED, color writing is ENABLEd.
     BlendState()
         : Enabled( EBlendEnable::DISABLE )
         , BlendEq( EBlendEquation::ADD )
         , SourceBlendFunc( EBlendFunc::ONE )
         , DestBlendFunc( EBlendFunc::ZERO )
+        , ColorWrite( EColorWriteEnable::ENABLE )
     { }
 
-    BlendState( EBlendEnable en, EBlendEquation eq, EBlendFunc src, EBlendFunc dst )
+    BlendState( EBlendEnable en, EBlendEquation eq, EBlendFunc src, EBlendFunc dst, EColorWriteEnable cw = EColorWriteEnable::ENABLE )
         : Enabled( en )
         , BlendEq( eq )
         , SourceBlendFunc( src )
         , DestBlendFunc( dst )
+        , ColorWrite( cw )
     { }
 
     /// @brief Typical alpha blending setup used for rendering order-dependent transparency.
@@ -74,6 +83,18 @@ struct BlendState
     {
         return { EBlendEnable::ENABLE, EBlendEquation::ADD, EBlendFunc::SRC_ALPHA, EBlendFunc::ONE_MINUS_SRC_ALPHA };
     }
+
+    /// @brief Accumulates the source onto the destination, e.g. for summing up light contributions.
+    static BlendState Additive()
+    {
+        return { EBlendEnable::ENABLE, EBlendEquation::ADD, EBlendFunc::ONE, EBlendFunc::ONE };
+    }
+
+    /// @brief Disables all color writes, only depth and stencil buffers are touched.
+    static BlendState NoColorWrite()
+    {
+        return { EBlendEnable::DISABLE, EBlendEquation::ADD, EBlendFunc::ONE, EBlendFunc::ZERO, EColorWriteEnable::DISABLE };
+    }
 };
 
 } // - namespace state
@@ -0,0 +1,59 @@
+
+///////////////////////////////////////////////////////////////////////////////
+/// @file: .hpp                                                             ///
+/// @brief:                                                                 ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_RENDERER_STATE_DEPTHBOUNDSSTATE_HPP_INCLUDED
+#define NOO_RENDERER_STATE_DEPTHBOUNDSSTATE_HPP_INCLUDED
+
+
+/// Includes
+
+
+namespace noo {
+namespace renderer {
+namespace state {
+
+enum class EDepthBoundsEnable
+{
+    ENABLE,
+    DISABLE
+};
+
+/// @brief Rejects fragments whose *stored* depth lies outside [Min, Max] (window space).
+///        Requires GL_EXT_depth_bounds_test, silently ignored if the driver lacks it.
+struct DepthBoundsState
+{
+    EDepthBoundsEnable Enabled;
+    float Min;
+    float Max;
+
+    /// @brief Per default the depth bounds test is DISABLEd.
+    DepthBoundsState()
+        : Enabled( EDepthBoundsEnable::DISABLE )
+        , Min( 0.0f )
+        , Max( 1.0f )
+    { }
+
+    DepthBoundsState( EDepthBoundsEnable en, float zMin, float zMax )
+        : Enabled( en )
+        , Min( zMin )
+        , Max( zMax )
+    { }
+
+    static DepthBoundsState
+    Range( float zMin, float zMax )
+    {
+        return { EDepthBoundsEnable::ENABLE, zMin, zMax };
+    }
+};
+
+} // - namespace state
+} // - namespace renderer
+} // - namespace noo
+
+
+#endif /* NOO_RENDERER_STATE_DEPTHBOUNDSSTATE_HPP_INCLUDED */
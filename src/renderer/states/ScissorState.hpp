@@ -0,0 +1,51 @@
+
+///////////////////////////////////////////////////////////////////////////////
+/// @file: .hpp                                                             ///
+/// @brief:                                                                 ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_RENDERER_STATE_SCISSORSTATE_HPP_INCLUDED
+#define NOO_RENDERER_STATE_SCISSORSTATE_HPP_INCLUDED
+
+
+/// Includes
+
+
+namespace noo {
+namespace renderer {
+namespace state {
+
+struct ScissorState
+{
+    /// @brief The lower left corner of the scissor rectangle.
+    int X;
+    int Y;
+
+    /// @brief The size of the scissor rectangle.
+    int Width;
+    int Height;
+
+    /// @brief The default scissor state disables the scissor test.
+    ScissorState()
+        : X( -1 ), Y( -1 ), Width( -1 ), Height( -1 )
+    { }
+
+    ScissorState( int x, int y, int w, int h )
+        : X( x ), Y( y ), Width( w ), Height( h )
+    { }
+
+    bool
+    isEnabled() const
+    {
+        return Width != -1;
+    }
+};
+
+} // - namespace state
+} // - namespace renderer
+} // - namespace noo
+
+
+#endif /* NOO_RENDERER_STATE_SCISSORSTATE_HPP_INCLUDED */
@@ -13,7 +13,9 @@
 #include "BlendState.hpp"
 #include "CullState.hpp"
 #include "DepthState.hpp"
+#include "DepthBoundsState.hpp"
 #include "RasterizerState.hpp"
+#include "ScissorState.hpp"
 #include "StencilState.hpp"
 #include "ViewportState.hpp"
 
@@ -27,7 +29,9 @@ struct StateSet
     BlendState blend;
     CullState cull;
     DepthState depth;
+    DepthBoundsState depthBounds;
     RasterizerState rasterizer;
+    ScissorState scissor;
     StencilState stencil;
     ViewportState viewport;
 };
@@ -1,3 +1,4 @@
+
 ///////////////////////////////////////////////////////////////////////////////
 /// @file: .hpp                                                             ///
 /// @brief:                                                                 ///
@@ -10,14 +11,120 @@
 
 
 /// Includes
+#include <cstdint>
 
 
 namespace noo {
 namespace renderer {
 namespace state {
 
+enum class EStencilEnable
+{
+    ENABLE,
+    DISABLE
+};
+
+enum class EStencilFunc
+{
+    ALWAYS,
+    NEVER,
+    LESS,
+    EQUAL,
+    LESS_EQUAL,
+    GREATER,
+    NOT_EQUAL,
+    GREATER_EQUAL
+};
+
+enum class EStencilOp
+{
+    KEEP,
+    ZERO,
+    REPLACE,
+    INCR,
+    INCR_WRAP,
+    DECR,
+    DECR_WRAP,
+    INVERT
+};
+
+/// @brief Stencil test and operations for one face orientation.
+struct StencilFaceState
+{
+    EStencilFunc CompareFunc;
+    EStencilOp StencilFailOp;
+    EStencilOp DepthFailOp;
+    EStencilOp PassOp;
+
+    /// @brief Per default the test always passes and the stencil buffer is kept.
+    StencilFaceState()
+        : CompareFunc( EStencilFunc::ALWAYS )
+        , StencilFailOp( EStencilOp::KEEP )
+        , DepthFailOp( EStencilOp::KEEP )
+        , PassOp( EStencilOp::KEEP )
+    { }
+
+    StencilFaceState( EStencilFunc func, EStencilOp sfail, EStencilOp dfail, EStencilOp pass )
+        : CompareFunc( func )
+        , StencilFailOp( sfail )
+        , DepthFailOp( dfail )
+        , PassOp( pass )
+    { }
+};
+
 struct StencilState
 {
+    EStencilEnable Enabled;
+    int Reference;
+    uint32_t ReadMask;
+    uint32_t WriteMask;
+    StencilFaceState Front;
+    StencilFaceState Back;
+
+    /// @brief Per default stencil testing is DISABLEd.
+    StencilState()
+        : Enabled( EStencilEnable::DISABLE )
+        , Reference( 0 )
+        , ReadMask( 0xFF )
+        , WriteMask( 0xFF )
+        , Front()
+        , Back()
+    { }
+
+    StencilState( EStencilEnable en, int ref, uint32_t readMask, uint32_t writeMask, StencilFaceState const & front, StencilFaceState const & back )
+        : Enabled( en )
+        , Reference( ref )
+        , ReadMask( readMask )
+        , WriteMask( writeMask )
+        , Front( front )
+        , Back( back )
+    { }
+
+    static StencilState
+    Disabled()
+    {
+        return {};
+    }
+
+    /// @brief Marks the pixels whose stored depth lies inside a closed volume (z-fail):
+    ///        back faces failing the depth test increment, front faces failing it decrement.
+    ///        Has to be drawn with face culling disabled.
+    static StencilState
+    MarkVolume()
+    {
+        return { EStencilEnable::ENABLE, 0, 0xFF, 0xFF
+               , { EStencilFunc::ALWAYS, EStencilOp::KEEP, EStencilOp::DECR_WRAP, EStencilOp::KEEP }
+               , { EStencilFunc::ALWAYS, EStencilOp::KEEP, EStencilOp::INCR_WRAP, EStencilOp::KEEP } };
+    }
+
+    /// @brief Passes only pixels previously marked by MarkVolume() and resets them to zero,
+    ///        so the next volume can be marked without clearing the stencil buffer.
+    static StencilState
+    TestVolume()
+    {
+        StencilFaceState const face{ EStencilFunc::NOT_EQUAL, EStencilOp::KEEP, EStencilOp::ZERO, EStencilOp::ZERO };
+        return { EStencilEnable::ENABLE, 0, 0xFF, 0xFF, face, face };
+    }
 };
 
 } // - namespace state
@@ -26,4 +133,3 @@ struct StencilState
 
 
 #endif /* NOO_RENDERER_STATE_STENCILSTATE_HPP_INCLUDED */
-
@@ -0,0 +1,306 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: AssetStreamer.hpp                                                ///
+/// @brief: Loads models in the background. Import and decoding run on the  ///
+///         thread pool, the finished models are handed to the render       ///
+///         thread through a lock-free queue. It maps the buffers of        ///
+///         imported models for a worker to pack into, cooked ones it       ///
+///         uploads a slice at a time within a per frame budget.            ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_SCENE_ASSETSTREAMER_HPP_INCLUDED_
+#define NOO_SCENE_ASSETSTREAMER_HPP_INCLUDED_
+
+
+/// Includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Model.hpp"
+#include "../common/BoundedQueue.hpp"
+#include "../common/ThreadPool.hpp"
+#include "../renderer/Renderer.hpp"
+
+
+namespace noo {
+namespace scene {
+
+class AssetStreamer
+{
+public:
+
+    /// @brief Limits of the uploads done by one update(). At least one slice is
+    ///        uploaded per frame, whichever limit is hit first.
+    struct Budget
+    {
+        size_t BytesPerFrame = 16 << 20;
+        double MillisecondsPerFrame = 2.0;
+    };
+
+    /// @brief Granularity of the uploads, the time budget is checked in between.
+    static constexpr size_t UploadSliceBytes = 1 << 20;
+
+    explicit AssetStreamer( common::ThreadPool & pool )
+        : m_Pool( pool )
+        , m_Loaded( 64 )
+    {}
+
+    AssetStreamer( AssetStreamer const & ) = delete;
+    AssetStreamer & operator=( AssetStreamer const & ) = delete;
+
+    /// @brief Waits for the loads in progress, models not uploaded yet yield nullptr.
+    ~AssetStreamer()
+    {
+        // nobody drains m_Loaded anymore, loads give up instead of waiting for room
+        m_Stopping.store( true, std::memory_order_release );
+
+        // the loads push into m_Loaded, they must not outlive it
+        for ( auto & l : m_Loads )
+            l.wait();
+
+        Request * request;
+
+        while ( m_Loaded.tryPop( request ) )
+        {
+            request->Promise.set_value( nullptr );
+            delete request;
+        }
+
+        // a worker may still write into the mapped buffers of a model
+        for ( auto & r : m_Uploading )
+        {
+            if ( r->Packing.valid() )
+                r->Packing.wait();
+
+            r->Promise.set_value( nullptr );
+        }
+    }
+
+    /// @brief Starts loading filename, preferring its cooked version at filename
+    ///        plus ".noom". The model is owned by the streamer and drawable once
+    ///        the future is ready, it yields nullptr if loading failed.
+    ///        residency tells what the model keeps in memory once uploaded.
+    std::shared_future< Model * >
+    load( std::string const & filename, EResidency residency = EResidency::KEEP_ALL )
+    {
+        auto request = std::make_unique< Request >();
+        request->Filename = filename;
+        request->Residency = residency;
+
+        std::shared_future< Model * > result = request->Promise.get_future().share();
+
+        Request * r = request.release();
+
+        m_Loads.push_back( m_Pool.submit( [ this, r ]
+        {
+            std::unique_ptr< Request > request( r );
+
+            if ( ! loadRequest( *request ) )
+            {
+                request->Promise.set_value( nullptr );
+                return;
+            }
+
+            // the render thread drains the queue every frame, it is full only briefly
+            while ( ! m_Loaded.tryPush( request.get() ) )
+            {
+                if ( m_Stopping.load( std::memory_order_acquire ) )
+                {
+                    request->Promise.set_value( nullptr );
+                    return;
+                }
+
+                std::this_thread::yield();
+            }
+
+            request.release();
+        } ) );
+
+        return result;
+    }
+
+    /// @brief Uploads loaded models within the budget, call once per frame on
+    ///        the render thread.
+    void
+    update( renderer::Renderer & renderer )
+    {
+        using Clock = std::chrono::steady_clock;
+
+        auto const start = Clock::now();
+
+        Request * loaded;
+
+        while ( m_Loaded.tryPop( loaded ) )
+        {
+            m_Uploading.emplace_back( loaded );
+
+            // imported models are packed by a worker straight into mapped buffers
+            if ( loaded->Asset->mapGeometry( renderer ) )
+            {
+                Model * model = loaded->Asset.get();
+                loaded->Packing = m_Pool.submit( [ model ] { model->packGeometry(); } );
+            }
+        }
+
+        size_t bytes = 0;
+
+        while ( ! m_Uploading.empty() )
+        {
+            Request & request = *m_Uploading.front();
+
+            // models become drawable in load order
+            if ( request.Packing.valid() )
+            {
+                if ( request.Packing.wait_for( std::chrono::seconds( 0 ) ) != std::future_status::ready )
+                    break;
+
+                if ( ! finishPacking( request ) )
+                {
+                    m_Uploading.pop_front();
+                    continue;
+                }
+            }
+
+            bytes += request.Asset->uploadGeometry( renderer, UploadSliceBytes );
+
+            if ( request.Asset->isResident() )
+            {
+                m_Models.push_back( std::move( request.Asset ) );
+                request.Promise.set_value( m_Models.back().get() );
+                m_Uploading.pop_front();
+            }
+
+            double const ms = std::chrono::duration< double, std::milli >( Clock::now() - start ).count();
+
+            if ( bytes >= m_Budget.BytesPerFrame || ms >= m_Budget.MillisecondsPerFrame )
+                break;
+        }
+
+        m_Loads.erase( std::remove_if( m_Loads.begin(), m_Loads.end(), []( std::future< void > const & l )
+        {
+            return l.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready;
+        } ), m_Loads.end() );
+
+        renderer.setCounter( "streamed bytes", static_cast< int64_t >( bytes ) );
+        renderer.setCounter( "streaming pending", static_cast< int64_t >( getNumPending() ) );
+    }
+
+    void
+    setBudget( Budget const & budget )
+    { m_Budget = budget; }
+
+    Budget const &
+    getBudget() const
+    { return m_Budget; }
+
+    /// @brief Models being loaded or uploaded.
+    size_t
+    getNumPending() const
+    { return m_Loads.size() + m_Uploading.size(); }
+
+private:
+
+    struct Request
+    {
+        std::string Filename;
+        EResidency Residency;
+        std::unique_ptr< Model > Asset;
+        std::promise< Model * > Promise;
+
+        /// @brief Valid while a worker packs into the buffers mapped by the render thread.
+        std::future< void > Packing;
+    };
+
+    /// @brief Worker side of load(), everything but handing the model over.
+    /// @return false if the model could not be loaded, e.g. the importer threw.
+    bool
+    loadRequest( Request & request )
+    {
+        if ( m_Stopping.load( std::memory_order_acquire ) )
+            return false;
+
+        try
+        {
+            request.Asset = std::make_unique< Model >();
+
+            std::string const cooked = request.Filename + ".noom";
+
+            if ( Model::isCookedOutdated( request.Filename, cooked ) )
+                NOO_LOG_WARN( "{} is older than {}, rerun noo_cook.", cooked, request.Filename );
+
+            bool loaded = Model::createFromCooked( cooked, *request.Asset, &m_Pool );
+
+            if ( ! loaded )
+                loaded = Model::createFromFile( request.Filename, *request.Asset, &m_Pool );
+
+            if ( ! loaded )
+                return false;
+
+            request.Asset->setResidency( request.Residency );
+        }
+        catch ( std::exception const & e )
+        {
+            NOO_LOG_ERROR( "Loading {} failed: {}", request.Filename, e.what() );
+            return false;
+        }
+        catch ( ... )
+        {
+            NOO_LOG_ERROR( "Loading {} failed.", request.Filename );
+            return false;
+        }
+
+        return true;
+    }
+
+    /// @brief Takes the result of the finished packing job of request.
+    /// @return false if packing threw, the load yields nullptr then. The mapped
+    ///         buffers go with the model, deleting them unmaps them.
+    bool
+    finishPacking( Request & request )
+    {
+        try
+        {
+            request.Packing.get();
+            return true;
+        }
+        catch ( std::exception const & e )
+        {
+            NOO_LOG_ERROR( "Packing {} failed: {}", request.Filename, e.what() );
+        }
+        catch ( ... )
+        {
+            NOO_LOG_ERROR( "Packing {} failed.", request.Filename );
+        }
+
+        request.Promise.set_value( nullptr );
+
+        return false;
+    }
+
+    common::ThreadPool & m_Pool;
+    Budget m_Budget;
+
+    std::atomic< bool > m_Stopping{ false };
+
+    /// @brief Loaded and packed on a worker, waiting for the render thread.
+    common::BoundedQueue< Request * > m_Loaded;
+
+    std::vector< std::future< void > > m_Loads;
+    std::deque< std::unique_ptr< Request > > m_Uploading;
+    std::vector< std::unique_ptr< Model > > m_Models;
+};
+
+} // - namespace scene
+} // - namespace noo
+
+
+#endif /* NOO_SCENE_ASSETSTREAMER_HPP_INCLUDED_ */
@@ -26,6 +26,8 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/constants.hpp"
 
+#include "../geometry/Frustum.hpp"
+
 /// Using declarations
 
 
@@ -33,6 +35,31 @@
 namespace noo {
 namespace scene {
 
+/// @brief Everything derived from a camera at one point in time. Copies are
+///        handed to threads, which then never touch the live camera.
+struct CameraSnapshot
+{
+    glm::vec3 Position;
+    glm::vec3 Direction;
+    glm::vec3 Up;
+
+    float Fovy;
+    float AspectRatio;
+    float NearDistance;
+    float FarDistance;
+
+    glm::mat4 View;
+    glm::mat4 Projection;
+    glm::mat4 ViewProjection;
+
+    glm::mat4 InverseView;
+    glm::mat4 InverseProjection;
+    glm::mat4 InverseViewProjection;
+
+    /// @brief The world space view frustum.
+    geometry::Frustum Frustum;
+};
+
 class Camera
 {
 public:
@@ -60,19 +87,48 @@ public:
     { }
 
 
-    glm::mat4
+    /// @brief The matrices and the frustum are cached until the camera changes.
+    ///        The getters update the cache, the live camera is for one thread,
+    ///        others read a getSnapshot().
+    glm::mat4 const &
     getViewMatrix() const
-        { return glm::lookAtRH( m_Position, m_Position + m_Direction, m_Up ); }
+        { return getCache().View; }
 
 
-    glm::mat4
+    glm::mat4 const &
     getProjectionMatrix() const
-        { return glm::perspectiveRH( m_FOVY, m_AspectRatio, m_NearDistance, m_FarDistance ); }
+        { return getCache().Projection; }
 
 
-    glm::mat4
+    glm::mat4 const &
     getViewProjectionMatrix() const
-        { return getProjectionMatrix() * getViewMatrix(); }
+        { return getCache().ViewProjection; }
+
+
+    glm::mat4 const &
+    getInverseViewMatrix() const
+        { return getCache().InverseView; }
+
+
+    glm::mat4 const &
+    getInverseProjectionMatrix() const
+        { return getCache().InverseProjection; }
+
+
+    glm::mat4 const &
+    getInverseViewProjectionMatrix() const
+        { return getCache().InverseViewProjection; }
+
+
+    /// @brief The world space view frustum.
+    geometry::Frustum const &
+    getFrustum() const
+        { return getCache().Frustum; }
+
+
+    CameraSnapshot
+    getSnapshot() const
+        { return getCache(); }
 
 
     glm::vec3
@@ -81,11 +137,11 @@ public:
 
     void
     setPosition( glm::vec3 const & pos )
-        { m_Position = pos; }
+        { m_Position = pos; m_Dirty = true; }
 
     void
     setPosition( float x, float y, float z )
-        { m_Position = glm::vec3( x, y, z ); }
+        { m_Position = glm::vec3( x, y, z ); m_Dirty = true; }
 
 
     glm::vec3
@@ -94,7 +150,7 @@ public:
 
     void
     setDirection( glm::vec3 const & dir )
-        { m_Direction = dir; }
+        { m_Direction = dir; m_Dirty = true; }
 
 
     glm::vec3
@@ -107,7 +163,7 @@ public:
 
     void
     setUp( glm::vec3 const & up )
-        { m_Up = up; }
+        { m_Up = up; m_Dirty = true; }
 
 
     float
@@ -116,7 +172,7 @@ public:
 
     void
     setFovy( float fovy )
-        { m_FOVY = fovy; }
+        { m_FOVY = fovy; m_Dirty = true; }
 
 
     float
@@ -125,7 +181,7 @@ public:
 
     void
     setAspectRatio( float aspect )
-        { m_AspectRatio = aspect; }
+        { m_AspectRatio = aspect; m_Dirty = true; }
 
 
     float
@@ -134,7 +190,7 @@ public:
 
     void
     setNearDistance( float near )
-        { m_NearDistance = near; }
+        { m_NearDistance = near; m_Dirty = true; }
 
 
     float
@@ -143,7 +199,7 @@ public:
 
     void
     setFarDistance( float far )
-        { m_FarDistance = far; }
+        { m_FarDistance = far; m_Dirty = true; }
 
 
     void
@@ -154,6 +210,7 @@ public:
         m_Up = glm::cross( right, m_Direction );
 
         m_EyeDistance = glm::distance( focusPoint, m_Position );
+        m_Dirty = true;
     }
 
     void
@@ -166,6 +223,37 @@ public:
 
 private:
 
+    CameraSnapshot const &
+    getCache() const
+    {
+        if ( m_Dirty )
+        {
+            CameraSnapshot & c = m_Cache;
+
+            c.Position = m_Position;
+            c.Direction = m_Direction;
+            c.Up = m_Up;
+            c.Fovy = m_FOVY;
+            c.AspectRatio = m_AspectRatio;
+            c.NearDistance = m_NearDistance;
+            c.FarDistance = m_FarDistance;
+
+            c.View = glm::lookAtRH( m_Position, m_Position + m_Direction, m_Up );
+            c.Projection = glm::perspectiveRH( m_FOVY, m_AspectRatio, m_NearDistance, m_FarDistance );
+            c.ViewProjection = c.Projection * c.View;
+
+            c.InverseView = glm::inverse( c.View );
+            c.InverseProjection = glm::inverse( c.Projection );
+            c.InverseViewProjection = c.InverseView * c.InverseProjection;
+
+            c.Frustum = geometry::Frustum::fromMatrix( c.ViewProjection );
+
+            m_Dirty = false;
+        }
+
+        return m_Cache;
+    }
+
     glm::vec3 m_Position;
     glm::vec3 m_Direction;
     glm::vec3 m_Up;
@@ -176,6 +264,9 @@ private:
     float m_AspectRatio;
     float m_NearDistance;
     float m_FarDistance;
+
+    mutable CameraSnapshot m_Cache;
+    mutable bool m_Dirty = true;
 };
 
 } // - namespace scene
@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: CookedModel.hpp                                                  ///
+/// @brief: Layout of cooked model files, written by noo_cook and mapped    ///
+///         by Model::createFromCooked(). The vertex and index blobs are    ///
+///         in the formats Model uploads, so loading converts nothing.      ///
+///                                                                         ///
+///         Header | materials | meshes | positions | normals | indices     ///
+///                                                                         ///
+///         With FlagCompressed the last three are geometry::MeshCodec      ///
+///         streams, decoded once at load.                                  ///
+///                                                                         ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_SCENE_COOKEDMODEL_HPP_INCLUDED_
+#define NOO_SCENE_COOKEDMODEL_HPP_INCLUDED_
+
+
+/// Includes
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+
+namespace noo {
+namespace scene {
+namespace cooked {
+
+static constexpr uint32_t Magic = 0x4d4f4f4e; // "NOOM"
+static constexpr uint32_t Version = 2;
+
+/// @brief Header::Flags
+static constexpr uint32_t FlagCompressed = 1;
+
+/// @brief Alignment of the blobs in the file.
+static constexpr size_t BlobAlignment = 16;
+
+/// @brief Levels of detail per mesh, including the full detail.
+static constexpr size_t MaxLevels = 8;
+
+struct Blob
+{
+    uint64_t Offset;
+    uint64_t Size;
+};
+
+struct Header
+{
+    uint32_t Magic;
+    uint32_t Version;
+
+    uint32_t NumMaterials;
+    uint32_t NumMeshes;
+
+    /// @brief Of all meshes, the decoded sizes of the vertex and index blobs.
+    uint32_t NumVertices;
+    uint32_t NumIndices;
+
+    uint32_t Flags;
+    uint32_t Reserved;
+
+    float BoundsMin[ 3 ];
+    float BoundsMax[ 3 ];
+
+    /// @brief MaterialRecord[ NumMaterials ], MeshRecord[ NumMeshes ].
+    Blob Materials;
+    Blob Meshes;
+
+    /// @brief renderer::Vertex_PosQ4 and renderer::Vertex_NrmOct of all meshes.
+    Blob Positions;
+    Blob Normals;
+
+    /// @brief uint32_t, all levels of all meshes, relative to the mesh BaseVertex.
+    Blob Indices;
+};
+
+struct MaterialRecord
+{
+    float Color[ 3 ];
+};
+
+struct LevelRecord
+{
+    /// @brief In indices from the start of the index blob.
+    uint32_t IndexOffset;
+    uint32_t NumIndices;
+
+    /// @brief Deviation from the full detail, 0 for level 0.
+    float Error;
+};
+
+struct MeshRecord
+{
+    uint32_t Material;
+
+    /// @brief In vertices from the start of the vertex blobs.
+    uint32_t BaseVertex;
+    uint32_t NumVertices;
+
+    uint32_t NumLevels;
+    LevelRecord Levels[ MaxLevels ];
+
+    float BoundsMin[ 3 ];
+    float BoundsMax[ 3 ];
+
+    float SphereCenter[ 3 ];
+    float SphereRadius;
+
+    /// @brief renderer::PositionQuantization of the mesh, Model writes the
+    ///        same grid for all of its meshes.
+    float PositionScale[ 3 ];
+    float PositionOffset[ 3 ];
+};
+
+static_assert( std::is_trivially_copyable< Header >::value && std::is_trivially_copyable< MeshRecord >::value
+             , "Cooked records are read straight from the mapped file" );
+
+inline size_t
+alignBlob( size_t offset )
+{ return ( offset + BlobAlignment - 1 ) & ~( BlobAlignment - 1 ); }
+
+/// @brief True if the blob lies within a file of fileSize bytes.
+inline bool
+isInside( Blob const & b, size_t fileSize )
+{ return b.Offset <= fileSize && b.Size <= fileSize - b.Offset; }
+
+} // - namespace cooked
+} // - namespace scene
+} // - namespace noo
+
+
+#endif /* NOO_SCENE_COOKEDMODEL_HPP_INCLUDED_ */
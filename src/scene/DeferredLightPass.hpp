@@ -0,0 +1,249 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: DeferredLightPass.hpp                                            ///
+/// @brief: Accumulates point lights from the g-buffer by rasterizing one   ///
+///         sphere volume per light. A two-sided stencil pass marks the     ///
+///         pixels whose surface lies inside the volume, only those are     ///
+///         shaded. Scissor and depth bounds reject the rest early.        ///
+///                                                                         ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_SCENE_DEFERREDLIGHTPASS_HPP_INCLUDED_
+#define NOO_SCENE_DEFERREDLIGHTPASS_HPP_INCLUDED_
+
+
+/// Includes
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "Camera.hpp"
+#include "PointLight.hpp"
+#include "../renderer/Renderer.hpp"
+#include "../renderer/VertexTypes.hpp"
+#include "../geometry/GeometryUtils.hpp"
+#include "../common/Utils.hpp"
+
+
+namespace noo {
+namespace scene {
+
+class DeferredLightPass
+{
+public:
+
+    void
+    initialize( renderer::Renderer & renderer )
+    {
+        std::vector< glm::vec3 > positions;
+        std::vector< uint32_t > indices;
+        geometry::GeometryUtils::createSphere( NumStacks, NumSlices, positions, indices );
+
+        m_SphereVertices = renderer.createVertexBuffer();
+        m_SphereVertices->upload( positions.size() * renderer::Vertex_Pos3::SizeInBytes, positions.data() );
+
+        m_SphereIndices = renderer.createIndexBuffer();
+        m_SphereIndices->upload( indices.size() * sizeof( uint32_t ), indices.data() );
+
+        m_Sphere.Vertices = m_SphereVertices.get();
+        m_Sphere.Indices = m_SphereIndices.get();
+        m_Sphere.NumPrimitives = indices.size() / 3;
+        m_Sphere.VertexFormat = renderer::Vertex_Pos3::VertexDesc();
+
+        std::string const stencilVS = common::readFile( "resources/shaders/depth_only.vsh" );
+        std::string const stencilFS = common::readFile( "resources/shaders/depth_only.fsh" );
+        m_StencilShader = renderer.createShader( stencilVS.c_str(), nullptr, nullptr, nullptr, stencilFS.c_str() );
+        m_StencilData.reset( new renderer::Shader::Data( *m_StencilShader ) );
+
+        // the depth shader restores quantized positions, the sphere is float already
+        ( *m_StencilData )[ "u_pos_scale" ] = glm::vec3( 1.0f );
+        ( *m_StencilData )[ "u_pos_offset" ] = glm::vec3( 0.0f );
+
+        std::string const lightVS = common::readFile( "resources/shaders/deferred_light_volume.vsh" );
+        std::string const lightFS = common::readFile( "resources/shaders/deferred_light_volume.fsh" );
+        m_LightShader = renderer.createShader( lightVS.c_str(), nullptr, nullptr, nullptr, lightFS.c_str() );
+        m_LightData.reset( new renderer::Shader::Data( *m_LightShader ) );
+    }
+
+    /// @brief Adds the contribution of all lights to the color buffer of rt.
+    ///        rt has to share the depth-stencil attachment of the g-buffer and
+    ///        the stencil buffer has to be cleared to zero (it is left that way).
+    /// @return The number of lights which survived the screen space rejection.
+    int
+    draw( renderer::Renderer & renderer
+        , renderer::RenderTarget const & rt
+        , CameraSnapshot const & cam
+        , std::vector< PointLight > const & lights
+        , renderer::Texture2D * gDiffuse
+        , renderer::Texture2D * gPosition
+        , renderer::Texture2D * gNormal )
+    {
+        using namespace renderer;
+        using namespace renderer::state;
+
+        TextureSampler const diffuse { gDiffuse , EWrapMode::CLAMP, EWrapMode::CLAMP, EMinFilterMode::NEAREST, EMagFilterMode::NEAREST };
+        TextureSampler const position{ gPosition, EWrapMode::CLAMP, EWrapMode::CLAMP, EMinFilterMode::NEAREST, EMagFilterMode::NEAREST };
+        TextureSampler const normal  { gNormal  , EWrapMode::CLAMP, EWrapMode::CLAMP, EMinFilterMode::NEAREST, EMagFilterMode::NEAREST };
+
+        Shader::Data & shdStencil = *m_StencilData;
+        Shader::Data & shdLight = *m_LightData;
+
+        shdLight[ "s2D_diffuse" ] = diffuse;
+        shdLight[ "s2D_position" ] = position;
+        shdLight[ "s2D_normal" ] = normal;
+        shdLight[ "u_screen_size" ] = glm::vec2( rt.getWidth(), rt.getHeight() );
+        shdLight[ "u_view_pos" ] = cam.Position;
+
+        // depth test against the g-buffer, only the stencil is written
+        StateSet stencilPass;
+        stencilPass.blend = BlendState::NoColorWrite();
+        stencilPass.cull = CullState::Disabled();
+        stencilPass.depth = DepthState::ReadOnly();
+        stencilPass.stencil = StencilState::MarkVolume();
+
+        // back faces cover the whole volume even if the camera is inside of it
+        StateSet lightPass;
+        lightPass.blend = BlendState::Additive();
+        lightPass.cull = CullState( ECullMode::FRONT, EFrontFaceWinding::CW );
+        lightPass.depth = DepthState::Disabled();
+        lightPass.stencil = StencilState::TestVolume();
+
+        glm::mat4 const & viewProj = cam.ViewProjection;
+
+        int numDrawn = 0;
+
+        for ( auto const & l : lights )
+        {
+            ScissorState scissor;
+            DepthBoundsState depthBounds;
+
+            if ( ! computeScreenBounds( cam, l, rt.getWidth(), rt.getHeight(), scissor, depthBounds ) )
+                continue;
+
+            stencilPass.scissor = lightPass.scissor = scissor;
+            stencilPass.depthBounds = lightPass.depthBounds = depthBounds;
+
+            glm::mat4 const model = glm::scale( glm::translate( glm::mat4( 1 ), l.Position ), glm::vec3( l.Radius * circumscribeScale() ) );
+
+            shdStencil[ "u_mvp" ] = viewProj * model;
+            renderer.draw( rt, shdStencil, stencilPass, m_Sphere );
+
+            shdLight[ "u_mvp" ] = viewProj * model;
+            shdLight[ "u_light_pos" ] = l.Position;
+            shdLight[ "u_light_color" ] = l.Color;
+            shdLight[ "u_light_radius" ] = l.Radius;
+            renderer.draw( rt, shdLight, lightPass, m_Sphere );
+
+            ++numDrawn;
+        }
+
+        return numDrawn;
+    }
+
+private:
+
+    static constexpr size_t NumStacks = 12;
+    static constexpr size_t NumSlices = 16;
+
+    /// @brief The tessellated sphere lies inside the unit sphere, scale it up so
+    ///        that its faces enclose the whole light radius.
+    static float
+    circumscribeScale()
+    {
+        float const pi = glm::pi< float >();
+        return 1.0f / ( std::cos( pi / NumSlices ) * std::cos( pi / ( 2 * NumStacks ) ) );
+    }
+
+    /// @brief Computes the window space rectangle and depth range covered by the light.
+    /// @return false if the light volume can not touch any pixel of the view.
+    static bool
+    computeScreenBounds( CameraSnapshot const & cam, PointLight const & l, int width, int height
+                       , renderer::state::ScissorState & scissor
+                       , renderer::state::DepthBoundsState & depthBounds )
+    {
+        float const camNear = cam.NearDistance;
+        float const camFar = cam.FarDistance;
+
+        // distance range along the view direction
+        float const center = glm::dot( l.Position - cam.Position, glm::normalize( cam.Direction ) );
+        float const zMin = center - l.Radius;
+        float const zMax = center + l.Radius;
+
+        if ( zMax < camNear || zMin > camFar )
+            return false;
+
+        glm::mat4 const & proj = cam.Projection;
+
+        auto toWindowDepth = [ &proj ]( float dist )
+        {
+            glm::vec4 const clip = proj * glm::vec4( 0.0f, 0.0f, -dist, 1.0f );
+            return glm::clamp( clip.z / clip.w * 0.5f + 0.5f, 0.0f, 1.0f );
+        };
+
+        depthBounds = renderer::state::DepthBoundsState::Range( toWindowDepth( std::max( zMin, camNear ) )
+                                                              , toWindowDepth( std::min( zMax, camFar ) ) );
+
+        // the volume intersects the near plane, its projection is unbounded
+        scissor = renderer::state::ScissorState();
+
+        if ( zMin <= camNear )
+            return true;
+
+        glm::mat4 const & viewProj = cam.ViewProjection;
+        glm::vec2 lo( 1.0f );
+        glm::vec2 hi( -1.0f );
+
+        for ( int c = 0; c < 8; ++c )
+        {
+            glm::vec3 const corner = l.Position + glm::vec3( ( c & 1 ) ? l.Radius : -l.Radius
+                                                           , ( c & 2 ) ? l.Radius : -l.Radius
+                                                           , ( c & 4 ) ? l.Radius : -l.Radius );
+
+            glm::vec4 const clip = viewProj * glm::vec4( corner, 1.0f );
+
+            if ( clip.w <= 0.0f )
+                return true;
+
+            glm::vec2 const ndc( clip.x / clip.w, clip.y / clip.w );
+            lo = glm::min( lo, ndc );
+            hi = glm::max( hi, ndc );
+        }
+
+        lo = glm::clamp( lo, -1.0f, 1.0f );
+        hi = glm::clamp( hi, -1.0f, 1.0f );
+
+        if ( lo.x >= hi.x || lo.y >= hi.y )
+            return false;
+
+        int const x0 = static_cast< int >( std::floor( ( lo.x * 0.5f + 0.5f ) * width ) );
+        int const y0 = static_cast< int >( std::floor( ( lo.y * 0.5f + 0.5f ) * height ) );
+        int const x1 = static_cast< int >( std::ceil ( ( hi.x * 0.5f + 0.5f ) * width ) );
+        int const y1 = static_cast< int >( std::ceil ( ( hi.y * 0.5f + 0.5f ) * height ) );
+
+        scissor = renderer::state::ScissorState( x0, y0, x1 - x0, y1 - y0 );
+
+        return true;
+    }
+
+    std::unique_ptr< renderer::VertexBuffer > m_SphereVertices;
+    std::unique_ptr< renderer::IndexBuffer > m_SphereIndices;
+    renderer::Geometry m_Sphere;
+
+    std::shared_ptr< renderer::Shader > m_StencilShader;
+    std::shared_ptr< renderer::Shader > m_LightShader;
+
+    std::unique_ptr< renderer::Shader::Data > m_StencilData;
+    std::unique_ptr< renderer::Shader::Data > m_LightData;
+};
+
+} // - namespace scene
+} // - namespace noo
+
+
+#endif /* NOO_SCENE_DEFERREDLIGHTPASS_HPP_INCLUDED_ */
@@ -0,0 +1,270 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: FrustumCuller.hpp                                                ///
+/// @brief: Tests many bounding boxes against a view frustum. The boxes are ///
+///         stored as structure of arrays (center and half extents) so the  ///
+///         plane tests run on 8 (AVX) or 4 (SSE) boxes at once.            ///
+///                                                                         ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_SCENE_FRUSTUMCULLER_HPP_INCLUDED_
+#define NOO_SCENE_FRUSTUMCULLER_HPP_INCLUDED_
+
+
+/// Includes
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#if defined( __AVX__ ) || defined( __SSE2__ )
+#include <immintrin.h>
+#endif
+
+#include "../geometry/Bounds.hpp"
+#include "../geometry/Frustum.hpp"
+#include "../common/ThreadPool.hpp"
+
+
+namespace noo {
+namespace scene {
+
+class FrustumCuller
+{
+public:
+
+#if defined( __AVX__ )
+    static constexpr size_t Lanes = 8;
+#elif defined( __SSE2__ )
+    static constexpr size_t Lanes = 4;
+#else
+    static constexpr size_t Lanes = 1;
+#endif
+
+    /// @brief Number of boxes a single worker task processes.
+    static constexpr size_t GrainSize = 2048;
+
+    void
+    clear()
+    {
+        m_Size = 0;
+        resize( 0 );
+    }
+
+    void
+    reserve( size_t n )
+    {
+        size_t const padded = pad( n );
+
+        for ( auto * v : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_ExtentX, &m_ExtentY, &m_ExtentZ } )
+            v->reserve( padded );
+
+        m_Visible.reserve( padded );
+    }
+
+    /// @return The index of the box, used with set() and isVisible().
+    size_t
+    add( geometry::AABB const & box )
+    {
+        size_t const index = m_Size++;
+        resize( m_Size );
+        set( index, box );
+
+        return index;
+    }
+
+    void
+    set( size_t index, geometry::AABB const & box )
+    {
+        glm::vec3 const c = box.getCenter();
+        glm::vec3 const e = box.getExtents();
+
+        m_CenterX[ index ] = c.x; m_CenterY[ index ] = c.y; m_CenterZ[ index ] = c.z;
+        m_ExtentX[ index ] = e.x; m_ExtentY[ index ] = e.y; m_ExtentZ[ index ] = e.z;
+    }
+
+    size_t
+    size() const
+    { return m_Size; }
+
+    /// @brief Valid after cull(), all boxes are visible before the first call.
+    bool
+    isVisible( size_t index ) const
+    { return m_Visible[ index ] != 0; }
+
+    /// @brief Hides a box which passed cull() for another reason, e.g. occlusion.
+    void
+    setVisible( size_t index, bool visible )
+    { m_Visible[ index ] = visible ? 1 : 0; }
+
+    std::vector< uint8_t > const &
+    getVisibility() const
+    { return m_Visible; }
+
+    /// @brief Updates the visibility of all boxes. Large sets are split across the
+    ///        workers of pool, if one is given.
+    /// @return The number of visible boxes.
+    size_t
+    cull( geometry::Frustum const & frustum, common::ThreadPool * pool = nullptr )
+    {
+        if ( pool == nullptr || m_Size <= GrainSize )
+            return cullRange( frustum, 0, m_Size );
+
+        std::atomic< size_t > numVisible{ 0 };
+
+        pool->parallelFor( m_Size, GrainSize, [ this, &frustum, &numVisible ]( size_t begin, size_t end )
+        {
+            numVisible += cullRange( frustum, begin, end );
+        } );
+
+        return numVisible;
+    }
+
+private:
+
+    static size_t
+    pad( size_t n )
+    { return ( n + Lanes - 1 ) / Lanes * Lanes; }
+
+    void
+    resize( size_t n )
+    {
+        // padding lanes hold empty boxes at the origin, their results are ignored
+        size_t const padded = pad( n );
+
+        for ( auto * v : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_ExtentX, &m_ExtentY, &m_ExtentZ } )
+            v->resize( padded, 0.0f );
+
+        m_Visible.resize( padded, 1 );
+    }
+
+    /// @brief begin has to be a multiple of Lanes (GrainSize is).
+    size_t
+    cullRange( geometry::Frustum const & frustum, size_t begin, size_t end )
+    {
+        size_t numVisible = 0;
+        size_t i = begin;
+
+#if defined( __AVX__ )
+        __m256 const signMask = _mm256_set1_ps( -0.0f );
+
+        for ( ; i < end; i += Lanes )
+        {
+            __m256 const cx = _mm256_loadu_ps( &m_CenterX[ i ] );
+            __m256 const cy = _mm256_loadu_ps( &m_CenterY[ i ] );
+            __m256 const cz = _mm256_loadu_ps( &m_CenterZ[ i ] );
+            __m256 const ex = _mm256_loadu_ps( &m_ExtentX[ i ] );
+            __m256 const ey = _mm256_loadu_ps( &m_ExtentY[ i ] );
+            __m256 const ez = _mm256_loadu_ps( &m_ExtentZ[ i ] );
+
+            __m256 outside = _mm256_setzero_ps();
+
+            for ( auto const & p : frustum.Planes )
+            {
+                __m256 const px = _mm256_set1_ps( p.x );
+                __m256 const py = _mm256_set1_ps( p.y );
+                __m256 const pz = _mm256_set1_ps( p.z );
+
+                // signed distance of the center and projected radius of the box
+                __m256 d = _mm256_add_ps( _mm256_mul_ps( px, cx ), _mm256_set1_ps( p.w ) );
+                d = _mm256_add_ps( d, _mm256_mul_ps( py, cy ) );
+                d = _mm256_add_ps( d, _mm256_mul_ps( pz, cz ) );
+
+                __m256 r = _mm256_mul_ps( _mm256_andnot_ps( signMask, px ), ex );
+                r = _mm256_add_ps( r, _mm256_mul_ps( _mm256_andnot_ps( signMask, py ), ey ) );
+                r = _mm256_add_ps( r, _mm256_mul_ps( _mm256_andnot_ps( signMask, pz ), ez ) );
+
+                // outside if d < -r  <=>  d + r < 0
+                outside = _mm256_or_ps( outside, _mm256_cmp_ps( _mm256_add_ps( d, r ), _mm256_setzero_ps(), _CMP_LT_OQ ) );
+            }
+
+            int const mask = _mm256_movemask_ps( outside );
+
+            for ( size_t l = 0; l < Lanes; ++l )
+                m_Visible[ i + l ] = ( mask >> l ) & 1 ? 0 : 1;
+
+            numVisible += countVisible( mask, i, end );
+        }
+#elif defined( __SSE2__ )
+        __m128 const signMask = _mm_set1_ps( -0.0f );
+
+        for ( ; i < end; i += Lanes )
+        {
+            __m128 const cx = _mm_loadu_ps( &m_CenterX[ i ] );
+            __m128 const cy = _mm_loadu_ps( &m_CenterY[ i ] );
+            __m128 const cz = _mm_loadu_ps( &m_CenterZ[ i ] );
+            __m128 const ex = _mm_loadu_ps( &m_ExtentX[ i ] );
+            __m128 const ey = _mm_loadu_ps( &m_ExtentY[ i ] );
+            __m128 const ez = _mm_loadu_ps( &m_ExtentZ[ i ] );
+
+            __m128 outside = _mm_setzero_ps();
+
+            for ( auto const & p : frustum.Planes )
+            {
+                __m128 const px = _mm_set1_ps( p.x );
+                __m128 const py = _mm_set1_ps( p.y );
+                __m128 const pz = _mm_set1_ps( p.z );
+
+                // signed distance of the center and projected radius of the box
+                __m128 d = _mm_add_ps( _mm_mul_ps( px, cx ), _mm_set1_ps( p.w ) );
+                d = _mm_add_ps( d, _mm_mul_ps( py, cy ) );
+                d = _mm_add_ps( d, _mm_mul_ps( pz, cz ) );
+
+                __m128 r = _mm_mul_ps( _mm_andnot_ps( signMask, px ), ex );
+                r = _mm_add_ps( r, _mm_mul_ps( _mm_andnot_ps( signMask, py ), ey ) );
+                r = _mm_add_ps( r, _mm_mul_ps( _mm_andnot_ps( signMask, pz ), ez ) );
+
+                // outside if d < -r  <=>  d + r < 0
+                outside = _mm_or_ps( outside, _mm_cmplt_ps( _mm_add_ps( d, r ), _mm_setzero_ps() ) );
+            }
+
+            int const mask = _mm_movemask_ps( outside );
+
+            for ( size_t l = 0; l < Lanes; ++l )
+                m_Visible[ i + l ] = ( mask >> l ) & 1 ? 0 : 1;
+
+            numVisible += countVisible( mask, i, end );
+        }
+#else
+        for ( ; i < end; ++i )
+        {
+            geometry::AABB const box( { m_CenterX[ i ] - m_ExtentX[ i ], m_CenterY[ i ] - m_ExtentY[ i ], m_CenterZ[ i ] - m_ExtentZ[ i ] }
+                                    , { m_CenterX[ i ] + m_ExtentX[ i ], m_CenterY[ i ] + m_ExtentY[ i ], m_CenterZ[ i ] + m_ExtentZ[ i ] } );
+
+            m_Visible[ i ] = frustum.intersects( box ) ? 1 : 0;
+            numVisible += m_Visible[ i ];
+        }
+#endif
+
+        return numVisible;
+    }
+
+    /// @brief Counts the zero bits of an outside mask, ignoring padding lanes past end.
+    static size_t
+    countVisible( int outsideMask, size_t first, size_t end )
+    {
+        size_t n = 0;
+
+        for ( size_t l = 0; l < Lanes && first + l < end; ++l )
+            n += ( outsideMask >> l ) & 1 ? 0 : 1;
+
+        return n;
+    }
+
+    size_t m_Size = 0;
+
+    std::vector< float > m_CenterX;
+    std::vector< float > m_CenterY;
+    std::vector< float > m_CenterZ;
+    std::vector< float > m_ExtentX;
+    std::vector< float > m_ExtentY;
+    std::vector< float > m_ExtentZ;
+
+    std::vector< uint8_t > m_Visible;
+};
+
+} // - namespace scene
+} // - namespace noo
+
+
+#endif /* NOO_SCENE_FRUSTUMCULLER_HPP_INCLUDED_ */
@@ -0,0 +1,49 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: LodView.hpp                                                      ///
+/// @brief: What the level of detail selection needs to know about a view.  ///
+///                                                                         ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_SCENE_LODVIEW_HPP_INCLUDED_
+#define NOO_SCENE_LODVIEW_HPP_INCLUDED_
+
+
+/// Includes
+#include "glm/glm.hpp"
+
+#include "Camera.hpp"
+
+
+namespace noo {
+namespace scene {
+
+struct LodView
+{
+    glm::vec3 Position = glm::vec3( 0 );
+
+    /// @brief Pixels covered by one unit at a distance of one unit. Zero selects
+    ///        the full detail everywhere.
+    float PixelScale = 0.0f;
+
+    /// @brief Largest acceptable deviation from the full detail mesh in pixels.
+    float PixelError = 1.0f;
+
+    static LodView
+    fromCamera( CameraSnapshot const & cam, int viewportHeight, float pixelError = 1.0f )
+    {
+        LodView view;
+        view.Position = cam.Position;
+        view.PixelScale = cam.Projection[ 1 ][ 1 ] * 0.5f * viewportHeight;
+        view.PixelError = pixelError;
+
+        return view;
+    }
+};
+
+} // - namespace scene
+} // - namespace noo
+
+
+#endif /* NOO_SCENE_LODVIEW_HPP_INCLUDED_ */
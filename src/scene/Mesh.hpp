@@ -15,11 +15,20 @@
 #include "glm/glm.hpp"
 
 #include "Material.hpp"
+#include "../geometry/Bounds.hpp"
 
 
 namespace noo {
 namespace scene {
 
+struct MeshLod
+{
+    std::vector< uint32_t > Indices;
+
+    /// @brief Deviation from the full detail mesh in model space.
+    float Error;
+};
+
 struct Mesh
 {
     std::vector< glm::vec3 > VertexPositions;
@@ -27,6 +36,12 @@ struct Mesh
 
     std::vector< uint32_t > FaceIndices;
 
+    /// @brief Coarser versions of FaceIndices over the same vertices, Lods[ 0 ] is level 1.
+    std::vector< MeshLod > Lods;
+
+    geometry::AABB Bounds;
+    geometry::BoundingSphere BoundingSphere;
+
     Material * m_Material;
 };
 
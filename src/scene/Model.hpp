@@ -13,7 +13,30 @@
 /// Includes
 #include "Mesh.hpp"
 #include "Material.hpp"
+#include "CookedModel.hpp"
+#include "FrustumCuller.hpp"
+#include "OcclusionCuller.hpp"
+#include "LodView.hpp"
 #include "../renderer/Renderer.hpp"
+#include "../renderer/VertexPacking.hpp"
+#include "../geometry/Bounds.hpp"
+#include "../geometry/Frustum.hpp"
+#include "../geometry/MeshSimplifier.hpp"
+#include "../geometry/MeshOptimizer.hpp"
+#include "../geometry/VertexWelder.hpp"
+#include "../geometry/MeshCodec.hpp"
+#include "../common/ThreadPool.hpp"
+#include "../common/MappedFile.hpp"
+#include "../logging/Logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <sstream>
+
+#include <sys/stat.h>
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -23,21 +46,50 @@
 namespace noo {
 namespace scene {
 
+/// @brief What Model keeps of its CPU mesh data once the geometry is uploaded.
+enum class EResidency
+{
+    /// @brief Everything, as needed by saveCooked().
+    KEEP_ALL,
+
+    /// @brief Bounds, levels of detail and the full detail positions and
+    ///        indices, which addOccluders() rasterizes. Normals and the
+    ///        indices of coarser levels are released.
+    KEEP_OCCLUDERS,
+
+    /// @brief Bounds and levels of detail only, the model can not occlude.
+    RELEASE_ALL
+};
+
 class Model
 {
 public:
 
+    /// @brief Number of levels of detail generated in addition to the full mesh.
+    static constexpr int NumLods = 4;
+
+    /// @brief Meshes with fewer triangles are not simplified.
+    static constexpr size_t MinLodTriangles = 64;
+
     Model()
-        : m_VertexBuffer( nullptr )
+        : m_PositionBuffer( nullptr )
+        , m_NormalBuffer( nullptr )
         , m_IndexBuffer( nullptr )
         , m_Materials()
         , m_Meshes()
         , m_Geometries()
+        , m_DepthGeometries()
         , m_GeometryGenerated( false )
     { }
 
+    static_assert( NumLods + 1 <= cooked::MaxLevels, "Levels of detail do not fit cooked::MeshRecord" );
+
+    /// @brief Imports all meshes of a file. Conversion, welding, normal generation,
+    ///        reordering and simplification of the meshes are spread over pool, if given.
+    ///        analyzeOverdraw adds the overdraw before and after reordering to the
+    ///        log, which rasterizes every mesh twice from six directions.
     static bool
-    createFromFile( std::string const & filename, Model & outModel )
+    createFromFile( std::string const & filename, Model & outModel, common::ThreadPool * pool = nullptr, bool analyzeOverdraw = false )
     {
         Assimp::Importer importer;
         aiScene const * ai_scene = importer.ReadFile( filename.c_str(), 0 );
@@ -48,10 +100,9 @@ public:
             return false;
         }
 
-        std::cout << "Num Materials: " << ai_scene->mNumMaterials << std::endl;
-        std::cout << "Num Meshes: " << ai_scene->mNumMeshes << std::endl;
+        outModel.m_Materials.reserve( ai_scene->mNumMaterials );
 
-        for ( int mat = 0; mat < ai_scene->mNumMaterials; ++mat )
+        for ( unsigned mat = 0; mat < ai_scene->mNumMaterials; ++mat )
         {
             aiMaterial * mtl = ai_scene->mMaterials[ mat ];
 
@@ -61,116 +112,1173 @@ public:
             outModel.m_Materials.push_back( { glm::vec3{ diffuseColor.r, diffuseColor.g, diffuseColor.b } } );
         }
 
-        for ( int m = 0; m < ai_scene->mNumMeshes; ++m )
+        outModel.m_Meshes.resize( ai_scene->mNumMeshes );
+
+        // the meshes are independent, the importer is only read from
+        std::vector< ImportStats > stats( outModel.m_Meshes.size() );
+
+        auto processRange = [ ai_scene, &outModel, &stats, analyzeOverdraw ]( size_t begin, size_t end )
         {
-            aiMesh * mesh = ai_scene->mMeshes[ m ];
+            for ( size_t m = begin; m < end; ++m )
+            {
+                aiMesh const * mesh = ai_scene->mMeshes[ m ];
+                Mesh & outMesh = outModel.m_Meshes[ m ];
 
-            outModel.m_Meshes.emplace_back();
-            Mesh & outMesh = outModel.m_Meshes.back();
+                outMesh.m_Material = &outModel.m_Materials[ mesh->mMaterialIndex ];
 
-            outMesh.m_Material = &outModel.m_Materials[ mesh->mMaterialIndex ];
+                convertMesh( *mesh, outMesh );
+                processMesh( outMesh, stats[ m ], analyzeOverdraw );
+            }
+        };
 
-            std::cout << "   Mesh " << m << " has " << mesh->mNumVertices << " vertices." << std::endl;
+        if ( pool == nullptr )
+            processRange( 0, outModel.m_Meshes.size() );
+        else
+            pool->parallelFor( outModel.m_Meshes.size(), 1, processRange );
 
-            for ( int v = 0; v < mesh->mNumVertices; ++v )
-            {
-                aiVector3D p = mesh->mVertices[ v ];
-                aiVector3D n = mesh->mNormals[ v ];
+        ImportStats total;
 
-                outMesh.VertexPositions.emplace_back( p.x, p.y, p.z );
-                outMesh.VertexNormals.emplace_back( n.x, n.y, n.z );
-            }
+        for ( size_t m = 0; m < outModel.m_Meshes.size(); ++m )
+        {
+            total += stats[ m ];
 
-            std::cout << "   Mesh " << m << " has " << mesh->mNumFaces << " faces." << std::endl;
+            outModel.m_Bounds.extend( outModel.m_Meshes[ m ].Bounds );
+            outModel.m_Culler.add( outModel.m_Meshes[ m ].Bounds );
+        }
 
-            for ( int f = 0; f < mesh->mNumFaces; ++f )
-            {
-                aiFace & face = mesh->mFaces[ f ];
+        // one message per file, imports may run concurrently
+        std::ostringstream log;
+        log << filename << ": " << ai_scene->mNumMaterials << " materials, " << ai_scene->mNumMeshes << " meshes, "
+            << total.NumFaces << " faces\n"
+            << "   Vertices welded: " << total.VerticesBefore << " -> " << total.VerticesAfter << "\n"
+            << "   Vertex cache ACMR: " << total.CacheBefore.getAcmr() << " -> " << total.CacheAfter.getAcmr()
+            << ", ATVR: " << total.CacheBefore.getAtvr() << " -> " << total.CacheAfter.getAtvr();
 
-                assert( face.mNumIndices == 3 );
+        if ( analyzeOverdraw )
+            log << ", overdraw: " << total.OverdrawBefore.getOverdraw() << " -> " << total.OverdrawAfter.getOverdraw();
 
-                int i0 = face.mIndices[ 0 ];
-                int i1 = face.mIndices[ 1 ];
-                int i2 = face.mIndices[ 2 ];
+        NOO_LOG_INFO( "{}", log.str() );
 
-                outMesh.FaceIndices.push_back( i0 );
-                outMesh.FaceIndices.push_back( i1 );
-                outMesh.FaceIndices.push_back( i2 );
-            }
+        return true;
+    }
+
+    /// @brief Imports several files at once, each with createFromFile(). Files and
+    ///        their meshes share pool, so many small models keep it busy as well.
+    /// @return The number of files imported, the models of the others stay empty.
+    static size_t
+    createFromFiles( std::vector< std::string > const & filenames, std::vector< std::unique_ptr< Model > > & outModels, common::ThreadPool * pool = nullptr, bool analyzeOverdraw = false )
+    {
+        outModels.clear();
+
+        for ( size_t f = 0; f < filenames.size(); ++f )
+            outModels.push_back( std::make_unique< Model >() );
+
+        std::vector< uint8_t > imported( filenames.size(), 0 );
+
+        auto importRange = [ & ]( size_t begin, size_t end )
+        {
+            for ( size_t f = begin; f < end; ++f )
+                imported[ f ] = createFromFile( filenames[ f ], *outModels[ f ], pool, analyzeOverdraw ) ? 1 : 0;
+        };
+
+        // nested parallelFor() calls of the single imports are fine
+        if ( pool == nullptr )
+            importRange( 0, filenames.size() );
+        else
+            pool->parallelFor( filenames.size(), 1, importRange );
+
+        return std::count( imported.begin(), imported.end(), 1 );
+    }
+
+    /// @brief Maps a file written by saveCooked(). Vertices and indices are not
+    ///        read but uploaded from the mapping as they are, see CookedModel.hpp.
+    ///        Compressed files are decoded once, spread over pool if given.
+    /// @return false if the file is missing, from another version or corrupt.
+    static bool
+    createFromCooked( std::string const & filename, Model & outModel, common::ThreadPool * pool = nullptr )
+    {
+        common::MappedFile & file = outModel.m_Cooked;
+
+        if ( ! file.open( filename ) || ! isValidCookedHeader( file ) || ! outModel.mapCookedStreams( pool ) || ! outModel.isValidCookedMeshes() )
+        {
+            file.close();
+            outModel.m_CookedStreams = CookedStreams();
+            return false;
         }
 
+        cooked::Header const & header = getCookedHeader( file );
+        auto const * materials = reinterpret_cast< cooked::MaterialRecord const * >( file.getData() + header.Materials.Offset );
+        auto const * records = getCookedMeshes( file );
+
+        outModel.m_Materials.reserve( header.NumMaterials );
+
+        for ( uint32_t mat = 0; mat < header.NumMaterials; ++mat )
+            outModel.m_Materials.push_back( { glm::vec3{ materials[ mat ].Color[ 0 ], materials[ mat ].Color[ 1 ], materials[ mat ].Color[ 2 ] } } );
+
+        outModel.m_Meshes.resize( header.NumMeshes );
+
+        // everything but the vertex data, which is only decoded for occluders
+        for ( uint32_t m = 0; m < header.NumMeshes; ++m )
+        {
+            cooked::MeshRecord const & rec = records[ m ];
+            Mesh & mesh = outModel.m_Meshes[ m ];
+
+            mesh.m_Material = &outModel.m_Materials[ rec.Material ];
+            mesh.Bounds = geometry::AABB( toVec3( rec.BoundsMin ), toVec3( rec.BoundsMax ) );
+            mesh.BoundingSphere = geometry::BoundingSphere( toVec3( rec.SphereCenter ), rec.SphereRadius );
+
+            for ( uint32_t l = 1; l < rec.NumLevels; ++l )
+                mesh.Lods.push_back( { {}, rec.Levels[ l ].Error } );
+
+            outModel.m_Bounds.extend( mesh.Bounds );
+            outModel.m_Culler.add( mesh.Bounds );
+        }
+
+        NOO_LOG_INFO( "Mapped {} bytes, {} meshes from {}", file.getSize(), header.NumMeshes, filename );
+
         return true;
     }
 
+    /// @brief Whether source was modified after cookedFile was written, so the
+    ///        cooked file may be stale. False if either file is missing.
+    static bool
+    isCookedOutdated( std::string const & source, std::string const & cookedFile )
+    {
+        struct stat src, dst;
+
+        if ( ::stat( source.c_str(), &src ) != 0 || ::stat( cookedFile.c_str(), &dst ) != 0 )
+            return false;
+
+        return src.st_mtim.tv_sec > dst.st_mtim.tv_sec
+            || ( src.st_mtim.tv_sec == dst.st_mtim.tv_sec && src.st_mtim.tv_nsec > dst.st_mtim.tv_nsec );
+    }
+
+    /// @brief Writes the meshes in the formats they are uploaded in, for
+    ///        createFromCooked(). The layout is described in CookedModel.hpp.
+    ///        compress codes vertices and indices with geometry::MeshCodec.
+    /// @return false if writing failed or the mesh data was released.
+    bool
+    saveCooked( std::string const & filename, bool compress = false ) const
+    {
+        if ( m_MeshDataReleased )
+            return false;
+
+        std::vector< renderer::Vertex_PosQ4 > vpos;
+        std::vector< renderer::Vertex_NrmOct > vnrm;
+        std::vector< uint32_t > vind;
+        std::vector< cooked::MeshRecord > records;
+
+        packMeshes( vpos, vnrm, vind, records );
+
+        std::vector< cooked::MaterialRecord > materials;
+
+        for ( auto const & mat : m_Materials )
+            materials.push_back( { { mat.Color.x, mat.Color.y, mat.Color.z } } );
+
+        cooked::Header header = {};
+        header.Magic = cooked::Magic;
+        header.Version = cooked::Version;
+        header.NumMaterials = static_cast< uint32_t >( materials.size() );
+        header.NumMeshes = static_cast< uint32_t >( records.size() );
+        header.NumVertices = static_cast< uint32_t >( vpos.size() );
+        header.NumIndices = static_cast< uint32_t >( vind.size() );
+        header.Flags = compress ? cooked::FlagCompressed : 0;
+
+        std::vector< uint8_t > positionBlob, normalBlob, indexBlob;
+
+        if ( compress )
+        {
+            positionBlob = geometry::MeshCodec::encodeVertices( vpos.data(), vpos.size(), renderer::Vertex_PosQ4::SizeInBytes );
+            normalBlob = geometry::MeshCodec::encodeVertices( vnrm.data(), vnrm.size(), renderer::Vertex_NrmOct::SizeInBytes );
+            indexBlob = geometry::MeshCodec::encodeIndices( vind.data(), vind.size() );
+        }
+        else
+        {
+            auto const * p = reinterpret_cast< uint8_t const * >( vpos.data() );
+            auto const * n = reinterpret_cast< uint8_t const * >( vnrm.data() );
+            auto const * i = reinterpret_cast< uint8_t const * >( vind.data() );
+
+            positionBlob.assign( p, p + renderer::Vertex_PosQ4::SizeInBytes * vpos.size() );
+            normalBlob.assign( n, n + renderer::Vertex_NrmOct::SizeInBytes * vnrm.size() );
+            indexBlob.assign( i, i + sizeof( uint32_t ) * vind.size() );
+        }
+
+        for ( int c = 0; c < 3; ++c )
+        {
+            header.BoundsMin[ c ] = m_Bounds.Min[ c ];
+            header.BoundsMax[ c ] = m_Bounds.Max[ c ];
+        }
+
+        size_t end = sizeof( cooked::Header );
+
+        auto place = [ &end ]( cooked::Blob & blob, size_t size )
+        {
+            blob.Offset = cooked::alignBlob( end );
+            blob.Size = size;
+            end = blob.Offset + size;
+        };
+
+        place( header.Materials, sizeof( cooked::MaterialRecord ) * materials.size() );
+        place( header.Meshes, sizeof( cooked::MeshRecord ) * records.size() );
+        place( header.Positions, positionBlob.size() );
+        place( header.Normals, normalBlob.size() );
+        place( header.Indices, indexBlob.size() );
+
+        std::ofstream out( filename, std::ios::binary | std::ios::trunc );
+
+        if ( ! out.is_open() )
+            return false;
+
+        auto write = [ &out ]( cooked::Blob const & blob, void const * data )
+        {
+            static char const zeros[ cooked::BlobAlignment ] = {};
+            out.write( zeros, static_cast< std::streamsize >( blob.Offset - static_cast< uint64_t >( out.tellp() ) ) );
+            out.write( static_cast< char const * >( data ), static_cast< std::streamsize >( blob.Size ) );
+        };
+
+        out.write( reinterpret_cast< char const * >( &header ), sizeof( header ) );
+
+        write( header.Materials, materials.data() );
+        write( header.Meshes, records.data() );
+        write( header.Positions, positionBlob.data() );
+        write( header.Normals, normalBlob.data() );
+        write( header.Indices, indexBlob.data() );
+
+        return out.good();
+    }
+
+    /// @brief Updates which meshes intersect the frustum, draw() and drawDepth() skip the others.
+    /// @return The number of visible meshes.
+    size_t
+    cull( geometry::Frustum const & frustum, common::ThreadPool * pool = nullptr )
+    {
+        return m_Culler.cull( frustum, pool );
+    }
+
+    /// @brief Selects per mesh the coarsest level of detail whose error, projected
+    ///        with view, stays below view.PixelError. Affects draw() and drawDepth().
     void
-    draw( renderer::Renderer & renderer, renderer::RenderTarget const & rt, renderer::Shader::Data & shd, renderer::state::StateSet const & state )
+    selectLods( LodView const & view, glm::mat4 const & transform )
     {
-        if ( ! m_GeometryGenerated )
+        m_LodLevel.resize( m_Meshes.size() );
+
+        float const scale = std::max( { glm::length( glm::vec3( transform[ 0 ] ) )
+                                      , glm::length( glm::vec3( transform[ 1 ] ) )
+                                      , glm::length( glm::vec3( transform[ 2 ] ) ) } );
+
+        for ( size_t m = 0; m < m_Meshes.size(); ++m )
         {
-            m_VertexBuffer = renderer.createVertexBuffer();
-            m_IndexBuffer  = renderer.createIndexBuffer();
+            Mesh const & mesh = m_Meshes[ m ];
+            m_LodLevel[ m ] = 0;
+
+            if ( view.PixelScale <= 0.0f || mesh.Lods.empty() )
+                continue;
 
-            std::vector< renderer::Vertex_Pos3Nrm3 > vposnrm;
-            std::vector< uint32_t > vind;
+            glm::vec3 const center( transform * glm::vec4( mesh.BoundingSphere.Center, 1.0f ) );
+            float const distance = glm::length( center - view.Position ) - mesh.BoundingSphere.Radius * scale;
 
-            int offset = 0;
-            int baseVertex = 0;
+            if ( distance <= 0.0f )
+                continue;
 
-            for ( auto const & m : m_Meshes )
+            float const pixelsPerUnit = view.PixelScale * scale / distance;
+
+            for ( size_t l = 0; l < mesh.Lods.size() && mesh.Lods[ l ].Error * pixelsPerUnit <= view.PixelError; ++l )
+                m_LodLevel[ m ] = static_cast< uint8_t >( l + 1 );
+        }
+    }
+
+    /// @brief Hides the meshes visible after cull() whose bounds are occluded.
+    /// @return The number of meshes hidden.
+    size_t
+    cullOccluded( OcclusionCuller const & occlusion, glm::mat4 const & mvp )
+    {
+        size_t numOccluded = 0;
+
+        for ( size_t m = 0; m < m_Meshes.size(); ++m )
+        {
+            if ( m_Culler.isVisible( m ) && occlusion.isOccluded( m_Meshes[ m ].Bounds, mvp ) )
             {
-                assert( m.VertexPositions.size() == m.VertexNormals.size() );
+                m_Culler.setVisible( m, false );
+                ++numOccluded;
+            }
+        }
 
-                for ( int i = 0; i < m.VertexPositions.size(); ++i )
-                {
-                    auto const & p = m.VertexPositions[ i ];
-                    auto const & n = m.VertexNormals[ i ];
+        return numOccluded;
+    }
+
+    /// @brief Rasterizes all meshes of the model as occluders, none with EResidency::RELEASE_ALL.
+    void
+    addOccluders( OcclusionCuller & occlusion, glm::mat4 const & mvp )
+    {
+        restoreCookedMeshes( false );
+
+        for ( auto const & m : m_Meshes )
+            occlusion.addOccluder( m.VertexPositions, m.FaceIndices, mvp );
+    }
+
+    size_t
+    getNumMeshes() const
+    { return m_Meshes.size(); }
+
+    /// @brief Bounds of all meshes of the model.
+    geometry::AABB const &
+    getBounds() const
+    { return m_Bounds; }
+
+    /// @brief Render thread side of uploading an imported model. Creates its
+    ///        buffers and maps them persistently, so packGeometry() can fill them
+    ///        from a worker while the render thread goes on drawing.
+    /// @return false if there is nothing to map, cooked models upload from their
+    ///         file and empty ones have no storage. uploadGeometry() copes then.
+    bool
+    mapGeometry( renderer::Renderer & renderer )
+    {
+        if ( m_GeometryGenerated || m_Cooked.isOpen() || m_PositionBuffer )
+            return false;
+
+        size_t numVertices, numIndices;
+        getPackedSize( numVertices, numIndices );
+
+        // empty storage can not be mapped
+        if ( numVertices == 0 || numIndices == 0 )
+            return false;
+
+        m_PositionBuffer = renderer.createVertexBuffer();
+        m_NormalBuffer = renderer.createVertexBuffer();
+        m_IndexBuffer  = renderer.createIndexBuffer();
+
+        m_Mapped.Positions = static_cast< renderer::Vertex_PosQ4 * >( m_PositionBuffer->map( renderer::Vertex_PosQ4::SizeInBytes * numVertices ) );
+        m_Mapped.Normals = static_cast< renderer::Vertex_NrmOct * >( m_NormalBuffer->map( renderer::Vertex_NrmOct::SizeInBytes * numVertices ) );
+        m_Mapped.Indices = static_cast< uint32_t * >( m_IndexBuffer->map( sizeof( uint32_t ) * numIndices ) );
+        m_Mapped.NumBytes = ( renderer::Vertex_PosQ4::SizeInBytes + renderer::Vertex_NrmOct::SizeInBytes ) * numVertices + sizeof( uint32_t ) * numIndices;
+
+        if ( m_Mapped.Positions == nullptr || m_Mapped.Normals == nullptr || m_Mapped.Indices == nullptr )
+        {
+            unmapGeometry();
+            return false;
+        }
+
+        return true;
+    }
+
+    /// @brief Packs the meshes into the vertex formats, straight into the buffers
+    ///        of mapGeometry(). Needs no GL context, loaders run it on a worker.
+    ///        Nothing else may use the model meanwhile.
+    void
+    packGeometry()
+    {
+        if ( m_Mapped.Positions == nullptr || m_Mapped.Packed )
+            return;
+
+        packMeshes( m_Mapped.Positions, m_Mapped.Normals, m_Mapped.Indices, m_Mapped.Records );
+        m_Mapped.Packed = true;
+    }
+
+    /// @brief Uploads up to maxBytes of the geometry, continuing where the last
+    ///        call stopped. draw() uploads whatever is left in one go. Models
+    ///        mapped by mapGeometry() are finished at once, packing them first
+    ///        if packGeometry() was not called.
+    /// @return The number of bytes uploaded.
+    size_t
+    uploadGeometry( renderer::Renderer & renderer, size_t maxBytes )
+    {
+        if ( m_GeometryGenerated )
+            return 0;
 
-                    vposnrm.push_back( { p.x, p.y, p.z, n.x, n.y, n.z } );
+        if ( ! m_Cooked.isOpen() )
+        {
+            if ( m_Mapped.Positions != nullptr || mapGeometry( renderer ) )
+            {
+                packGeometry();
+
+                size_t const bytes = m_Mapped.NumBytes;
+                std::vector< cooked::MeshRecord > const records = std::move( m_Mapped.Records );
+
+                if ( unmapGeometry() )
+                {
+                    addGeometries( records.data(), records.size() );
+                    finishUpload();
+                    return bytes;
                 }
+            }
+
+            // not mappable or the mapped contents were lost
+            return uploadPacked( renderer );
+        }
 
-                renderer::Geometry geo;
-                geo.Vertices = m_VertexBuffer.get();
-                geo.Indices = m_IndexBuffer.get();
-                geo.NumPrimitives = m.FaceIndices.size() / 3;
-                geo.VertexFormat = renderer::Vertex_Pos3Nrm3::VertexDesc();
-                geo.Offset = offset;
-                geo.BaseVertex = baseVertex;
+        std::array< UploadRange, 3 > const ranges = getCookedUploadRanges();
 
-                vind.insert( vind.end(), m.FaceIndices.begin(), m.FaceIndices.end() );
+        if ( ! m_PositionBuffer )
+        {
+            m_PositionBuffer = renderer.createVertexBuffer();
+            m_NormalBuffer = renderer.createVertexBuffer();
+            m_IndexBuffer  = renderer.createIndexBuffer();
 
-                offset += m.FaceIndices.size();
-                baseVertex += m.VertexPositions.size();
+            m_PositionBuffer->allocate( ranges[ 0 ].Size );
+            m_NormalBuffer->allocate( ranges[ 1 ].Size );
+            m_IndexBuffer->allocate( ranges[ 2 ].Size );
+        }
+
+        size_t uploaded = 0;
+
+        while ( m_UploadStream < ranges.size() && uploaded < maxBytes )
+        {
+            UploadRange const & r = ranges[ m_UploadStream ];
+            size_t const n = std::min( r.Size - m_UploadOffset, maxBytes - uploaded );
+            void const * data = static_cast< uint8_t const * >( r.Data ) + m_UploadOffset;
 
-                m_Geometries.push_back( geo );
-                m_MaterialList.push_back( m.m_Material );
+            if ( n > 0 )
+            {
+                if ( m_UploadStream == 0 )
+                    m_PositionBuffer->uploadRange( m_UploadOffset, n, data );
+                else if ( m_UploadStream == 1 )
+                    m_NormalBuffer->uploadRange( m_UploadOffset, n, data );
+                else
+                    m_IndexBuffer->uploadRange( m_UploadOffset, n, data );
             }
 
-            m_VertexBuffer->upload( renderer::Vertex_Pos3Nrm3::SizeInBytes * vposnrm.size(), vposnrm.data() );
-            m_IndexBuffer->upload( sizeof( uint32_t ) * vind.size(), vind.data() );
+            m_UploadOffset += n;
+            uploaded += n;
 
-            m_GeometryGenerated = true;
+            if ( m_UploadOffset == r.Size )
+            {
+                ++m_UploadStream;
+                m_UploadOffset = 0;
+            }
         }
 
+        if ( m_UploadStream == ranges.size() )
+        {
+            addGeometries( getCookedMeshes( m_Cooked ), getCookedHeader( m_Cooked ).NumMeshes );
+            finishUpload();
+        }
+
+        return uploaded;
+    }
+
+    /// @brief Takes effect once the geometry is uploaded, or at once if it is.
+    void
+    setResidency( EResidency residency )
+    {
+        m_Residency = residency;
+
+        if ( m_GeometryGenerated )
+            applyResidency();
+    }
+
+    EResidency
+    getResidency() const
+    { return m_Residency; }
+
+    /// @brief False if mesh data was released after upload, see EResidency.
+    bool
+    hasMeshData() const
+    { return ! m_MeshDataReleased; }
+
+    /// @brief Restores released mesh data from the cooked file, all levels with
+    ///        normals. Compressed files are decoded again, spread over pool.
+    ///        The residency is KEEP_ALL afterwards, so it is not released again.
+    /// @return false for imported models, their data can not be restored.
+    bool
+    restoreMeshData( common::ThreadPool * pool = nullptr )
+    {
+        if ( ! m_MeshDataReleased )
+            return true;
+
+        if ( ! m_Cooked.isOpen() || ! mapCookedStreams( pool ) )
+            return false;
+
+        restoreCookedMeshes( true );
+
+        // the meshes have it all now
+        releaseCookedStreams();
+
+        m_Residency = EResidency::KEEP_ALL;
+        m_MeshDataReleased = false;
+
+        return true;
+    }
+
+    /// @brief True once all geometry is uploaded, drawing causes no upload then.
+    bool
+    isResident() const
+    { return m_GeometryGenerated; }
+
+    void
+    draw( renderer::Renderer & renderer, renderer::RenderTarget const & rt, renderer::Shader::Data & shd, renderer::state::StateSet const & state )
+    {
+        generateGeometry( renderer );
+
         for ( int g = 0; g < m_Geometries.size(); ++g )
         {
+            if ( ! m_Culler.isVisible( g ) )
+                continue;
+
             shd[ "u_color" ] = m_MaterialList[ g ]->Color;
+            setQuantization( shd, g );
+
+            renderer.draw( rt, shd, state, m_Geometries[ g ][ getLodLevel( g ) ] );
+        }
+    }
+
+    /// @brief Draws depth only, fetching nothing but vertex positions. The shader
+    ///        is expected to have a single position attribute and no u_color.
+    ///        Both shaders restore positions from u_pos_scale and u_pos_offset.
+    void
+    drawDepth( renderer::Renderer & renderer, renderer::RenderTarget const & rt, renderer::Shader::Data & shd, renderer::state::StateSet const & state )
+    {
+        generateGeometry( renderer );
+
+        for ( int g = 0; g < m_DepthGeometries.size(); ++g )
+        {
+            if ( ! m_Culler.isVisible( g ) )
+                continue;
+
+            setQuantization( shd, g );
 
-            renderer.draw( rt, shd, state, m_Geometries[ g ] );
+            renderer.draw( rt, shd, state, m_DepthGeometries[ g ][ getLodLevel( g ) ] );
         }
     }
 
 private:
 
-    std::unique_ptr< renderer::VertexBuffer > m_VertexBuffer;
+    /// @brief What the import did to the meshes, for the log.
+    struct ImportStats
+    {
+        size_t NumFaces = 0;
+        size_t VerticesBefore = 0;
+        size_t VerticesAfter = 0;
+
+        geometry::MeshOptimizer::VertexCacheStats CacheBefore;
+        geometry::MeshOptimizer::VertexCacheStats CacheAfter;
+        geometry::MeshOptimizer::OverdrawStats OverdrawBefore;
+        geometry::MeshOptimizer::OverdrawStats OverdrawAfter;
+
+        ImportStats &
+        operator+=( ImportStats const & o )
+        {
+            NumFaces += o.NumFaces;
+            VerticesBefore += o.VerticesBefore;
+            VerticesAfter += o.VerticesAfter;
+            CacheBefore += o.CacheBefore;
+            CacheAfter += o.CacheAfter;
+            OverdrawBefore += o.OverdrawBefore;
+            OverdrawAfter += o.OverdrawAfter;
+            return *this;
+        }
+    };
+
+    /// @brief Copies vertices and triangles into mesh, sized up front.
+    static void
+    convertMesh( aiMesh const & mesh, Mesh & outMesh )
+    {
+        outMesh.VertexPositions.resize( mesh.mNumVertices );
+
+        for ( unsigned v = 0; v < mesh.mNumVertices; ++v )
+        {
+            aiVector3D const & p = mesh.mVertices[ v ];
+            outMesh.VertexPositions[ v ] = glm::vec3( p.x, p.y, p.z );
+        }
+
+        // generated in processMesh() otherwise
+        if ( mesh.HasNormals() )
+        {
+            outMesh.VertexNormals.resize( mesh.mNumVertices );
+
+            for ( unsigned v = 0; v < mesh.mNumVertices; ++v )
+            {
+                aiVector3D const & n = mesh.mNormals[ v ];
+                outMesh.VertexNormals[ v ] = glm::vec3( n.x, n.y, n.z );
+            }
+        }
+
+        outMesh.FaceIndices.resize( 3 * size_t( mesh.mNumFaces ) );
+
+        for ( unsigned f = 0; f < mesh.mNumFaces; ++f )
+        {
+            aiFace const & face = mesh.mFaces[ f ];
+
+            assert( face.mNumIndices == 3 );
+
+            outMesh.FaceIndices[ 3 * f + 0 ] = face.mIndices[ 0 ];
+            outMesh.FaceIndices[ 3 * f + 1 ] = face.mIndices[ 1 ];
+            outMesh.FaceIndices[ 3 * f + 2 ] = face.mIndices[ 2 ];
+        }
+    }
+
+    /// @brief Turns the raw imported triangles into what gets uploaded.
+    static void
+    processMesh( Mesh & mesh, ImportStats & stats, bool analyzeOverdraw )
+    {
+        stats.NumFaces = mesh.FaceIndices.size() / 3;
+        stats.VerticesBefore = mesh.VertexPositions.size();
+        stats.CacheBefore = geometry::MeshOptimizer::analyzeVertexCache( mesh.FaceIndices, mesh.VertexPositions.size() );
+
+        if ( analyzeOverdraw )
+            stats.OverdrawBefore = geometry::MeshOptimizer::analyzeOverdraw( mesh.FaceIndices, mesh.VertexPositions );
+
+        if ( mesh.VertexNormals.size() != mesh.VertexPositions.size() )
+            geometry::VertexWelder::generateNormals( mesh.VertexPositions, mesh.FaceIndices, mesh.VertexNormals );
+
+        stats.VerticesAfter = geometry::VertexWelder::weld( mesh.VertexPositions, mesh.VertexNormals, mesh.FaceIndices );
+
+        optimizeMesh( mesh );
+
+        stats.CacheAfter = geometry::MeshOptimizer::analyzeVertexCache( mesh.FaceIndices, mesh.VertexPositions.size() );
+
+        if ( analyzeOverdraw )
+            stats.OverdrawAfter = geometry::MeshOptimizer::analyzeOverdraw( mesh.FaceIndices, mesh.VertexPositions );
+
+        mesh.Bounds = geometry::AABB::fromPoints( mesh.VertexPositions );
+        mesh.BoundingSphere = geometry::BoundingSphere::fromPoints( mesh.VertexPositions, mesh.Bounds );
+
+        generateLods( mesh );
+    }
+
+    /// @brief Reorders triangles for the vertex cache and against overdraw, then the
+    ///        vertices in the order the triangles use them.
+    static void
+    optimizeMesh( Mesh & mesh )
+    {
+        std::vector< size_t > clusters;
+        geometry::MeshOptimizer::optimizeVertexCache( mesh.FaceIndices, mesh.VertexPositions.size(), &clusters );
+        geometry::MeshOptimizer::optimizeOverdraw( mesh.FaceIndices, mesh.VertexPositions, clusters );
+
+        std::vector< uint32_t > const remap = geometry::MeshOptimizer::optimizeVertexFetch( mesh.FaceIndices, mesh.VertexPositions.size() );
+        geometry::MeshOptimizer::remapIndices( mesh.FaceIndices, remap );
+        geometry::MeshOptimizer::remapVertices( mesh.VertexPositions, remap );
+        geometry::MeshOptimizer::remapVertices( mesh.VertexNormals, remap );
+    }
+
+    /// @brief Each level has half the triangles of the previous one, simplified from it.
+    static void
+    generateLods( Mesh & mesh )
+    {
+        std::vector< uint32_t > const * source = &mesh.FaceIndices;
+        float error = 0.0f;
+
+        for ( int l = 0; l < NumLods; ++l )
+        {
+            size_t const numIndices = source->size();
+
+            if ( numIndices < 3 * MinLodTriangles )
+                break;
+
+            MeshLod lod;
+            error += geometry::MeshSimplifier::simplify( mesh.VertexPositions, mesh.VertexNormals, *source, numIndices / 2, lod.Indices );
+            lod.Error = error;
+
+            // locked borders or a tiny error budget, further levels would not be cheaper
+            if ( lod.Indices.size() > numIndices * 9 / 10 )
+                break;
+
+            std::vector< size_t > clusters;
+            geometry::MeshOptimizer::optimizeVertexCache( lod.Indices, mesh.VertexPositions.size(), &clusters );
+            geometry::MeshOptimizer::optimizeOverdraw( lod.Indices, mesh.VertexPositions, clusters );
+
+            mesh.Lods.push_back( std::move( lod ) );
+            source = &mesh.Lods.back().Indices;
+        }
+    }
+
+    void
+    setQuantization( renderer::Shader::Data & shd, size_t mesh ) const
+    {
+        shd[ "u_pos_scale" ] = m_Quantization[ mesh ].Scale;
+        shd[ "u_pos_offset" ] = m_Quantization[ mesh ].Offset;
+    }
+
+    uint8_t
+    getLodLevel( size_t mesh ) const
+    { return mesh < m_LodLevel.size() ? m_LodLevel[ mesh ] : 0; }
+
+    /// @brief Vertices and indices of all meshes and levels, as packMeshes() writes them.
+    void
+    getPackedSize( size_t & numVertices, size_t & numIndices ) const
+    {
+        numVertices = 0;
+        numIndices = 0;
+
+        for ( auto const & m : m_Meshes )
+        {
+            numVertices += m.VertexPositions.size();
+            numIndices += m.FaceIndices.size();
+
+            for ( auto const & lod : m.Lods )
+                numIndices += lod.Indices.size();
+        }
+    }
+
+    /// @brief Packs all meshes into the formats they are uploaded in, one record
+    ///        per mesh telling where its vertices and levels of detail are.
+    void
+    packMeshes( std::vector< renderer::Vertex_PosQ4 > & vpos
+              , std::vector< renderer::Vertex_NrmOct > & vnrm
+              , std::vector< uint32_t > & vind
+              , std::vector< cooked::MeshRecord > & records ) const
+    {
+        size_t numVertices, numIndices;
+        getPackedSize( numVertices, numIndices );
+
+        vpos.resize( numVertices );
+        vnrm.resize( numVertices );
+        vind.resize( numIndices );
+
+        packMeshes( vpos.data(), vnrm.data(), vind.data(), records );
+    }
+
+    /// @brief As above, into arrays of getPackedSize(), which may be mapped buffers.
+    ///        All meshes share one quantization grid spanning the model, so
+    ///        vertices on the border of two meshes do not crack apart.
+    void
+    packMeshes( renderer::Vertex_PosQ4 * vpos
+              , renderer::Vertex_NrmOct * vnrm
+              , uint32_t * vind
+              , std::vector< cooked::MeshRecord > & records ) const
+    {
+        uint32_t baseVertex = 0;
+        uint32_t indexOffset = 0;
+
+        renderer::PositionQuantization const q = renderer::VertexPacking::computeQuantization( m_Bounds.Min, m_Bounds.Max );
+
+        records.reserve( m_Meshes.size() );
+
+        for ( auto const & m : m_Meshes )
+        {
+            assert( m.VertexPositions.size() == m.VertexNormals.size() );
+
+            cooked::MeshRecord rec = {};
+            rec.Material = static_cast< uint32_t >( m.m_Material - m_Materials.data() );
+            rec.BaseVertex = baseVertex;
+            rec.NumVertices = static_cast< uint32_t >( m.VertexPositions.size() );
+
+            renderer::VertexPacking::packMesh( m.VertexPositions, m.VertexNormals, q, vpos + baseVertex, vnrm + baseVertex );
+            baseVertex += rec.NumVertices;
+
+            // all levels of a mesh follow each other in the index buffer
+            for ( size_t l = 0; l <= m.Lods.size(); ++l )
+            {
+                std::vector< uint32_t > const & indices = l == 0 ? m.FaceIndices : m.Lods[ l - 1 ].Indices;
+
+                rec.Levels[ l ] = { indexOffset, static_cast< uint32_t >( indices.size() ), l == 0 ? 0.0f : m.Lods[ l - 1 ].Error };
+                std::copy( indices.begin(), indices.end(), vind + indexOffset );
+                indexOffset += static_cast< uint32_t >( indices.size() );
+            }
+
+            rec.NumLevels = static_cast< uint32_t >( m.Lods.size() + 1 );
+
+            for ( int c = 0; c < 3; ++c )
+            {
+                rec.BoundsMin[ c ] = m.Bounds.Min[ c ];
+                rec.BoundsMax[ c ] = m.Bounds.Max[ c ];
+                rec.SphereCenter[ c ] = m.BoundingSphere.Center[ c ];
+                rec.PositionScale[ c ] = q.Scale[ c ];
+                rec.PositionOffset[ c ] = q.Offset[ c ];
+            }
+
+            rec.SphereRadius = m.BoundingSphere.Radius;
+
+            records.push_back( rec );
+        }
+    }
+
+    /// @brief Unmaps the buffers of mapGeometry(), they are reset if that fails.
+    /// @return false if the mapped contents were lost.
+    bool
+    unmapGeometry()
+    {
+        bool ok = true;
+
+        if ( m_Mapped.Positions != nullptr ) ok &= m_PositionBuffer->unmap();
+        if ( m_Mapped.Normals != nullptr ) ok &= m_NormalBuffer->unmap();
+        if ( m_Mapped.Indices != nullptr ) ok &= m_IndexBuffer->unmap();
+
+        m_Mapped = MappedGeometry();
+
+        if ( ! ok )
+        {
+            m_PositionBuffer.reset();
+            m_NormalBuffer.reset();
+            m_IndexBuffer.reset();
+        }
+
+        return ok;
+    }
+
+    /// @brief Fallback for imported models which can not be mapped, packs into
+    ///        temporary arrays and uploads those in one go.
+    size_t
+    uploadPacked( renderer::Renderer & renderer )
+    {
+        std::vector< renderer::Vertex_PosQ4 > vpos;
+        std::vector< renderer::Vertex_NrmOct > vnrm;
+        std::vector< uint32_t > vind;
+        std::vector< cooked::MeshRecord > records;
+
+        packMeshes( vpos, vnrm, vind, records );
+
+        size_t const posBytes = renderer::Vertex_PosQ4::SizeInBytes * vpos.size();
+        size_t const nrmBytes = renderer::Vertex_NrmOct::SizeInBytes * vnrm.size();
+        size_t const indBytes = sizeof( uint32_t ) * vind.size();
+
+        m_PositionBuffer = renderer.createVertexBuffer();
+        m_NormalBuffer = renderer.createVertexBuffer();
+        m_IndexBuffer  = renderer.createIndexBuffer();
+
+        m_PositionBuffer->upload( posBytes, vpos.data() );
+        m_NormalBuffer->upload( nrmBytes, vnrm.data() );
+        m_IndexBuffer->upload( static_cast< uint32_t >( indBytes ), vind.data() );
+
+        addGeometries( records.data(), records.size() );
+        finishUpload();
+
+        return posBytes + nrmBytes + indBytes;
+    }
+
+    void
+    generateGeometry( renderer::Renderer & renderer )
+    {
+        uploadGeometry( renderer, std::numeric_limits< size_t >::max() );
+    }
+
+    struct UploadRange
+    {
+        void const * Data;
+        size_t Size;
+    };
+
+    /// @brief Sources of the position, normal and index buffer of a cooked model.
+    std::array< UploadRange, 3 >
+    getCookedUploadRanges() const
+    {
+        cooked::Header const & header = getCookedHeader( m_Cooked );
+
+        return { { { m_CookedStreams.Positions, renderer::Vertex_PosQ4::SizeInBytes * size_t( header.NumVertices ) }
+                 , { m_CookedStreams.Normals, renderer::Vertex_NrmOct::SizeInBytes * size_t( header.NumVertices ) }
+                 , { m_CookedStreams.Indices, sizeof( uint32_t ) * size_t( header.NumIndices ) } } };
+    }
+
+    /// @brief Geometry per mesh and level, for the uploaded buffers described by records.
+    void
+    addGeometries( cooked::MeshRecord const * records, size_t numRecords )
+    {
+        for ( size_t m = 0; m < numRecords; ++m )
+        {
+            cooked::MeshRecord const & rec = records[ m ];
+
+            m_Quantization.push_back( { toVec3( rec.PositionScale ), toVec3( rec.PositionOffset ) } );
+            m_MaterialList.push_back( &m_Materials[ rec.Material ] );
+
+            m_Geometries.emplace_back();
+            m_DepthGeometries.emplace_back();
+
+            for ( uint32_t l = 0; l < rec.NumLevels; ++l )
+            {
+                // depth passes fetch the 8 byte position stream alone
+                renderer::Geometry depthGeo;
+                depthGeo.Vertices = m_PositionBuffer.get();
+                depthGeo.Indices = m_IndexBuffer.get();
+                depthGeo.NumPrimitives = rec.Levels[ l ].NumIndices / 3;
+                depthGeo.VertexFormat = renderer::Vertex_PosQ4::VertexDesc();
+                depthGeo.Offset = rec.Levels[ l ].IndexOffset;
+                depthGeo.BaseVertex = rec.BaseVertex;
+
+                renderer::Geometry geo = depthGeo;
+                geo.AttributeStreams.push_back( { m_NormalBuffer.get(), renderer::Vertex_NrmOct::VertexDesc() } );
+
+                m_Geometries.back().push_back( geo );
+                m_DepthGeometries.back().push_back( depthGeo );
+            }
+        }
+    }
+
+    /// @brief Cooked meshes have no float vertices, those of the full detail level
+    ///        are decoded from the streams the first time they are rasterized.
+    ///        full also restores the normals and the coarser levels.
+    void
+    restoreCookedMeshes( bool full )
+    {
+        // released streams, what is left of the meshes is all there is
+        if ( ! m_Cooked.isOpen() || m_CookedStreams.Positions == nullptr )
+            return;
+
+        auto const * records = getCookedMeshes( m_Cooked );
+        auto const * positions = m_CookedStreams.Positions;
+        auto const * normals = m_CookedStreams.Normals;
+        auto const * indices = m_CookedStreams.Indices;
+
+        auto levelIndices = [ indices ]( cooked::LevelRecord const & level, std::vector< uint32_t > & out )
+        {
+            out.assign( indices + level.IndexOffset, indices + level.IndexOffset + level.NumIndices );
+        };
+
+        for ( size_t m = 0; m < m_Meshes.size(); ++m )
+        {
+            Mesh & mesh = m_Meshes[ m ];
+            cooked::MeshRecord const & rec = records[ m ];
+
+            if ( ! mesh.FaceIndices.empty() && ( ! full || ! mesh.VertexNormals.empty() ) )
+                continue;
+
+            glm::vec3 const scale = toVec3( rec.PositionScale ) / 65535.0f;
+            glm::vec3 const offset = toVec3( rec.PositionOffset );
+
+            mesh.VertexPositions.resize( rec.NumVertices );
+
+            for ( uint32_t v = 0; v < rec.NumVertices; ++v )
+            {
+                renderer::Vertex_PosQ4 const & q = positions[ rec.BaseVertex + v ];
+                mesh.VertexPositions[ v ] = glm::vec3( q.x, q.y, q.z ) * scale + offset;
+            }
+
+            levelIndices( rec.Levels[ 0 ], mesh.FaceIndices );
+
+            if ( ! full )
+                continue;
+
+            mesh.VertexNormals.resize( rec.NumVertices );
+
+            for ( uint32_t v = 0; v < rec.NumVertices; ++v )
+            {
+                renderer::Vertex_NrmOct const & n = normals[ rec.BaseVertex + v ];
+                mesh.VertexNormals[ v ] = renderer::VertexPacking::decodeOctahedral( glm::vec2( n.nu, n.nv ) / 32767.0f );
+            }
+
+            for ( uint32_t l = 1; l < rec.NumLevels; ++l )
+                levelIndices( rec.Levels[ l ], mesh.Lods[ l - 1 ].Indices );
+        }
+    }
+
+    void
+    finishUpload()
+    {
+        m_GeometryGenerated = true;
+
+        applyResidency();
+    }
+
+    /// @brief Releases the mesh data the residency does not keep. Assigning
+    ///        empty vectors frees their memory, clear() would keep it.
+    void
+    applyResidency()
+    {
+        if ( m_Residency == EResidency::KEEP_ALL )
+            return;
+
+        // occluders of cooked models are decoded before their source goes
+        if ( m_Residency == EResidency::KEEP_OCCLUDERS )
+            restoreCookedMeshes( false );
+
+        for ( auto & m : m_Meshes )
+        {
+            m.VertexNormals = {};
+
+            for ( auto & lod : m.Lods )
+                lod.Indices = {};
+
+            if ( m_Residency == EResidency::RELEASE_ALL )
+            {
+                m.VertexPositions = {};
+                m.FaceIndices = {};
+            }
+        }
+
+        releaseCookedStreams();
+
+        m_MeshDataReleased = true;
+    }
+
+    /// @brief Forgets the uploaded streams, frees them if decoded.
+    void
+    releaseCookedStreams()
+    {
+        m_DecodedPositions = {};
+        m_DecodedNormals = {};
+        m_DecodedIndices = {};
+        m_CookedStreams = CookedStreams();
+    }
+
+    static glm::vec3
+    toVec3( float const * v )
+    { return glm::vec3( v[ 0 ], v[ 1 ], v[ 2 ] ); }
+
+    static cooked::Header const &
+    getCookedHeader( common::MappedFile const & file )
+    { return *reinterpret_cast< cooked::Header const * >( file.getData() ); }
+
+    static cooked::MeshRecord const *
+    getCookedMeshes( common::MappedFile const & file )
+    { return reinterpret_cast< cooked::MeshRecord const * >( file.getData() + getCookedHeader( file ).Meshes.Offset ); }
+
+    /// @brief Checks the header and that the blobs lie within the file.
+    static bool
+    isValidCookedHeader( common::MappedFile const & file )
+    {
+        size_t const size = file.getSize();
+
+        if ( size < sizeof( cooked::Header ) )
+            return false;
+
+        cooked::Header const & header = getCookedHeader( file );
+
+        if ( header.Magic != cooked::Magic || header.Version != cooked::Version )
+            return false;
+
+        for ( cooked::Blob const * b : { &header.Materials, &header.Meshes, &header.Positions, &header.Normals, &header.Indices } )
+        {
+            if ( ! cooked::isInside( *b, size ) || b->Offset % cooked::BlobAlignment != 0 )
+                return false;
+        }
+
+        if ( header.Materials.Size != uint64_t( header.NumMaterials ) * sizeof( cooked::MaterialRecord )
+          || header.Meshes.Size != uint64_t( header.NumMeshes ) * sizeof( cooked::MeshRecord ) )
+            return false;
+
+        // compressed sizes are checked by the decoder
+        if ( header.Flags & cooked::FlagCompressed )
+            return true;
+
+        return header.Positions.Size == uint64_t( header.NumVertices ) * renderer::Vertex_PosQ4::SizeInBytes
+            && header.Normals.Size == uint64_t( header.NumVertices ) * renderer::Vertex_NrmOct::SizeInBytes
+            && header.Indices.Size == uint64_t( header.NumIndices ) * sizeof( uint32_t );
+    }
+
+    /// @brief Points m_CookedStreams at the mapped blobs, or at the decoded ones
+    ///        for compressed files.
+    /// @return false if decoding failed.
+    bool
+    mapCookedStreams( common::ThreadPool * pool )
+    {
+        cooked::Header const & header = getCookedHeader( m_Cooked );
+        uint8_t const * data = m_Cooked.getData();
+
+        if ( ! ( header.Flags & cooked::FlagCompressed ) )
+        {
+            m_CookedStreams.Positions = reinterpret_cast< renderer::Vertex_PosQ4 const * >( data + header.Positions.Offset );
+            m_CookedStreams.Normals = reinterpret_cast< renderer::Vertex_NrmOct const * >( data + header.Normals.Offset );
+            m_CookedStreams.Indices = reinterpret_cast< uint32_t const * >( data + header.Indices.Offset );
+            return true;
+        }
+
+        // the counts are untrusted, they must fit the blobs before anything is allocated
+        if ( ! geometry::MeshCodec::canHoldVertices( header.NumVertices, renderer::Vertex_PosQ4::SizeInBytes, data + header.Positions.Offset, header.Positions.Size )
+          || ! geometry::MeshCodec::canHoldVertices( header.NumVertices, renderer::Vertex_NrmOct::SizeInBytes, data + header.Normals.Offset, header.Normals.Size )
+          || ! geometry::MeshCodec::canHoldIndices( header.NumIndices, data + header.Indices.Offset, header.Indices.Size ) )
+            return false;
+
+        m_DecodedPositions.resize( header.NumVertices );
+        m_DecodedNormals.resize( header.NumVertices );
+        m_DecodedIndices.resize( header.NumIndices );
+
+        // the streams are chunked, each call keeps the whole pool busy
+        if ( ! geometry::MeshCodec::decodeVertices( m_DecodedPositions.data(), header.NumVertices, renderer::Vertex_PosQ4::SizeInBytes, data + header.Positions.Offset, header.Positions.Size, pool )
+          || ! geometry::MeshCodec::decodeVertices( m_DecodedNormals.data(), header.NumVertices, renderer::Vertex_NrmOct::SizeInBytes, data + header.Normals.Offset, header.Normals.Size, pool )
+          || ! geometry::MeshCodec::decodeIndices( m_DecodedIndices.data(), header.NumIndices, data + header.Indices.Offset, header.Indices.Size, pool ) )
+            return false;
+
+        m_CookedStreams.Positions = m_DecodedPositions.data();
+        m_CookedStreams.Normals = m_DecodedNormals.data();
+        m_CookedStreams.Indices = m_DecodedIndices.data();
+
+        return true;
+    }
+
+    /// @brief Checks everything the loader and generateGeometry() index with.
+    bool
+    isValidCookedMeshes() const
+    {
+        cooked::Header const & header = getCookedHeader( m_Cooked );
+        auto const * records = getCookedMeshes( m_Cooked );
+
+        for ( uint32_t m = 0; m < header.NumMeshes; ++m )
+        {
+            cooked::MeshRecord const & rec = records[ m ];
+
+            if ( rec.Material >= header.NumMaterials || rec.NumLevels == 0 || rec.NumLevels > cooked::MaxLevels
+              || uint64_t( rec.BaseVertex ) + rec.NumVertices > header.NumVertices )
+                return false;
+
+            for ( uint32_t l = 0; l < rec.NumLevels; ++l )
+            {
+                if ( uint64_t( rec.Levels[ l ].IndexOffset ) + rec.Levels[ l ].NumIndices > header.NumIndices )
+                    return false;
+
+                // every level is drawn from the vertices of the mesh alone
+                uint32_t const * indices = m_CookedStreams.Indices + rec.Levels[ l ].IndexOffset;
+
+                if ( std::any_of( indices, indices + rec.Levels[ l ].NumIndices, [ &rec ]( uint32_t i ) { return i >= rec.NumVertices; } ) )
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    /// @brief Two streams, the depth passes bind the positions only.
+    std::unique_ptr< renderer::VertexBuffer > m_PositionBuffer;
+    std::unique_ptr< renderer::VertexBuffer > m_NormalBuffer;
     std::unique_ptr< renderer::IndexBuffer > m_IndexBuffer;
 
     std::vector< Material > m_Materials;
     std::vector< Mesh > m_Meshes;
 
-    std::vector< renderer::Geometry > m_Geometries;
+    /// @brief Per mesh, per level of detail.
+    std::vector< std::vector< renderer::Geometry > > m_Geometries;
+    std::vector< std::vector< renderer::Geometry > > m_DepthGeometries;
     std::vector< Material * > m_MaterialList;
 
+    /// @brief Per mesh, restores the positions of the packed vertices.
+    std::vector< renderer::PositionQuantization > m_Quantization;
+
+    /// @brief The buffers of an imported model while mapped by mapGeometry().
+    struct MappedGeometry
+    {
+        renderer::Vertex_PosQ4 * Positions = nullptr;
+        renderer::Vertex_NrmOct * Normals = nullptr;
+        uint32_t * Indices = nullptr;
+        size_t NumBytes = 0;
+
+        /// @brief Written by packGeometry().
+        std::vector< cooked::MeshRecord > Records;
+        bool Packed = false;
+    };
+
+    MappedGeometry m_Mapped;
+
+    /// @brief Progress of uploadGeometry(), the stream and the offset within.
+    size_t m_UploadStream = 0;
+    size_t m_UploadOffset = 0;
+
+    /// @brief Open if the model was created from a cooked file, see createFromCooked().
+    common::MappedFile m_Cooked;
+
+    /// @brief Vertex and index data of a cooked file, in the mapping or in the
+    ///        m_Decoded vectors for compressed files.
+    struct CookedStreams
+    {
+        renderer::Vertex_PosQ4 const * Positions = nullptr;
+        renderer::Vertex_NrmOct const * Normals = nullptr;
+        uint32_t const * Indices = nullptr;
+    };
+
+    CookedStreams m_CookedStreams;
+
+    std::vector< renderer::Vertex_PosQ4 > m_DecodedPositions;
+    std::vector< renderer::Vertex_NrmOct > m_DecodedNormals;
+    std::vector< uint32_t > m_DecodedIndices;
+
     bool m_GeometryGenerated;
+
+    EResidency m_Residency = EResidency::KEEP_ALL;
+    bool m_MeshDataReleased = false;
+
+    geometry::AABB m_Bounds;
+
+    /// @brief One box per mesh, same order as m_Meshes and m_Geometries.
+    FrustumCuller m_Culler;
+
+    /// @brief Selected level of detail per mesh.
+    std::vector< uint8_t > m_LodLevel;
 };
 
 } // - namespace scene
@@ -0,0 +1,438 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: OcclusionCuller.hpp                                              ///
+/// @brief: Software occlusion culling. A few occluder meshes are           ///
+///         rasterized into a small depth buffer on the CPU, four pixels    ///
+///         at a time. A second level stores the farthest depth of every    ///
+///         tile, so most bounding box tests only touch a few tiles.        ///
+///                                                                         ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_SCENE_OCCLUSIONCULLER_HPP_INCLUDED_
+#define NOO_SCENE_OCCLUSIONCULLER_HPP_INCLUDED_
+
+
+/// Includes
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#if defined( __SSE2__ )
+#include <immintrin.h>
+#endif
+
+#include "glm/glm.hpp"
+
+#include "../geometry/Bounds.hpp"
+#include "../common/ThreadPool.hpp"
+
+
+namespace noo {
+namespace scene {
+
+class OcclusionCuller
+{
+public:
+
+    /// @brief Width and height of a tile of the coarse level in pixels.
+    static constexpr int TileSize = 8;
+
+    /// @brief Rows rasterized by one worker task, a multiple of TileSize.
+    static constexpr int BandHeight = 2 * TileSize;
+
+    /// @brief Sizes the depth buffer, both dimensions are rounded up to whole tiles.
+    ///        It does not need the resolution of the view, only its aspect ratio.
+    void
+    resize( int width, int height )
+    {
+        m_Width = ( std::max( width, 1 ) + TileSize - 1 ) / TileSize * TileSize;
+        m_Height = ( std::max( height, 1 ) + TileSize - 1 ) / TileSize * TileSize;
+
+        m_Depth.assign( static_cast< size_t >( m_Width ) * m_Height, 1.0f );
+        m_TileMax.assign( static_cast< size_t >( getNumTilesX() ) * getNumTilesY(), 1.0f );
+    }
+
+    int
+    getWidth() const
+    { return m_Width; }
+
+    int
+    getHeight() const
+    { return m_Height; }
+
+    /// @brief Drops the occluders of the previous frame.
+    void
+    begin()
+    {
+        m_Triangles.clear();
+    }
+
+    /// @brief Queues the triangles of an occluder, transformed by mvp into clip space.
+    ///        Both faces are rasterized, the winding does not matter.
+    void
+    addOccluder( std::vector< glm::vec3 > const & positions, std::vector< uint32_t > const & indices, glm::mat4 const & mvp )
+    {
+        m_Clip.resize( positions.size() );
+
+        for ( size_t i = 0; i < positions.size(); ++i )
+            m_Clip[ i ] = mvp * glm::vec4( positions[ i ], 1.0f );
+
+        for ( size_t t = 0; t + 2 < indices.size(); t += 3 )
+        {
+            glm::vec4 const & a = m_Clip[ indices[ t + 0 ] ];
+            glm::vec4 const & b = m_Clip[ indices[ t + 1 ] ];
+            glm::vec4 const & c = m_Clip[ indices[ t + 2 ] ];
+
+            // trivially outside of one of the side or the far planes
+            if ( ( a.x < -a.w && b.x < -b.w && c.x < -c.w ) || ( a.x > a.w && b.x > b.w && c.x > c.w )
+              || ( a.y < -a.w && b.y < -b.w && c.y < -c.w ) || ( a.y > a.w && b.y > b.w && c.y > c.w )
+              || ( a.z > a.w && b.z > b.w && c.z > c.w ) )
+                continue;
+
+            bool const aIn = a.z >= -a.w;
+            bool const bIn = b.z >= -b.w;
+            bool const cIn = c.z >= -c.w;
+
+            if ( aIn && bIn && cIn )
+            {
+                addTriangle( a, b, c );
+            }
+            else if ( aIn || bIn || cIn )
+            {
+                clipNear( a, b, c );
+            }
+        }
+    }
+
+    /// @brief Rasterizes all queued occluders and builds the tile level.
+    void
+    rasterize( common::ThreadPool * pool = nullptr )
+    {
+        int const numBands = ( m_Height + BandHeight - 1 ) / BandHeight;
+
+        // sort the triangles into the bands they touch, so no band walks all of them
+        m_Bands.resize( numBands );
+
+        for ( auto & band : m_Bands )
+            band.clear();
+
+        for ( uint32_t t = 0; t < m_Triangles.size(); ++t )
+        {
+            Triangle const & tri = m_Triangles[ t ];
+
+            float const minY = std::min( { tri.V[ 0 ].y, tri.V[ 1 ].y, tri.V[ 2 ].y } );
+            float const maxY = std::max( { tri.V[ 0 ].y, tri.V[ 1 ].y, tri.V[ 2 ].y } );
+
+            if ( maxY < 0.0f || minY >= m_Height )
+                continue;
+
+            int const b0 = static_cast< int >( std::max( minY, 0.0f ) ) / BandHeight;
+            int const b1 = std::min( static_cast< int >( std::min( maxY, static_cast< float >( m_Height - 1 ) ) ) / BandHeight, numBands - 1 );
+
+            for ( int b = b0; b <= b1; ++b )
+                m_Bands[ b ].push_back( t );
+        }
+
+        auto rasterizeBands = [ this ]( size_t first, size_t last )
+        {
+            for ( size_t b = first; b < last; ++b )
+            {
+                int const y0 = static_cast< int >( b ) * BandHeight;
+                int const y1 = std::min( y0 + BandHeight, m_Height );
+
+                std::fill( m_Depth.begin() + static_cast< size_t >( y0 ) * m_Width
+                         , m_Depth.begin() + static_cast< size_t >( y1 ) * m_Width, 1.0f );
+
+                for ( uint32_t t : m_Bands[ b ] )
+                    rasterizeTriangle( m_Triangles[ t ], y0, y1 );
+
+                updateTiles( y0, y1 );
+            }
+        };
+
+        if ( pool == nullptr )
+            rasterizeBands( 0, numBands );
+        else
+            pool->parallelFor( numBands, 1, rasterizeBands );
+    }
+
+    /// @brief Tests a box against the rasterized occluders.
+    /// @return true if the box is certainly hidden, boxes crossing the near plane never are.
+    bool
+    isOccluded( geometry::AABB const & box, glm::mat4 const & mvp ) const
+    {
+        if ( box.isEmpty() || m_Width == 0 )
+            return false;
+
+        float minX = std::numeric_limits< float >::max();
+        float minY = std::numeric_limits< float >::max();
+        float maxX = -std::numeric_limits< float >::max();
+        float maxY = -std::numeric_limits< float >::max();
+        float minZ = 1.0f;
+
+        for ( int c = 0; c < 8; ++c )
+        {
+            glm::vec3 const corner( ( c & 1 ) ? box.Max.x : box.Min.x
+                                  , ( c & 2 ) ? box.Max.y : box.Min.y
+                                  , ( c & 4 ) ? box.Max.z : box.Min.z );
+
+            glm::vec4 const clip = mvp * glm::vec4( corner, 1.0f );
+
+            if ( clip.z < -clip.w || clip.w <= 0.0f )
+                return false;
+
+            glm::vec3 const s = toScreen( clip );
+            minX = std::min( minX, s.x ); maxX = std::max( maxX, s.x );
+            minY = std::min( minY, s.y ); maxY = std::max( maxY, s.y );
+            minZ = std::min( minZ, s.z );
+        }
+
+        // off screen, that is up to the frustum culler
+        if ( maxX < 0.0f || maxY < 0.0f || minX >= m_Width || minY >= m_Height )
+            return false;
+
+        // every pixel the projected box touches
+        int const x0 = static_cast< int >( std::max( minX, 0.0f ) );
+        int const y0 = static_cast< int >( std::max( minY, 0.0f ) );
+        int const x1 = std::min( static_cast< int >( maxX ), m_Width - 1 );
+        int const y1 = std::min( static_cast< int >( maxY ), m_Height - 1 );
+
+        int const numTilesX = getNumTilesX();
+
+        for ( int ty = y0 / TileSize; ty <= y1 / TileSize; ++ty )
+        {
+            for ( int tx = x0 / TileSize; tx <= x1 / TileSize; ++tx )
+            {
+                if ( m_TileMax[ ty * numTilesX + tx ] < minZ )
+                    continue;
+
+                // the tile has farther pixels, check the covered ones
+                int const py0 = std::max( y0, ty * TileSize );
+                int const py1 = std::min( y1, ty * TileSize + TileSize - 1 );
+                int const px0 = std::max( x0, tx * TileSize );
+                int const px1 = std::min( x1, tx * TileSize + TileSize - 1 );
+
+                for ( int y = py0; y <= py1; ++y )
+                {
+                    float const * row = &m_Depth[ static_cast< size_t >( y ) * m_Width ];
+
+                    for ( int x = px0; x <= px1; ++x )
+                    {
+                        if ( row[ x ] >= minZ )
+                            return false;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+private:
+
+    /// @brief Screen space vertex, x and y in pixels, z is the window depth in [0, 1].
+    struct Triangle
+    {
+        std::array< glm::vec3, 3 > V;
+    };
+
+    int
+    getNumTilesX() const
+    { return m_Width / TileSize; }
+
+    int
+    getNumTilesY() const
+    { return m_Height / TileSize; }
+
+    glm::vec3
+    toScreen( glm::vec4 const & clip ) const
+    {
+        float const invW = 1.0f / clip.w;
+
+        return { ( clip.x * invW * 0.5f + 0.5f ) * m_Width
+               , ( clip.y * invW * 0.5f + 0.5f ) * m_Height
+               , clip.z * invW * 0.5f + 0.5f };
+    }
+
+    void
+    addTriangle( glm::vec4 const & a, glm::vec4 const & b, glm::vec4 const & c )
+    {
+        Triangle tri{ { toScreen( a ), toScreen( b ), toScreen( c ) } };
+
+        float const area = ( tri.V[ 1 ].x - tri.V[ 0 ].x ) * ( tri.V[ 2 ].y - tri.V[ 0 ].y )
+                         - ( tri.V[ 2 ].x - tri.V[ 0 ].x ) * ( tri.V[ 1 ].y - tri.V[ 0 ].y );
+
+        if ( ! ( std::abs( area ) > 1.0e-6f ) )
+            return;
+
+        // counter clockwise, so the inside is where all edge functions are positive
+        if ( area < 0.0f )
+            std::swap( tri.V[ 1 ], tri.V[ 2 ] );
+
+        m_Triangles.push_back( tri );
+    }
+
+    /// @brief Clips a triangle with at least one vertex in front of the near plane
+    ///        against it and queues the resulting one or two triangles.
+    void
+    clipNear( glm::vec4 const & a, glm::vec4 const & b, glm::vec4 const & c )
+    {
+        std::array< glm::vec4, 3 > const in{ { a, b, c } };
+        std::array< glm::vec4, 4 > out;
+        int numOut = 0;
+
+        for ( int i = 0; i < 3; ++i )
+        {
+            glm::vec4 const & p = in[ i ];
+            glm::vec4 const & q = in[ ( i + 1 ) % 3 ];
+
+            float const dp = p.z + p.w;
+            float const dq = q.z + q.w;
+
+            if ( dp >= 0.0f )
+                out[ numOut++ ] = p;
+
+            if ( ( dp >= 0.0f ) != ( dq >= 0.0f ) )
+                out[ numOut++ ] = p + ( q - p ) * ( dp / ( dp - dq ) );
+        }
+
+        for ( int i = 2; i < numOut; ++i )
+            addTriangle( out[ 0 ], out[ i - 1 ], out[ i ] );
+    }
+
+    /// @brief Rasterizes the part of tri in the rows [y0, y1), sampling at pixel centers
+    ///        and keeping the nearest depth.
+    void
+    rasterizeTriangle( Triangle const & tri, int y0, int y1 )
+    {
+        glm::vec3 const & v0 = tri.V[ 0 ];
+        glm::vec3 const & v1 = tri.V[ 1 ];
+        glm::vec3 const & v2 = tri.V[ 2 ];
+
+        float const fMinX = std::min( { v0.x, v1.x, v2.x } );
+        float const fMaxX = std::max( { v0.x, v1.x, v2.x } );
+        float const fMinY = std::min( { v0.y, v1.y, v2.y } );
+        float const fMaxY = std::max( { v0.y, v1.y, v2.y } );
+
+        if ( fMaxY < y0 || fMinY > y1 || fMaxX < 0.0f || fMinX > m_Width )
+            return;
+
+        // starts at a multiple of four, rows are a multiple of TileSize wide
+        int const minX = static_cast< int >( std::max( fMinX, 0.0f ) ) & ~3;
+        int const maxX = std::min( static_cast< int >( std::min( fMaxX, static_cast< float >( m_Width ) ) ) + 1, m_Width );
+        int const minY = std::max( static_cast< int >( std::max( fMinY, 0.0f ) ), y0 );
+        int const maxY = std::min( static_cast< int >( std::min( fMaxY, static_cast< float >( y1 ) ) ) + 1, y1 );
+
+        // edge functions e( x, y ) = A x + B y + C, positive inside
+        float const a0 = v1.y - v2.y, b0 = v2.x - v1.x, c0 = v1.x * v2.y - v2.x * v1.y;
+        float const a1 = v2.y - v0.y, b1 = v0.x - v2.x, c1 = v2.x * v0.y - v0.x * v2.y;
+        float const a2 = v0.y - v1.y, b2 = v1.x - v0.x, c2 = v0.x * v1.y - v1.x * v0.y;
+
+        // depth plane from the barycentric weights e_i / area
+        float const invArea = 1.0f / ( c0 + c1 + c2 );
+        float const za = ( a0 * v0.z + a1 * v1.z + a2 * v2.z ) * invArea;
+        float const zb = ( b0 * v0.z + b1 * v1.z + b2 * v2.z ) * invArea;
+        float const zc = ( c0 * v0.z + c1 * v1.z + c2 * v2.z ) * invArea;
+
+#if defined( __SSE2__ )
+        __m128 const laneX = _mm_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f );
+        __m128 const zero = _mm_setzero_ps();
+
+        for ( int y = minY; y < maxY; ++y )
+        {
+            float const py = y + 0.5f;
+            float * row = &m_Depth[ static_cast< size_t >( y ) * m_Width ];
+
+            __m128 const rowE0 = _mm_set1_ps( b0 * py + c0 );
+            __m128 const rowE1 = _mm_set1_ps( b1 * py + c1 );
+            __m128 const rowE2 = _mm_set1_ps( b2 * py + c2 );
+            __m128 const rowZ = _mm_set1_ps( zb * py + zc );
+
+            for ( int x = minX; x < maxX; x += 4 )
+            {
+                __m128 const px = _mm_add_ps( _mm_set1_ps( static_cast< float >( x ) ), laneX );
+
+                __m128 const e0 = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( a0 ), px ), rowE0 );
+                __m128 const e1 = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( a1 ), px ), rowE1 );
+                __m128 const e2 = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( a2 ), px ), rowE2 );
+
+                __m128 const inside = _mm_and_ps( _mm_and_ps( _mm_cmpge_ps( e0, zero ), _mm_cmpge_ps( e1, zero ) ), _mm_cmpge_ps( e2, zero ) );
+
+                if ( _mm_movemask_ps( inside ) == 0 )
+                    continue;
+
+                __m128 const z = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( za ), px ), rowZ );
+                __m128 const depth = _mm_loadu_ps( row + x );
+                __m128 const nearest = _mm_min_ps( depth, z );
+
+                _mm_storeu_ps( row + x, _mm_or_ps( _mm_and_ps( inside, nearest ), _mm_andnot_ps( inside, depth ) ) );
+            }
+        }
+#else
+        for ( int y = minY; y < maxY; ++y )
+        {
+            float const py = y + 0.5f;
+            float * row = &m_Depth[ static_cast< size_t >( y ) * m_Width ];
+
+            for ( int x = minX; x < maxX; ++x )
+            {
+                float const px = x + 0.5f;
+
+                if ( a0 * px + b0 * py + c0 < 0.0f || a1 * px + b1 * py + c1 < 0.0f || a2 * px + b2 * py + c2 < 0.0f )
+                    continue;
+
+                row[ x ] = std::min( row[ x ], za * px + zb * py + zc );
+            }
+        }
+#endif
+    }
+
+    /// @brief Recomputes the farthest depth of the tiles in the rows [y0, y1).
+    void
+    updateTiles( int y0, int y1 )
+    {
+        int const numTilesX = getNumTilesX();
+
+        for ( int ty = y0 / TileSize; ty < y1 / TileSize; ++ty )
+        {
+            for ( int tx = 0; tx < numTilesX; ++tx )
+            {
+                float farthest = 0.0f;
+
+                for ( int y = ty * TileSize; y < ( ty + 1 ) * TileSize; ++y )
+                {
+                    float const * row = &m_Depth[ static_cast< size_t >( y ) * m_Width + tx * TileSize ];
+
+                    for ( int x = 0; x < TileSize; ++x )
+                        farthest = std::max( farthest, row[ x ] );
+                }
+
+                m_TileMax[ ty * numTilesX + tx ] = farthest;
+            }
+        }
+    }
+
+    int m_Width = 0;
+    int m_Height = 0;
+
+    std::vector< float > m_Depth;
+    std::vector< float > m_TileMax;
+
+    std::vector< Triangle > m_Triangles;
+
+    /// @brief Indices of the triangles touching each band of rows.
+    std::vector< std::vector< uint32_t > > m_Bands;
+
+    /// @brief Scratch space of addOccluder().
+    std::vector< glm::vec4 > m_Clip;
+};
+
+} // - namespace scene
+} // - namespace noo
+
+
+#endif /* NOO_SCENE_OCCLUSIONCULLER_HPP_INCLUDED_ */
@@ -0,0 +1,33 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: PointLight.hpp                                                   ///
+/// @brief: An omni-directional light with a finite radius of influence.    ///
+///                                                                         ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_SCENE_POINTLIGHT_HPP_INCLUDED_
+#define NOO_SCENE_POINTLIGHT_HPP_INCLUDED_
+
+
+/// Includes
+#include "glm/glm.hpp"
+
+
+namespace noo {
+namespace scene {
+
+struct PointLight
+{
+    glm::vec3 Position;
+    glm::vec3 Color;
+
+    /// @brief Distance at which the attenuation reaches zero.
+    float Radius;
+};
+
+} // - namespace scene
+} // - namespace noo
+
+
+#endif /* NOO_SCENE_POINTLIGHT_HPP_INCLUDED_ */
@@ -0,0 +1,466 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: Scene.hpp                                                        ///
+/// @brief: Container of placed model instances. A bounding volume          ///
+///         hierarchy over their world bounds answers visibility, overlap   ///
+///         and ray queries without touching every instance.                ///
+///                                                                         ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_SCENE_SCENE_HPP_INCLUDED_
+#define NOO_SCENE_SCENE_HPP_INCLUDED_
+
+
+/// Includes
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Model.hpp"
+#include "OcclusionCuller.hpp"
+#include "LodView.hpp"
+#include "TransformHierarchy.hpp"
+#include "../renderer/Renderer.hpp"
+#include "../geometry/BVH.hpp"
+#include "../geometry/Bounds.hpp"
+#include "../geometry/Frustum.hpp"
+#include "../common/ThreadPool.hpp"
+
+
+namespace noo {
+namespace scene {
+
+class Scene
+{
+public:
+
+    using InstanceId = uint32_t;
+
+    struct Instance
+    {
+        Model * Source = nullptr;
+        glm::mat4 Transform = glm::mat4( 1 );
+
+        /// @brief Bounds of the model after Transform.
+        geometry::AABB WorldBounds;
+
+        /// @brief Rasterized into the occlusion buffer by occlusionCull().
+        bool Occluder = false;
+
+        /// @brief Node the transform follows in updateTransforms(), if any.
+        TransformHierarchy::NodeId Node = TransformHierarchy::NoNode;
+    };
+
+    /// @brief Instances tested by one worker task in occlusionCull().
+    static constexpr size_t OcclusionGrainSize = 64;
+
+    /// @brief Instances moved by one worker task in updateTransforms().
+    static constexpr size_t TransformGrainSize = 1024;
+
+    /// @brief Places model in the scene, the model has to outlive the scene.
+    InstanceId
+    addInstance( Model & model, glm::mat4 const & transform = glm::mat4( 1 ) )
+    {
+        m_Instances.emplace_back();
+        Instance & inst = m_Instances.back();
+        inst.Source = &model;
+        inst.Transform = transform;
+        inst.WorldBounds = computeWorldBounds( model, transform );
+
+        m_NeedsRebuild = true;
+
+        return static_cast< InstanceId >( m_Instances.size() - 1 );
+    }
+
+    /// @brief Moves an instance, the hierarchy is refit with the next update().
+    void
+    setTransform( InstanceId id, glm::mat4 const & transform )
+    {
+        Instance & inst = m_Instances[ id ];
+        inst.Transform = transform;
+        inst.WorldBounds = computeWorldBounds( *inst.Source, transform );
+
+        if ( ! m_NeedsRebuild )
+        {
+            m_Bvh.update( id, inst.WorldBounds );
+            m_NeedsRefit = true;
+        }
+    }
+
+    /// @brief Lets the instance follow the world matrix of a node, see updateTransforms().
+    ///        It takes the current world matrix of the node right away.
+    void
+    setNode( InstanceId id, TransformHierarchy::NodeId node, TransformHierarchy const & hierarchy )
+    { setNode( id, node, hierarchy.getWorld( node ) ); }
+
+    /// @brief As above for a hierarchy owned by another thread, world is the
+    ///        current world matrix of the node.
+    void
+    setNode( InstanceId id, TransformHierarchy::NodeId node, glm::mat4 const & world )
+    {
+        Instance & inst = m_Instances[ id ];
+
+        if ( inst.Node != TransformHierarchy::NoNode )
+        {
+            auto & attached = m_NodeInstances[ inst.Node ];
+            attached.erase( std::find( attached.begin(), attached.end(), id ) );
+        }
+
+        inst.Node = node;
+
+        if ( node != TransformHierarchy::NoNode )
+        {
+            if ( node >= m_NodeInstances.size() )
+                m_NodeInstances.resize( node + 1 );
+
+            m_NodeInstances[ node ].push_back( id );
+        }
+
+        setTransform( id, world );
+    }
+
+    /// @brief Takes over the world matrices that changed with the last update()
+    ///        of hierarchy into the instances attached to their nodes. The world
+    ///        bounds are transformed in parallel if pool is given.
+    /// @return The number of instances moved.
+    size_t
+    updateTransforms( TransformHierarchy const & hierarchy, common::ThreadPool * pool = nullptr )
+    {
+        std::vector< uint8_t > moved( m_Instances.size(), 0 );
+
+        auto moveRange = [ this, &hierarchy, &moved ]( size_t begin, size_t end )
+        {
+            for ( size_t i = begin; i < end; ++i )
+            {
+                Instance & inst = m_Instances[ i ];
+
+                if ( inst.Node == TransformHierarchy::NoNode || ! hierarchy.hasChanged( inst.Node ) )
+                    continue;
+
+                inst.Transform = hierarchy.getWorld( inst.Node );
+                inst.WorldBounds = computeWorldBounds( *inst.Source, inst.Transform );
+                moved[ i ] = 1;
+            }
+        };
+
+        if ( pool == nullptr )
+            moveRange( 0, m_Instances.size() );
+        else
+            pool->parallelFor( m_Instances.size(), TransformGrainSize, moveRange );
+
+        size_t numMoved = 0;
+
+        for ( size_t i = 0; i < m_Instances.size(); ++i )
+        {
+            if ( ! moved[ i ] )
+                continue;
+
+            if ( ! m_NeedsRebuild )
+                m_Bvh.update( static_cast< uint32_t >( i ), m_Instances[ i ].WorldBounds );
+
+            ++numMoved;
+        }
+
+        m_NeedsRefit |= numMoved > 0;
+
+        return numMoved;
+    }
+
+    /// @brief Takes over the changed world matrices of a hierarchy owned by
+    ///        another thread, see TransformHierarchy::getChanged(). Only the
+    ///        instances attached to the given nodes are visited.
+    /// @return The number of instances moved.
+    size_t
+    updateTransforms( std::vector< TransformHierarchy::NodeWorld > const & changed, common::ThreadPool * pool = nullptr )
+    {
+        // a node is listed once, so every instance is written by one task only
+        auto moveRange = [ this, &changed ]( size_t begin, size_t end )
+        {
+            for ( size_t i = begin; i < end; ++i )
+            {
+                if ( changed[ i ].Node >= m_NodeInstances.size() )
+                    continue;
+
+                for ( InstanceId id : m_NodeInstances[ changed[ i ].Node ] )
+                {
+                    Instance & inst = m_Instances[ id ];
+                    inst.Transform = changed[ i ].World;
+                    inst.WorldBounds = computeWorldBounds( *inst.Source, inst.Transform );
+                }
+            }
+        };
+
+        if ( pool == nullptr )
+            moveRange( 0, changed.size() );
+        else
+            pool->parallelFor( changed.size(), TransformGrainSize, moveRange );
+
+        size_t numMoved = 0;
+
+        for ( auto const & c : changed )
+        {
+            if ( c.Node >= m_NodeInstances.size() )
+                continue;
+
+            for ( InstanceId id : m_NodeInstances[ c.Node ] )
+            {
+                if ( ! m_NeedsRebuild )
+                    m_Bvh.update( id, m_Instances[ id ].WorldBounds );
+
+                ++numMoved;
+            }
+        }
+
+        m_NeedsRefit |= numMoved > 0;
+
+        return numMoved;
+    }
+
+    /// @brief Occluders should be few, large and low in triangles, e.g. terrain or buildings.
+    void
+    setOccluder( InstanceId id, bool occluder )
+    { m_Instances[ id ].Occluder = occluder; }
+
+    /// @brief The view levels of detail are selected for by draw() and drawDepth().
+    ///        The default view selects the full detail.
+    void
+    setLodView( LodView const & view )
+    { m_LodView = view; }
+
+    Instance const &
+    getInstance( InstanceId id ) const
+    { return m_Instances[ id ]; }
+
+    size_t
+    getNumInstances() const
+    { return m_Instances.size(); }
+
+    /// @brief Brings the hierarchy up to date. Added instances cause a full SAH
+    ///        build, moved ones only a refit. Call rebuild() after instances
+    ///        moved far, a refit tree gets looser the more they do.
+    void
+    update()
+    {
+        if ( m_NeedsRebuild )
+        {
+            rebuild();
+        }
+        else if ( m_NeedsRefit )
+        {
+            m_Bvh.refit();
+            m_NeedsRefit = false;
+        }
+    }
+
+    void
+    rebuild()
+    {
+        std::vector< geometry::AABB > boxes;
+        boxes.reserve( m_Instances.size() );
+
+        for ( auto const & inst : m_Instances )
+            boxes.push_back( inst.WorldBounds );
+
+        m_Bvh.build( boxes );
+
+        m_NeedsRebuild = false;
+        m_NeedsRefit = false;
+    }
+
+    /// @brief Collects the instances whose world bounds intersect the frustum.
+    /// @return The number of visible instances.
+    size_t
+    cull( geometry::Frustum const & frustum, std::vector< InstanceId > & outVisible ) const
+    {
+        outVisible.clear();
+        m_Bvh.queryFrustum( frustum, [ &outVisible ]( uint32_t prim ) { outVisible.push_back( prim ); } );
+
+        return outVisible.size();
+    }
+
+    /// @brief Rasterizes the visible occluders and removes the instances hidden
+    ///        behind them from visible. occlusion keeps the occluder depth, so it
+    ///        can be passed on to draw() to test the single meshes as well.
+    /// @return The number of instances removed.
+    size_t
+    occlusionCull( OcclusionCuller & occlusion, glm::mat4 const & viewProj, std::vector< InstanceId > & visible, common::ThreadPool * pool = nullptr ) const
+    {
+        occlusion.begin();
+
+        for ( InstanceId id : visible )
+        {
+            Instance const & inst = m_Instances[ id ];
+
+            if ( inst.Occluder )
+                inst.Source->addOccluders( occlusion, viewProj * inst.Transform );
+        }
+
+        occlusion.rasterize( pool );
+
+        // world bounds are tested with viewProj alone
+        std::vector< uint8_t > hidden( visible.size(), 0 );
+
+        auto testRange = [ this, &occlusion, &viewProj, &visible, &hidden ]( size_t begin, size_t end )
+        {
+            for ( size_t i = begin; i < end; ++i )
+                hidden[ i ] = occlusion.isOccluded( m_Instances[ visible[ i ] ].WorldBounds, viewProj ) ? 1 : 0;
+        };
+
+        if ( pool == nullptr )
+            testRange( 0, visible.size() );
+        else
+            pool->parallelFor( visible.size(), OcclusionGrainSize, testRange );
+
+        size_t numKept = 0;
+
+        for ( size_t i = 0; i < visible.size(); ++i )
+        {
+            if ( ! hidden[ i ] )
+                visible[ numKept++ ] = visible[ i ];
+        }
+
+        size_t const numHidden = visible.size() - numKept;
+        visible.resize( numKept );
+
+        return numHidden;
+    }
+
+    /// @brief Calls fn( id ) for every instance whose world bounds overlap the box.
+    template< class F >
+    void
+    queryOverlap( geometry::AABB const & box, F && fn ) const
+    { m_Bvh.queryOverlap( box, fn ); }
+
+    /// @brief Calls fn( id ) for every instance whose world bounds overlap the sphere.
+    template< class F >
+    void
+    queryOverlap( geometry::BoundingSphere const & sphere, F && fn ) const
+    { m_Bvh.queryOverlap( sphere, fn ); }
+
+    /// @brief Finds the closest instance whose world bounds are hit by the ray.
+    /// @return The instance or -1, tMax is set to the distance of the hit.
+    int64_t
+    raycast( glm::vec3 const & origin, glm::vec3 const & dir, float & tMax ) const
+    {
+        glm::vec3 const invDir( 1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z );
+
+        return m_Bvh.raycast( origin, dir, tMax, [ this, &origin, &invDir ]( uint32_t prim, float tm )
+        {
+            return geometry::BVH::slabTest( m_Instances[ prim ].WorldBounds, origin, invDir, tm );
+        } );
+    }
+
+    /// @brief Draws the given instances, each culled per mesh in its local space,
+    ///        and against occlusion if given (see occlusionCull()).
+    ///        Sets u_mvp, u_model and u_mat_rot of shd, the model sets u_color.
+    /// @return The number of meshes drawn.
+    size_t
+    draw( renderer::Renderer & renderer, renderer::RenderTarget const & rt, renderer::Shader::Data & shd, renderer::state::StateSet const & state
+        , glm::mat4 const & viewProj, std::vector< InstanceId > const & instances, common::ThreadPool * pool = nullptr
+        , OcclusionCuller const * occlusion = nullptr )
+    {
+        size_t numDrawn = 0;
+        m_NumOccludedMeshes = 0;
+
+        for ( InstanceId id : instances )
+        {
+            Instance & inst = m_Instances[ id ];
+            glm::mat4 const mvp = viewProj * inst.Transform;
+
+            numDrawn += cullMeshes( inst, mvp, pool, occlusion );
+            inst.Source->selectLods( m_LodView, inst.Transform );
+
+            shd[ "u_mvp" ] = mvp;
+            shd[ "u_model" ] = inst.Transform;
+            shd[ "u_mat_rot" ] = glm::transpose( glm::inverse( glm::mat3( inst.Transform ) ) );
+
+            inst.Source->draw( renderer, rt, shd, state );
+        }
+
+        return numDrawn;
+    }
+
+    /// @brief Depth only version of draw(), only u_mvp of shd is set.
+    size_t
+    drawDepth( renderer::Renderer & renderer, renderer::RenderTarget const & rt, renderer::Shader::Data & shd, renderer::state::StateSet const & state
+             , glm::mat4 const & viewProj, std::vector< InstanceId > const & instances, common::ThreadPool * pool = nullptr
+             , OcclusionCuller const * occlusion = nullptr )
+    {
+        size_t numDrawn = 0;
+        m_NumOccludedMeshes = 0;
+
+        for ( InstanceId id : instances )
+        {
+            Instance & inst = m_Instances[ id ];
+            glm::mat4 const mvp = viewProj * inst.Transform;
+
+            numDrawn += cullMeshes( inst, mvp, pool, occlusion );
+            inst.Source->selectLods( m_LodView, inst.Transform );
+
+            shd[ "u_mvp" ] = mvp;
+
+            inst.Source->drawDepth( renderer, rt, shd, state );
+        }
+
+        return numDrawn;
+    }
+
+    /// @brief Meshes hidden by occlusion during the last draw() or drawDepth().
+    size_t
+    getNumOccludedMeshes() const
+    { return m_NumOccludedMeshes; }
+
+private:
+
+    /// @return The number of visible meshes of the instance.
+    size_t
+    cullMeshes( Instance & inst, glm::mat4 const & mvp, common::ThreadPool * pool, OcclusionCuller const * occlusion )
+    {
+        size_t numVisible = inst.Source->cull( geometry::Frustum::fromMatrix( mvp ), pool );
+
+        if ( occlusion != nullptr )
+        {
+            size_t const numOccluded = inst.Source->cullOccluded( *occlusion, mvp );
+            m_NumOccludedMeshes += numOccluded;
+            numVisible -= numOccluded;
+        }
+
+        return numVisible;
+    }
+
+    /// @brief Models without geometry get a point box, so the hierarchy stays valid.
+    static geometry::AABB
+    computeWorldBounds( Model const & model, glm::mat4 const & transform )
+    {
+        if ( model.getBounds().isEmpty() )
+        {
+            glm::vec3 const origin( transform[ 3 ] );
+            return geometry::AABB( origin, origin );
+        }
+
+        return model.getBounds().transformed( transform );
+    }
+
+    std::vector< Instance > m_Instances;
+
+    /// @brief Instances attached to each node, see setNode().
+    std::vector< std::vector< InstanceId > > m_NodeInstances;
+
+    geometry::BVH m_Bvh;
+
+    bool m_NeedsRebuild = false;
+    bool m_NeedsRefit = false;
+
+    size_t m_NumOccludedMeshes = 0;
+
+    LodView m_LodView;
+};
+
+} // - namespace scene
+} // - namespace noo
+
+
+#endif /* NOO_SCENE_SCENE_HPP_INCLUDED_ */
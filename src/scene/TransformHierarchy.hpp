@@ -0,0 +1,305 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: TransformHierarchy.hpp                                           ///
+/// @brief: Parent-child hierarchy of transforms. Nodes are stored as       ///
+///         structure of arrays sorted by depth, so one pass over the       ///
+///         levels finds every parent updated before its children. Only     ///
+///         nodes whose local transform or any ancestor changed get a new   ///
+///         world matrix, each level is spread over the thread pool.        ///
+///                                                                         ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NOO_SCENE_TRANSFORMHIERARCHY_HPP_INCLUDED_
+#define NOO_SCENE_TRANSFORMHIERARCHY_HPP_INCLUDED_
+
+
+/// Includes
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#if defined( __AVX__ ) || defined( __SSE2__ )
+#include <immintrin.h>
+#endif
+
+#include "glm/glm.hpp"
+
+#include "../common/ThreadPool.hpp"
+
+
+namespace noo {
+namespace scene {
+
+class TransformHierarchy
+{
+public:
+
+    using NodeId = uint32_t;
+
+    static constexpr NodeId NoNode = ~NodeId( 0 );
+
+    /// @brief World matrix of a node, as handed to another thread by getChanged().
+    struct NodeWorld
+    {
+        NodeId Node;
+        glm::mat4 World;
+    };
+
+    /// @brief Nodes of a level a single worker task updates.
+    static constexpr size_t GrainSize = 1024;
+
+    static_assert( sizeof( glm::mat4 ) == 16 * sizeof( float ), "The kernels expect 16 packed floats per matrix" );
+
+    /// @brief Adds a node below parent, or a root. Nodes are never removed.
+    NodeId
+    addNode( NodeId parent = NoNode, glm::mat4 const & local = glm::mat4( 1 ) )
+    {
+        assert( parent == NoNode || parent < m_NodeParent.size() );
+
+        NodeId const id = static_cast< NodeId >( m_NodeParent.size() );
+        uint32_t const depth = parent == NoNode ? 0 : m_NodeDepth[ parent ] + 1;
+        uint32_t const slot = static_cast< uint32_t >( m_Local.size() );
+
+        m_NodeParent.push_back( parent );
+        m_NodeDepth.push_back( depth );
+        m_NodeSlot.push_back( slot );
+
+        m_Local.push_back( local );
+        m_World.push_back( local );
+        m_ParentSlot.push_back( parent == NoNode ? NoNode : m_NodeSlot[ parent ] );
+        m_LocalDirty.push_back( 1 );
+        m_WorldChanged.push_back( 0 );
+        m_SlotNode.push_back( id );
+
+        // appending to the deepest level or a new one keeps the slots sorted
+        size_t const numLevels = m_LevelBegin.size() - 1;
+
+        if ( depth + 1 == numLevels )
+            m_LevelBegin.back() = m_Local.size();
+        else if ( depth == numLevels )
+            m_LevelBegin.push_back( m_Local.size() );
+        else
+            m_NeedsSort = true;
+
+        return id;
+    }
+
+    /// @brief The world matrix follows with the next update().
+    void
+    setLocal( NodeId id, glm::mat4 const & local )
+    {
+        uint32_t const slot = m_NodeSlot[ id ];
+        m_Local[ slot ] = local;
+        m_LocalDirty[ slot ] = 1;
+    }
+
+    glm::mat4 const &
+    getLocal( NodeId id ) const
+    { return m_Local[ m_NodeSlot[ id ] ]; }
+
+    /// @brief As of the last update().
+    glm::mat4 const &
+    getWorld( NodeId id ) const
+    { return m_World[ m_NodeSlot[ id ] ]; }
+
+    NodeId
+    getParent( NodeId id ) const
+    { return m_NodeParent[ id ]; }
+
+    /// @brief True if the world matrix changed with the last update().
+    bool
+    hasChanged( NodeId id ) const
+    { return m_WorldChanged[ m_NodeSlot[ id ] ] != 0; }
+
+    size_t
+    getNumNodes() const
+    { return m_NodeParent.size(); }
+
+    /// @brief Appends the nodes whose world matrix changed with the last update().
+    ///        New nodes count as changed, so the first call after update() yields all.
+    void
+    getChanged( std::vector< NodeWorld > & out ) const
+    {
+        for ( size_t s = 0; s < m_WorldChanged.size(); ++s )
+        {
+            if ( m_WorldChanged[ s ] )
+                out.push_back( NodeWorld{ m_SlotNode[ s ], m_World[ s ] } );
+        }
+    }
+
+    /// @brief Recomputes the world matrices of the changed subtrees, the levels
+    ///        one after another, each spread over pool if given.
+    void
+    update( common::ThreadPool * pool = nullptr )
+    {
+        if ( m_NeedsSort )
+            sortByDepth();
+
+        for ( size_t level = 0; level + 1 < m_LevelBegin.size(); ++level )
+        {
+            size_t const first = m_LevelBegin[ level ];
+            size_t const count = m_LevelBegin[ level + 1 ] - first;
+
+            auto updateRange = [ this, first ]( size_t begin, size_t end )
+            {
+                updateSlots( first + begin, first + end );
+            };
+
+            if ( pool == nullptr )
+                updateRange( 0, count );
+            else
+                pool->parallelFor( count, GrainSize, updateRange );
+        }
+    }
+
+    /// @brief out = a * b of column major matrices.
+    static void
+    multiply( glm::mat4 const & a, glm::mat4 const & b, glm::mat4 & out )
+    {
+        float const * pa = &a[ 0 ][ 0 ];
+        float const * pb = &b[ 0 ][ 0 ];
+        float * po = &out[ 0 ][ 0 ];
+
+#if defined( __AVX__ )
+        // each column of a twice, to compute two columns of out at once
+        __m256 const a0 = _mm256_broadcast_ps( reinterpret_cast< __m128 const * >( pa + 0 ) );
+        __m256 const a1 = _mm256_broadcast_ps( reinterpret_cast< __m128 const * >( pa + 4 ) );
+        __m256 const a2 = _mm256_broadcast_ps( reinterpret_cast< __m128 const * >( pa + 8 ) );
+        __m256 const a3 = _mm256_broadcast_ps( reinterpret_cast< __m128 const * >( pa + 12 ) );
+
+        for ( int j = 0; j < 4; j += 2 )
+        {
+            // columns j and j + 1 of b, every element splat over its half
+            __m256 const bj = _mm256_loadu_ps( pb + 4 * j );
+
+            __m256 r = _mm256_mul_ps( a0, _mm256_permute_ps( bj, 0x00 ) );
+            r = _mm256_add_ps( r, _mm256_mul_ps( a1, _mm256_permute_ps( bj, 0x55 ) ) );
+            r = _mm256_add_ps( r, _mm256_mul_ps( a2, _mm256_permute_ps( bj, 0xaa ) ) );
+            r = _mm256_add_ps( r, _mm256_mul_ps( a3, _mm256_permute_ps( bj, 0xff ) ) );
+
+            _mm256_storeu_ps( po + 4 * j, r );
+        }
+#elif defined( __SSE2__ )
+        __m128 const a0 = _mm_loadu_ps( pa + 0 );
+        __m128 const a1 = _mm_loadu_ps( pa + 4 );
+        __m128 const a2 = _mm_loadu_ps( pa + 8 );
+        __m128 const a3 = _mm_loadu_ps( pa + 12 );
+
+        for ( int j = 0; j < 4; ++j )
+        {
+            __m128 r = _mm_mul_ps( a0, _mm_set1_ps( pb[ 4 * j + 0 ] ) );
+            r = _mm_add_ps( r, _mm_mul_ps( a1, _mm_set1_ps( pb[ 4 * j + 1 ] ) ) );
+            r = _mm_add_ps( r, _mm_mul_ps( a2, _mm_set1_ps( pb[ 4 * j + 2 ] ) ) );
+            r = _mm_add_ps( r, _mm_mul_ps( a3, _mm_set1_ps( pb[ 4 * j + 3 ] ) ) );
+
+            _mm_storeu_ps( po + 4 * j, r );
+        }
+#else
+        out = a * b;
+#endif
+    }
+
+private:
+
+    void
+    updateSlots( size_t begin, size_t end )
+    {
+        for ( size_t s = begin; s < end; ++s )
+        {
+            uint32_t const parent = m_ParentSlot[ s ];
+
+            // parents are on the level before, updated already
+            bool const changed = m_LocalDirty[ s ] || ( parent != NoNode && m_WorldChanged[ parent ] );
+
+            m_WorldChanged[ s ] = changed ? 1 : 0;
+            m_LocalDirty[ s ] = 0;
+
+            if ( ! changed )
+                continue;
+
+            if ( parent == NoNode )
+                m_World[ s ] = m_Local[ s ];
+            else
+                multiply( m_World[ parent ], m_Local[ s ], m_World[ s ] );
+        }
+    }
+
+    /// @brief Stable counting sort of the slots by node depth.
+    void
+    sortByDepth()
+    {
+        size_t const numNodes = m_NodeParent.size();
+        uint32_t maxDepth = 0;
+
+        for ( uint32_t d : m_NodeDepth )
+            maxDepth = std::max( maxDepth, d );
+
+        m_LevelBegin.assign( maxDepth + 2, 0 );
+
+        for ( uint32_t d : m_NodeDepth )
+            ++m_LevelBegin[ d + 1 ];
+
+        for ( size_t l = 1; l < m_LevelBegin.size(); ++l )
+            m_LevelBegin[ l ] += m_LevelBegin[ l - 1 ];
+
+        std::vector< size_t > next( m_LevelBegin.begin(), m_LevelBegin.end() - 1 );
+
+        // ids are in creation order, parents come first
+        for ( NodeId id = 0; id < numNodes; ++id )
+            m_NodeSlot[ id ] = static_cast< uint32_t >( next[ m_NodeDepth[ id ] ]++ );
+
+        std::vector< glm::mat4 > local( numNodes ), world( numNodes );
+        std::vector< uint8_t > dirty( numNodes ), changed( numNodes );
+
+        for ( size_t s = 0; s < numNodes; ++s )
+        {
+            uint32_t const to = m_NodeSlot[ m_SlotNode[ s ] ];
+
+            local[ to ] = m_Local[ s ];
+            world[ to ] = m_World[ s ];
+            dirty[ to ] = m_LocalDirty[ s ];
+            changed[ to ] = m_WorldChanged[ s ];
+        }
+
+        m_Local.swap( local );
+        m_World.swap( world );
+        m_LocalDirty.swap( dirty );
+        m_WorldChanged.swap( changed );
+
+        for ( NodeId id = 0; id < numNodes; ++id )
+        {
+            uint32_t const slot = m_NodeSlot[ id ];
+
+            m_SlotNode[ slot ] = id;
+            m_ParentSlot[ slot ] = m_NodeParent[ id ] == NoNode ? NoNode : m_NodeSlot[ m_NodeParent[ id ] ];
+        }
+
+        m_NeedsSort = false;
+    }
+
+    /// @brief Per node id.
+    std::vector< NodeId > m_NodeParent;
+    std::vector< uint32_t > m_NodeDepth;
+    std::vector< uint32_t > m_NodeSlot;
+
+    /// @brief Per slot, sorted by depth.
+    std::vector< glm::mat4 > m_Local;
+    std::vector< glm::mat4 > m_World;
+    std::vector< uint32_t > m_ParentSlot;
+    std::vector< uint8_t > m_LocalDirty;
+    std::vector< uint8_t > m_WorldChanged;
+    std::vector< NodeId > m_SlotNode;
+
+    /// @brief First slot of every level, followed by the number of slots.
+    std::vector< size_t > m_LevelBegin = { 0 };
+
+    bool m_NeedsSort = false;
+};
+
+} // - namespace scene
+} // - namespace noo
+
+
+#endif /* NOO_SCENE_TRANSFORMHIERARCHY_HPP_INCLUDED_ */
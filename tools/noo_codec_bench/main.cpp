@@ -0,0 +1,187 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: main.cpp                                                         ///
+/// @brief: Compression ratio and decode throughput of geometry::MeshCodec  ///
+///         on the streams of an uncompressed cooked model, or on a         ///
+///         generated sphere if no file is given.                           ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+/// Includes
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/MappedFile.hpp"
+#include "common/ThreadPool.hpp"
+#include "geometry/GeometryUtils.hpp"
+#include "geometry/MeshCodec.hpp"
+#include "renderer/VertexPacking.hpp"
+#include "scene/CookedModel.hpp"
+
+
+namespace {
+
+int const NumRuns = 10;
+
+struct Stream
+{
+    std::string Name;
+    std::vector< uint8_t > Data;
+
+    /// @brief 0 for indices.
+    size_t Stride;
+};
+
+template< class F >
+double
+bestSeconds( F && fn )
+{
+    double best = 1e30;
+
+    for ( int r = 0; r < NumRuns; ++r )
+    {
+        auto const start = std::chrono::steady_clock::now();
+        fn();
+        best = std::min( best, std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count() );
+    }
+
+    return best;
+}
+
+bool
+bench( Stream const & s, noo::common::ThreadPool & pool )
+{
+    using noo::geometry::MeshCodec;
+
+    size_t const count = s.Stride == 0 ? s.Data.size() / sizeof( uint32_t ) : s.Data.size() / s.Stride;
+
+    std::vector< uint8_t > encoded;
+
+    double const encodeSeconds = bestSeconds( [ & ]
+    {
+        encoded = s.Stride == 0 ? MeshCodec::encodeIndices( reinterpret_cast< uint32_t const * >( s.Data.data() ), count )
+                                : MeshCodec::encodeVertices( s.Data.data(), count, s.Stride );
+    } );
+
+    std::vector< uint8_t > decoded( s.Data.size() );
+    bool ok = true;
+
+    auto decode = [ & ]( noo::common::ThreadPool * p )
+    {
+        return bestSeconds( [ & ]
+        {
+            ok &= s.Stride == 0 ? MeshCodec::decodeIndices( reinterpret_cast< uint32_t * >( decoded.data() ), count, encoded.data(), encoded.size(), p )
+                                : MeshCodec::decodeVertices( decoded.data(), count, s.Stride, encoded.data(), encoded.size(), p );
+        } );
+    };
+
+    double const serialSeconds = decode( nullptr );
+    double const parallelSeconds = decode( &pool );
+
+    ok &= decoded == s.Data;
+
+    double const mb = s.Data.size() / 1.0e6;
+
+    std::cout << std::fixed << std::setprecision( 2 )
+              << std::setw( 10 ) << s.Name
+              << std::setw( 10 ) << mb << " MB"
+              << std::setw( 8 ) << double( s.Data.size() ) / encoded.size() << "x"
+              << std::setw( 10 ) << mb / encodeSeconds << " MB/s enc"
+              << std::setw( 10 ) << mb / serialSeconds << " MB/s dec"
+              << std::setw( 10 ) << mb / parallelSeconds << " MB/s dec x" << pool.getNumThreads() + 1
+              << ( ok ? "" : "  MISMATCH" ) << std::endl;
+
+    return ok;
+}
+
+bool
+loadCooked( std::string const & filename, std::vector< Stream > & streams )
+{
+    namespace cooked = noo::scene::cooked;
+
+    noo::common::MappedFile file;
+
+    if ( ! file.open( filename ) || file.getSize() < sizeof( cooked::Header ) )
+        return false;
+
+    cooked::Header header;
+    std::memcpy( &header, file.getData(), sizeof( header ) );
+
+    if ( header.Magic != cooked::Magic || header.Version != cooked::Version || ( header.Flags & cooked::FlagCompressed ) )
+        return false;
+
+    auto blob = [ &file ]( cooked::Blob const & b )
+    {
+        return std::vector< uint8_t >( file.getData() + b.Offset, file.getData() + b.Offset + b.Size );
+    };
+
+    for ( cooked::Blob const * b : { &header.Positions, &header.Normals, &header.Indices } )
+    {
+        if ( ! cooked::isInside( *b, file.getSize() ) )
+            return false;
+    }
+
+    streams.push_back( { "positions", blob( header.Positions ), noo::renderer::Vertex_PosQ4::SizeInBytes } );
+    streams.push_back( { "normals", blob( header.Normals ), noo::renderer::Vertex_NrmOct::SizeInBytes } );
+    streams.push_back( { "indices", blob( header.Indices ), 0 } );
+
+    return true;
+}
+
+void
+generateSphere( std::vector< Stream > & streams )
+{
+    std::vector< glm::vec3 > positions, normals;
+    std::vector< uint32_t > indices;
+    noo::geometry::GeometryUtils::createSphere( 1024, 512, positions, indices );
+
+    for ( auto const & p : positions )
+        normals.push_back( glm::normalize( p ) );
+
+    std::vector< noo::renderer::Vertex_PosQ4 > qp;
+    std::vector< noo::renderer::Vertex_NrmOct > qn;
+    noo::renderer::VertexPacking::packMesh( positions, normals, qp, qn );
+
+    auto bytes = []( auto const & v )
+    {
+        auto const * p = reinterpret_cast< uint8_t const * >( v.data() );
+        return std::vector< uint8_t >( p, p + sizeof( v[ 0 ] ) * v.size() );
+    };
+
+    streams.push_back( { "positions", bytes( qp ), noo::renderer::Vertex_PosQ4::SizeInBytes } );
+    streams.push_back( { "normals", bytes( qn ), noo::renderer::Vertex_NrmOct::SizeInBytes } );
+    streams.push_back( { "indices", bytes( indices ), 0 } );
+}
+
+} // - namespace
+
+
+int main( int argc, char ** argv )
+{
+    std::vector< Stream > streams;
+
+    if ( argc > 1 )
+    {
+        if ( ! loadCooked( argv[ 1 ], streams ) )
+        {
+            std::cerr << "Usage: noo_codec_bench [<uncompressed cooked file>]" << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        generateSphere( streams );
+    }
+
+    noo::common::ThreadPool pool;
+    bool ok = true;
+
+    for ( auto const & s : streams )
+        ok &= bench( s, pool );
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: main.cpp                                                         ///
+/// @brief: Runs the model import offline and writes the result as a       ///
+///         cooked file that Model::createFromCooked() maps at startup.     ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+/// Includes
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "scene/Model.hpp"
+#include "common/ThreadPool.hpp"
+
+
+int main( int argc, char ** argv )
+{
+    bool compress = false;
+    bool analyzeOverdraw = false;
+    int firstArg = 1;
+
+    for ( ; firstArg < argc && argv[ firstArg ][ 0 ] == '-'; ++firstArg )
+    {
+        std::string const option = argv[ firstArg ];
+
+        if ( option == "--compress" )
+            compress = true;
+        else if ( option == "--overdraw" )
+            analyzeOverdraw = true;
+        else
+            break;
+    }
+
+    if ( argc <= firstArg || argv[ firstArg ][ 0 ] == '-' )
+    {
+        std::cerr << "Usage: noo_cook [--compress] [--overdraw] <model file> [<cooked file>]" << std::endl;
+        std::cerr << "       The cooked file defaults to <model file>.noom" << std::endl;
+        std::cerr << "       --overdraw logs the overdraw before and after optimizing, which is slow" << std::endl;
+        return 1;
+    }
+
+    std::string const input = argv[ firstArg ];
+    std::string const output = argc > firstArg + 1 ? argv[ firstArg + 1 ] : input + ".noom";
+
+    auto const start = std::chrono::steady_clock::now();
+
+    noo::common::ThreadPool workers;
+    noo::scene::Model model;
+
+    if ( ! noo::scene::Model::createFromFile( input, model, &workers, analyzeOverdraw ) )
+    {
+        std::cerr << "Could not import " << input << std::endl;
+        return 1;
+    }
+
+    if ( ! model.saveCooked( output, compress ) )
+    {
+        std::cerr << "Could not write " << output << std::endl;
+        return 1;
+    }
+
+    auto const ms = std::chrono::duration_cast< std::chrono::milliseconds >( std::chrono::steady_clock::now() - start ).count();
+
+    std::cout << "Cooked " << input << " into " << output << " in " << ms << " ms" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,222 @@
+///////////////////////////////////////////////////////////////////////////////
+/// @file: main.cpp                                                         ///
+/// @brief: Decodes the binary telemetry written by logging::EventLog.      ///
+///         Lists the events of a file, or writes their records as CSV or   ///
+///         as one JSON object per line.                                    ///
+/// @author: Ben Schneider                                                  ///
+///////////////////////////////////////////////////////////////////////////////
+
+
+/// Includes
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/MappedFile.hpp"
+#include "logging/EventLog.hpp"
+
+
+namespace {
+
+namespace el = noo::logging::eventlog;
+
+struct TelemetryFile
+{
+    el::FileHeader Header;
+    std::vector< el::EventDefinition > Events;
+
+    el::Record const * Records = nullptr;
+    size_t NumRecords = 0;
+};
+
+bool
+readTelemetry( noo::common::MappedFile const & file, TelemetryFile & out )
+{
+    if ( file.getSize() < el::HeaderSize )
+        return false;
+
+    std::memcpy( &out.Header, file.getData(), sizeof( out.Header ) );
+
+    // the records are read up to the end of the file, the header must not point past it
+    if ( std::memcmp( out.Header.Magic, el::Magic, sizeof( el::Magic ) ) != 0 || out.Header.Version != el::Version
+      || out.Header.RecordSize != sizeof( el::Record ) || out.Header.HeaderSize != el::HeaderSize || out.Header.NumEvents > el::MaxEvents )
+        return false;
+
+    out.Events.resize( out.Header.NumEvents );
+    std::memcpy( out.Events.data(), file.getData() + sizeof( el::FileHeader ), out.Events.size() * sizeof( el::EventDefinition ) );
+
+    for ( auto & d : out.Events )
+    {
+        if ( d.NumFields > el::MaxFields )
+            return false;
+
+        // the names are printed as C strings
+        d.Name[ el::NameLength - 1 ] = 0;
+
+        for ( auto & name : d.FieldNames )
+            name[ el::NameLength - 1 ] = 0;
+    }
+
+    out.Records = reinterpret_cast< el::Record const * >( file.getData() + out.Header.HeaderSize );
+    out.NumRecords = ( file.getSize() - out.Header.HeaderSize ) / sizeof( el::Record );
+
+    return true;
+}
+
+/// @return 0 if there is no event called name.
+uint16_t
+findEvent( TelemetryFile const & t, std::string const & name )
+{
+    for ( size_t i = 0; i < t.Events.size(); ++i )
+    {
+        if ( name == t.Events[ i ].Name )
+            return static_cast< uint16_t >( i + 1 );
+    }
+
+    return 0;
+}
+
+/// @brief Records never written, e.g. after a crash, and of unknown events are skipped.
+bool
+isValid( TelemetryFile const & t, el::Record const & r )
+{
+    return r.Event != 0 && r.Event <= t.Events.size();
+}
+
+void
+writeValue( std::ostream & out, el::EventDefinition const & d, el::Record const & r, size_t field )
+{
+    if ( d.FieldTypes[ field ] == noo::logging::EFieldType::FLOAT )
+        out << r.Values[ field ].Float;
+    else
+        out << r.Values[ field ].Int;
+}
+
+void
+listEvents( TelemetryFile const & t )
+{
+    std::vector< size_t > counts( t.Events.size() + 1, 0 );
+
+    for ( size_t i = 0; i < t.NumRecords; ++i )
+    {
+        if ( isValid( t, t.Records[ i ] ) )
+            ++counts[ t.Records[ i ].Event ];
+    }
+
+    for ( size_t e = 0; e < t.Events.size(); ++e )
+    {
+        el::EventDefinition const & d = t.Events[ e ];
+
+        std::cout << d.Name << " (" << counts[ e + 1 ] << " records):";
+
+        for ( size_t f = 0; f < d.NumFields; ++f )
+            std::cout << " " << d.FieldNames[ f ] << ( d.FieldTypes[ f ] == noo::logging::EFieldType::FLOAT ? ":float" : ":int" );
+
+        std::cout << "\n";
+    }
+}
+
+void
+writeCsv( TelemetryFile const & t, uint16_t event )
+{
+    el::EventDefinition const & d = t.Events[ event - 1 ];
+
+    std::cout << "time_ms,thread";
+
+    for ( size_t f = 0; f < d.NumFields; ++f )
+        std::cout << "," << d.FieldNames[ f ];
+
+    std::cout << "\n";
+
+    for ( size_t i = 0; i < t.NumRecords; ++i )
+    {
+        el::Record const & r = t.Records[ i ];
+
+        if ( r.Event != event )
+            continue;
+
+        std::cout << r.TimeNs * 1.0e-6 << "," << r.Thread;
+
+        for ( size_t f = 0; f < d.NumFields; ++f )
+        {
+            std::cout << ",";
+            writeValue( std::cout, d, r, f );
+        }
+
+        std::cout << "\n";
+    }
+}
+
+/// @param event 0 for all events.
+void
+writeJson( TelemetryFile const & t, uint16_t event )
+{
+    for ( size_t i = 0; i < t.NumRecords; ++i )
+    {
+        el::Record const & r = t.Records[ i ];
+
+        if ( ! isValid( t, r ) || ( event != 0 && r.Event != event ) )
+            continue;
+
+        el::EventDefinition const & d = t.Events[ r.Event - 1 ];
+
+        std::cout << "{\"event\":\"" << d.Name << "\",\"time_ms\":" << r.TimeNs * 1.0e-6 << ",\"thread\":" << r.Thread;
+
+        for ( size_t f = 0; f < d.NumFields; ++f )
+        {
+            std::cout << ",\"" << d.FieldNames[ f ] << "\":";
+            writeValue( std::cout, d, r, f );
+        }
+
+        std::cout << "}\n";
+    }
+}
+
+} // - namespace
+
+
+int main( int argc, char ** argv )
+{
+    if ( argc < 2 || ( argc > 2 && std::string( argv[ 2 ] ) != "csv" && std::string( argv[ 2 ] ) != "json" ) )
+    {
+        std::cerr << "Usage: noo_telemetry <file>                 lists the events and their record counts" << std::endl;
+        std::cerr << "       noo_telemetry <file> csv <event>     writes the records of event as CSV" << std::endl;
+        std::cerr << "       noo_telemetry <file> json [<event>]  writes the records as JSON lines" << std::endl;
+        return 1;
+    }
+
+    noo::common::MappedFile file;
+    TelemetryFile telemetry;
+
+    if ( ! file.open( argv[ 1 ] ) || ! readTelemetry( file, telemetry ) )
+    {
+        std::cerr << "Could not read " << argv[ 1 ] << std::endl;
+        return 1;
+    }
+
+    if ( argc == 2 )
+    {
+        listEvents( telemetry );
+        return 0;
+    }
+
+    std::string const format = argv[ 2 ];
+    uint16_t const event = argc > 3 ? findEvent( telemetry, argv[ 3 ] ) : 0;
+
+    if ( ( argc > 3 || format == "csv" ) && event == 0 )
+    {
+        std::cerr << "No event " << ( argc > 3 ? argv[ 3 ] : "given" ) << ", see noo_telemetry " << argv[ 1 ] << std::endl;
+        return 1;
+    }
+
+    std::cout << std::setprecision( 9 );
+
+    if ( format == "csv" )
+        writeCsv( telemetry, event );
+    else
+        writeJson( telemetry, event );
+
+    return 0;
+}